@@ -0,0 +1,348 @@
+/* Copyright 2021 TrackMen GmbH <mail@trackmen.de> */
+
+// Benchmark and differential fuzzer for the ASCII "DMC01" parser.
+//
+// Built by Tools/CMakeLists.txt, or by hand (from the repository root):
+//   g++ -O2 -std=c++14 -IUE4.27/TrackMenVPCam/Source/TrackMenVPCam/Public
+//       Tools/Benchmarks/AsciiParserBenchmark.cpp
+//       UE4.27/TrackMenVPCam/Source/TrackMenVPCam/Private/TrackMenAsciiParser.cpp
+//       -o AsciiParserBenchmark
+//
+// Without arguments both parsers decode the same corpus of Euler, matrix and
+// constants datagrams and the time per datagram is reported. With --fuzz N the
+// new parser is compared against the previous std::stringstream parser on N
+// generated and randomly mutated datagrams; every accepted datagram has to
+// produce bit-identical values. The exit code is 1 on any mismatch.
+//
+// The previous parser ignored the "I<id>" prefix it checked for (">> id" failed
+// on the 'I' and the datagram was dropped). The reference below skips the 'I'
+// first, which is what the new parser does.
+
+#include "TrackMenAsciiParser.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace TrackMen;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+	static const unsigned trkEuler = 0x0001;
+
+	// The previous CameraTrackingInterface code, apart from the 'I' fix.
+	bool reference_parse_params(const char* text, size_t length, TrkCameraParams_t& tmpParams) {
+		std::stringstream ss;
+		ss.write(text, length);
+
+		if (length > 0 && text[0] == 'I') {
+			ss.get();
+			ss >> tmpParams.id;
+		}
+
+		ss >> std::hex >> tmpParams.format >> std::dec;
+		if (tmpParams.format & trkEuler) {
+			ss >> tmpParams.t.e.x
+				>> tmpParams.t.e.y
+				>> tmpParams.t.e.z
+				>> tmpParams.t.e.pan
+				>> tmpParams.t.e.tilt
+				>> tmpParams.t.e.roll;
+		}
+		else {
+			ss >> tmpParams.t.m[0][0] >> tmpParams.t.m[0][1] >> tmpParams.t.m[0][2] >> tmpParams.t.m[0][3]
+				>> tmpParams.t.m[1][0] >> tmpParams.t.m[1][1] >> tmpParams.t.m[1][2] >> tmpParams.t.m[1][3]
+				>> tmpParams.t.m[2][0] >> tmpParams.t.m[2][1] >> tmpParams.t.m[2][2] >> tmpParams.t.m[2][3];
+			tmpParams.t.m[0][3] = tmpParams.t.m[1][3] = tmpParams.t.m[2][3] = 0.0;
+			tmpParams.t.m[3][3] = 1.0;
+		}
+		ss >> tmpParams.fov >> tmpParams.centerX >> tmpParams.centerY
+			>> tmpParams.k1 >> tmpParams.k2 >> tmpParams.focdist
+			>> tmpParams.aperture >> tmpParams.counter;
+
+		return !ss.fail();
+	}
+
+	bool reference_parse_constants(const char* text, size_t length, TrkCameraConstants_t& tmpConst) {
+		std::stringstream ss;
+		ss.write(text, length);
+		ss >> tmpConst.imageWidth
+			>> tmpConst.imageHeight
+			>> tmpConst.blankLeft
+			>> tmpConst.blankRight
+			>> tmpConst.blankTop
+			>> tmpConst.blankBottom
+			>> tmpConst.chipWidth
+			>> tmpConst.chipHeight
+			>> tmpConst.fakeChipWidth
+			>> tmpConst.fakeChipHeight;
+		return !ss.fail();
+	}
+
+	// The transform is zeroed so that the matrix elements neither parser
+	// writes compare equal.
+	TrkCameraParams_t clean_params() {
+		TrkCameraParams_t params;
+		memset(&params.t, 0, sizeof(params.t));
+		return params;
+	}
+
+	bool same_params(const TrkCameraParams_t& a, const TrkCameraParams_t& b) {
+		return a.id == b.id && a.format == b.format && a.counter == b.counter
+			&& memcmp(&a.t, &b.t, sizeof(a.t)) == 0
+			&& memcmp(&a.fov, &b.fov, sizeof(double)) == 0
+			&& memcmp(&a.centerX, &b.centerX, sizeof(double)) == 0
+			&& memcmp(&a.centerY, &b.centerY, sizeof(double)) == 0
+			&& memcmp(&a.k1, &b.k1, sizeof(double)) == 0
+			&& memcmp(&a.k2, &b.k2, sizeof(double)) == 0
+			&& memcmp(&a.focdist, &b.focdist, sizeof(double)) == 0
+			&& memcmp(&a.aperture, &b.aperture, sizeof(double)) == 0;
+	}
+
+	bool same_constants(const TrkCameraConstants_t& a, const TrkCameraConstants_t& b) {
+		return a.imageWidth == b.imageWidth && a.imageHeight == b.imageHeight
+			&& a.blankLeft == b.blankLeft && a.blankRight == b.blankRight
+			&& a.blankTop == b.blankTop && a.blankBottom == b.blankBottom
+			&& memcmp(&a.chipWidth, &b.chipWidth, 4 * sizeof(double)) == 0;
+	}
+
+	class Generator {
+	public:
+		explicit Generator(uint32_t seed) : m_random(seed) {}
+
+		uint32_t next(uint32_t n) {
+			return std::uniform_int_distribution<uint32_t>(0, n - 1)(m_random);
+		}
+
+		std::string separator() {
+			static const char* separators[] = { " ", " ", " ", "  ", "\t", "\n", " \r\n", "\v\f " };
+			return separators[next(8)];
+		}
+
+		std::string number() {
+			char text[128];
+			const double magnitude = std::pow(10.0, (double)((int)next(16) - 8));
+			const double value = std::uniform_real_distribution<double>(-1.0, 1.0)(m_random) * magnitude;
+			switch (next(10)) {
+			case 0:  snprintf(text, sizeof(text), "%.17g", value); break;
+			case 1:  snprintf(text, sizeof(text), "%g", value); break;
+			case 2:  snprintf(text, sizeof(text), "%e", value); break;
+			case 3:  snprintf(text, sizeof(text), "%.3E", value); break;
+			case 4:  snprintf(text, sizeof(text), "%d", (int)next(100000) - 50000); break;
+			case 5:  snprintf(text, sizeof(text), "+%.4f", std::fabs(value)); break;
+			case 6:  snprintf(text, sizeof(text), "%.25f", value); break;
+			case 7:  snprintf(text, sizeof(text), "00%.9f", std::fabs(value)); break;
+			case 8:  snprintf(text, sizeof(text), ".%u", next(1000000)); break;
+			default: snprintf(text, sizeof(text), "%.6f", value); break;
+			}
+			return text;
+		}
+
+		std::string integer() {
+			char text[64];
+			switch (next(6)) {
+			case 0:  snprintf(text, sizeof(text), "%u", (unsigned)m_random()); break;
+			case 1:  snprintf(text, sizeof(text), "-%u", next(5000)); break;
+			case 2:  snprintf(text, sizeof(text), "000%u", next(5000)); break;
+			case 3:  snprintf(text, sizeof(text), "%llu", (unsigned long long)m_random() * 4294967296ULL); break;
+			default: snprintf(text, sizeof(text), "%u", next(5000)); break;
+			}
+			return text;
+		}
+
+		std::string params() {
+			std::string text;
+			if (next(3) == 0) {
+				text += "I";
+				text += next(2) ? " " : "";
+				text += std::to_string(next(100));
+				text += separator();
+			}
+			unsigned format = next(0x80);
+			if (next(2)) {
+				format |= trkEuler;
+			}
+			char hex[32];
+			switch (next(4)) {
+			case 0:  snprintf(hex, sizeof(hex), "0x%x", format); break;
+			case 1:  snprintf(hex, sizeof(hex), "%04X", format); break;
+			default: snprintf(hex, sizeof(hex), "%x", format); break;
+			}
+			text += hex;
+			const int values = ((format & trkEuler) ? 6 : 12) + 7;
+			for (int i = 0; i < values; ++i) {
+				text += separator() + number();
+			}
+			text += separator() + integer();
+			if (next(4) == 0) {
+				text += separator();
+			}
+			return text;
+		}
+
+		std::string constants() {
+			std::string text = integer();
+			for (int i = 0; i < 5; ++i) {
+				text += separator() + integer();
+			}
+			for (int i = 0; i < 4; ++i) {
+				text += separator() + number();
+			}
+			return text;
+		}
+
+		void mutate(std::string& text) {
+			static const char alphabet[] = " \t\n0123456789.eE+-xXIabcfF\0\x7f\xff";
+			const int mutations = (int)next(4);
+			for (int i = 0; i < mutations && !text.empty(); ++i) {
+				const size_t pos = next((uint32_t)text.size());
+				const char c = alphabet[next(sizeof(alphabet) - 1)];
+				switch (next(4)) {
+				case 0:  text[pos] = c; break;
+				case 1:  text.insert(text.begin() + pos, c); break;
+				case 2:  text.erase(pos, 1); break;
+				default: text.resize(pos); break;
+				}
+			}
+		}
+
+	private:
+		std::mt19937 m_random;
+	};
+
+	int fuzz(uint64_t iterations, uint32_t seed) {
+		Generator generator(seed);
+		uint64_t accepted = 0;
+		uint64_t mismatches = 0;
+
+		for (uint64_t i = 0; i < iterations; ++i) {
+			const bool constants = generator.next(4) == 0;
+			std::string text = constants ? generator.constants() : generator.params();
+			if (generator.next(2)) {
+				generator.mutate(text);
+			}
+
+			bool new_ok, old_ok, same;
+			if (constants) {
+				TrkCameraConstants_t a, b;
+				new_ok = parse_ascii_camera_constants(text.data(), text.size(), a);
+				old_ok = reference_parse_constants(text.data(), text.size(), b);
+				same = !new_ok || !old_ok || same_constants(a, b);
+			}
+			else {
+				TrkCameraParams_t a = clean_params();
+				TrkCameraParams_t b = clean_params();
+				new_ok = parse_ascii_camera_params(text.data(), text.size(), a);
+				old_ok = reference_parse_params(text.data(), text.size(), b);
+				same = !new_ok || !old_ok || same_params(a, b);
+			}
+
+			accepted += (new_ok && old_ok) ? 1 : 0;
+			if (new_ok != old_ok || !same) {
+				if (++mismatches <= 10) {
+					printf("mismatch (new %s, old %s, values %s): \"%s\"\n",
+						new_ok ? "accepts" : "rejects", old_ok ? "accepts" : "rejects",
+						same ? "equal" : "differ", text.c_str());
+				}
+			}
+		}
+
+		printf("fuzz: %llu datagrams, %llu accepted by both, %llu mismatches\n",
+			(unsigned long long)iterations, (unsigned long long)accepted, (unsigned long long)mismatches);
+		return mismatches ? 1 : 0;
+	}
+
+	template <typename Parse>
+	double nanoseconds_per_datagram(const std::vector<std::string>& corpus, int rounds, Parse parse) {
+		size_t accepted = 0;
+		const auto start = Clock::now();
+		for (int round = 0; round < rounds; ++round) {
+			for (const std::string& text : corpus) {
+				accepted += parse(text) ? 1 : 0;
+			}
+		}
+		const double elapsed = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+		if (accepted != corpus.size() * (size_t)rounds) {
+			printf("warning: %zu of %zu datagrams rejected\n", corpus.size() * (size_t)rounds - accepted, corpus.size() * (size_t)rounds);
+		}
+		return elapsed / (double)(corpus.size() * (size_t)rounds);
+	}
+
+	void benchmark(const char* label, const std::vector<std::string>& corpus, bool constants) {
+		const int rounds = 200;
+		double old_ns, new_ns;
+		if (constants) {
+			old_ns = nanoseconds_per_datagram(corpus, rounds, [](const std::string& text) {
+				TrkCameraConstants_t constants;
+				return reference_parse_constants(text.data(), text.size(), constants);
+			});
+			new_ns = nanoseconds_per_datagram(corpus, rounds, [](const std::string& text) {
+				TrkCameraConstants_t constants;
+				return parse_ascii_camera_constants(text.data(), text.size(), constants);
+			});
+		}
+		else {
+			old_ns = nanoseconds_per_datagram(corpus, rounds, [](const std::string& text) {
+				TrkCameraParams_t params;
+				return reference_parse_params(text.data(), text.size(), params);
+			});
+			new_ns = nanoseconds_per_datagram(corpus, rounds, [](const std::string& text) {
+				TrkCameraParams_t params;
+				return parse_ascii_camera_params(text.data(), text.size(), params);
+			});
+		}
+		printf("%-10s | stringstream %8.0f ns | new parser %6.0f ns | speedup %5.1fx\n",
+			label, old_ns, new_ns, old_ns / new_ns);
+	}
+
+	std::string tracking_datagram(std::mt19937& random, bool euler) {
+		std::uniform_real_distribution<double> position(-10.0, 10.0);
+		std::uniform_real_distribution<double> angle(-180.0, 180.0);
+		std::uniform_real_distribution<double> small(-0.1, 0.1);
+		char text[1024];
+		int n = snprintf(text, sizeof(text), "I3 %x", euler ? 0x11u : 0x10u);
+		if (euler) {
+			n += snprintf(text + n, sizeof(text) - n, " %.6f %.6f %.6f %.6f %.6f %.6f",
+				position(random), position(random), position(random), angle(random), angle(random), angle(random));
+		}
+		else {
+			for (int i = 0; i < 12; ++i) {
+				n += snprintf(text + n, sizeof(text) - n, " %.9f", small(random) * 10.0);
+			}
+		}
+		snprintf(text + n, sizeof(text) - n, " %.6f %.6f %.6f %.6f %.6f %.6f %.6f %u",
+			40.0 + small(random), small(random), small(random), small(random), small(random), 3.5, 2.8, (unsigned)random());
+		return text;
+	}
+}
+
+int main(int argc, char** argv) {
+	if (argc >= 3 && strcmp(argv[1], "--fuzz") == 0) {
+		const uint32_t seed = argc >= 4 ? (uint32_t)strtoul(argv[3], nullptr, 10) : 1;
+		return fuzz(strtoull(argv[2], nullptr, 10), seed);
+	}
+	if (argc > 1) {
+		printf("usage: %s [--fuzz iterations [seed]]\n", argv[0]);
+		return 1;
+	}
+
+	std::mt19937 random(42);
+	std::vector<std::string> euler, matrix, constants;
+	for (int i = 0; i < 1000; ++i) {
+		euler.push_back(tracking_datagram(random, true));
+		matrix.push_back(tracking_datagram(random, false));
+		constants.push_back("1920 1080 0 0 0 0 9.600000 5.400000 9.600000 5.400000");
+	}
+
+	benchmark("euler", euler, false);
+	benchmark("matrix", matrix, false);
+	benchmark("constants", constants, true);
+	return 0;
+}
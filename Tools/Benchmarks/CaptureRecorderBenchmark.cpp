@@ -0,0 +1,134 @@
+/* Copyright 2021 TrackMen GmbH <mail@trackmen.de> */
+
+// Cost of recording raw datagrams with the CaptureRecorder.
+//
+// Built by Tools/CMakeLists.txt, or by hand (Linux, from the repository root):
+//   g++ -O2 -std=c++14 -pthread -IUE4.27/TrackMenVPCam/Source/TrackMenVPCam/Public
+//       Tools/Benchmarks/CaptureRecorderBenchmark.cpp
+//       UE4.27/TrackMenVPCam/Source/TrackMenVPCam/Private/TrackMenCaptureRecorder.cpp
+//       -o CaptureRecorderBenchmark
+//
+// Records 124-byte GameEngineOpen datagrams at 1 kHz, 10 kHz or as fast as
+// possible (flood) into a temporary file. Reported are the time record()
+// takes on the calling thread, the CPU time of the whole process per second
+// of capture (receiver and writer thread) and dropped datagrams. The file is
+// read back afterwards to check every record.
+
+#include "TrackMenCaptureRecorder.h"
+
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace TrackMen;
+
+namespace {
+
+	double cpu_seconds(clockid_t clock) {
+		timespec ts;
+		clock_gettime(clock, &ts);
+		return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+	}
+
+	// Checks header, record order and payload counters of a capture.
+	bool verify(const std::string& path, uint64_t expected) {
+		std::ifstream file(path.c_str(), std::ios::binary);
+		std::vector<uint8_t> content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+		TrkCaptureHeader_t header;
+		if (!CaptureHeaderWireLayout::decode(content.data(), std::min(content.size(), CaptureHeaderWireLayout::size), header)) {
+			return false;
+		}
+
+		size_t offset = CaptureHeaderWireLayout::size;
+		uint64_t count = 0;
+		int64_t previous_ns = 0;
+		while (offset + CaptureRecordWireLayout::size <= content.size()) {
+			TrkCaptureRecord_t record;
+			CaptureRecordWireLayout::decode(content.data() + offset, CaptureRecordWireLayout::size, record);
+			offset += CaptureRecordWireLayout::size;
+
+			TrkGameEngineMessage_t message;
+			if (offset + record.length > content.size()
+				|| record.arrivalTimeNs < previous_ns
+				|| !GameEngineWireLayout::decode(content.data() + offset, record.length, message)
+				|| message.params.counter != (uint32_t)count) {
+				return false;
+			}
+			previous_ns = record.arrivalTimeNs;
+			offset += record.length;
+			++count;
+		}
+		return offset == content.size() && count == expected;
+	}
+
+	void run(const char* label, double rate, double seconds) {
+		char path[] = "/tmp/CaptureRecorderBenchmarkXXXXXX";
+		const int fd = mkstemp(path);
+		if (fd < 0) {
+			printf("cannot create a temporary file\n");
+			return;
+		}
+		::close(fd);
+
+		CaptureRecorder recorder;
+		if (!recorder.open(path)) {
+			printf("cannot open %s\n", path);
+			return;
+		}
+
+		uint8_t datagram[GameEngineWireLayout::size];
+		TrkGameEngineMessage_t message = {};
+
+		const double process_cpu_start = cpu_seconds(CLOCK_PROCESS_CPUTIME_ID);
+		const auto start = std::chrono::steady_clock::now();
+		const auto end = start + std::chrono::duration<double>(seconds);
+		uint64_t count = 0;
+		int64_t record_ns = 0;
+		for (auto now = start; now < end; now = std::chrono::steady_clock::now()) {
+			if (rate > 0.0) {
+				const auto due = start + std::chrono::duration<double>((double)count / rate);
+				if (now < due) {
+					std::this_thread::sleep_until(due);
+				}
+			}
+			message.params.counter = (uint32_t)count;
+			GameEngineWireLayout::encode(message, datagram);
+
+			const int64_t arrival_ns = steady_time_ns();
+			recorder.record(40000, arrival_ns, datagram, sizeof(datagram));
+			record_ns += steady_time_ns() - arrival_ns;
+			++count;
+		}
+		recorder.close();
+		const double process_cpu = cpu_seconds(CLOCK_PROCESS_CPUTIME_ID) - process_cpu_start;
+		const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		const uint64_t recorded = recorder.recorded_datagrams();
+		const char* file_state = recorder.dropped_datagrams() > 0 ? "file not checked, counters have gaps"
+			: verify(path, recorded) ? "file ok" : "FILE BROKEN";
+		printf("%-6s | %10llu datagrams | record() %6.0f ns | process CPU %5.1f%% of a core | dropped %llu | %s\n",
+			label, (unsigned long long)count,
+			count ? (double)record_ns / (double)count : 0.0,
+			100.0 * process_cpu / elapsed,
+			(unsigned long long)recorder.dropped_datagrams(),
+			file_state);
+		unlink(path);
+	}
+}
+
+int main(int argc, char** argv) {
+	const double seconds = argc > 1 ? atof(argv[1]) : 3.0;
+	run("1kHz", 1000.0, seconds);
+	run("10kHz", 10000.0, seconds);
+	run("flood", 0.0, seconds);
+	return 0;
+}
@@ -0,0 +1,245 @@
+/* Copyright 2021 TrackMen GmbH <mail@trackmen.de> */
+
+// Tail latency of the receive path under CPU contention, per socket and
+// thread tuning configuration.
+//
+// Built by Tools/CMakeLists.txt, it links the whole TrackMenCore library.
+//
+// Usage: ContentionBenchmark [--seconds S] [--rate datagrams/s] [--hogs N] [--port P]
+//
+// --hogs busy threads (default: two per CPU) stand in for the render and game
+// threads. A sender paces GameEngineOpen datagrams to a loopback port, and
+// every configuration below runs a CameraTrackingInterface on it the way
+// LiveLinkCameraSource does: the samples are taken in the data callback on
+// the receiver thread, or in TRK_WAKEUP_POLL mode by a push thread of its
+// own. Reported is the time from the arrival of a datagram (kernel
+// timestamp) to the push, and the datagrams that never made it.
+//
+// Real-time priorities need root or an rtprio limit (ulimit -r); without
+// them those configurations run at the default priority and say so.
+
+#include "TrackMenCameraTrackingInterface.h"
+#include "TrackMenLog.h"
+#include "TrackMenThreadSettings.h"
+#include "TrackMenWireFormat.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace TrackMen;
+
+namespace {
+
+	struct Configuration {
+		const char* label;
+		TrkTrackingOptions_t options;
+	};
+
+	std::vector<Configuration> configurations() {
+		std::vector<Configuration> result;
+		TrkTrackingOptions_t options;
+
+		result.push_back({ "shared receiver", options });
+
+		options.receiverThreading = TRK_RECEIVER_DEDICATED;
+		result.push_back({ "dedicated", options });
+
+		options.receiveBufferSize = 4 << 20;
+		result.push_back({ "4 MiB buffer", options });
+
+		options.busyPollMicroseconds = 50;
+		result.push_back({ "+ busy poll 50us", options });
+
+		options.receiveBufferSize = 0;
+		options.busyPollMicroseconds = 0;
+		options.receiverThread.priority = TRK_THREAD_PRIORITY_HIGH;
+		result.push_back({ "high", options });
+
+		options.receiverThread.priority = TRK_THREAD_PRIORITY_TIME_CRITICAL;
+		result.push_back({ "time critical", options });
+
+		options.receiverThread.affinityMask = 1;
+		result.push_back({ "+ CPU 0", options });
+
+		TrkTrackingOptions_t poll_options;
+		poll_options.wakeupMode = TRK_WAKEUP_POLL;
+		result.push_back({ "poll", poll_options });
+
+		poll_options.receiverThread.priority = TRK_THREAD_PRIORITY_TIME_CRITICAL;
+		poll_options.pushThread.priority = TRK_THREAD_PRIORITY_TIME_CRITICAL;
+		result.push_back({ "poll time critical", poll_options });
+		return result;
+	}
+
+	// Keeps one CPU busy until stopped, like a render thread that never waits.
+	void hog(const std::atomic<bool>& keep_running) {
+		volatile uint64_t sink = 0;
+		while (keep_running.load(std::memory_order_relaxed)) {
+			for (int i = 0; i < 1000; ++i) {
+				sink = sink * 6364136223846793005ull + 1442695040888963407ull;
+			}
+		}
+	}
+
+	// Latencies of the pushed samples. Filled by one push thread at a time.
+	struct PushRecord {
+		std::vector<int64_t> latency_ns;
+		std::vector<TrkCameraSample_t> samples;
+
+		PushRecord() : samples(64) { latency_ns.reserve(1 << 20); }
+
+		void drain(CameraTrackingInterface& tracking) {
+			size_t count;
+			while ((count = tracking.get_camera_samples(samples.data(), samples.size())) > 0) {
+				const int64_t now_ns = steady_time_ns();
+				for (size_t i = 0; i < count; ++i) {
+					latency_ns.push_back(now_ns - samples[i].arrivalTimeNs);
+				}
+			}
+		}
+	};
+
+	void run(const Configuration& configuration, uint16_t port, double seconds, double rate) {
+		CameraTrackingInterface tracking;
+		PushRecord record;
+		std::atomic<bool> keep_pushing{ true };
+		std::thread push_thread;
+
+		if (configuration.options.wakeupMode == TRK_WAKEUP_POLL) {
+			tracking.start_camera_tracking(port, configuration.options);
+			push_thread = std::thread([&]() {
+				while (keep_pushing) {
+					if (!tracking.got_parameters()) {
+						tracking.wait_for_data(std::chrono::milliseconds(50));
+					}
+					record.drain(tracking);
+				}
+			});
+			apply_thread_settings(push_thread, configuration.options.pushThread, "push");
+		}
+		else {
+			tracking.set_data_callback([&]() { record.drain(tracking); });
+			tracking.start_camera_tracking(port, configuration.options);
+		}
+		if (tracking.check_error() != TRK_ERROR_NO_ERROR) {
+			printf("%-20s | cannot open UDP port %u\n", configuration.label, port);
+			keep_pushing = false;
+			if (push_thread.joinable()) {
+				push_thread.join();
+			}
+			return;
+		}
+
+		const int sender = ::socket(AF_INET, SOCK_DGRAM, 0);
+		sockaddr_in address;
+		memset(&address, 0, sizeof(address));
+		address.sin_family = AF_INET;
+		address.sin_port = htons(port);
+		address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+		TrkGameEngineMessage_t message = {};
+		uint8_t datagram[GameEngineWireLayout::size];
+		const auto start = std::chrono::steady_clock::now();
+		const uint64_t count = (uint64_t)(seconds * rate);
+		uint64_t sent = 0;
+		for (uint64_t i = 0; i < count; ++i) {
+			std::this_thread::sleep_until(start + std::chrono::duration<double>((double)i / rate));
+			message.params.counter = (uint32_t)(i + 1);
+			GameEngineWireLayout::encode(message, datagram);
+			if (::sendto(sender, datagram, sizeof(datagram), 0, (const sockaddr*)&address, sizeof(address)) == (ssize_t)sizeof(datagram)) {
+				++sent;
+			}
+		}
+		::close(sender);
+
+		// Whatever is still in flight after this is lost.
+		std::this_thread::sleep_for(std::chrono::milliseconds(200));
+		tracking.stop_camera_tracking();
+		keep_pushing = false;
+		if (push_thread.joinable()) {
+			push_thread.join();
+		}
+
+		std::vector<int64_t>& latency_ns = record.latency_ns;
+		if (latency_ns.empty()) {
+			printf("%-20s | nothing received\n", configuration.label);
+			return;
+		}
+		std::sort(latency_ns.begin(), latency_ns.end());
+		const uint64_t received = (uint64_t)latency_ns.size();
+		printf("%-20s | p50 %7.1f us p99 %7.1f us p99.9 %8.1f us max %8.1f us | %llu of %llu lost\n",
+			configuration.label,
+			(double)latency_ns[latency_ns.size() / 2] * 1e-3,
+			(double)latency_ns[latency_ns.size() * 99 / 100] * 1e-3,
+			(double)latency_ns[latency_ns.size() * 999 / 1000] * 1e-3,
+			(double)latency_ns.back() * 1e-3,
+			(unsigned long long)(sent > received ? sent - received : 0), (unsigned long long)sent);
+	}
+}
+
+int main(int argc, char** argv) {
+	double seconds = 3.0;
+	double rate = 1000.0;
+	unsigned hogs = 2 * std::max(1u, std::thread::hardware_concurrency());
+	uint16_t port = 60098;
+	for (int i = 1; i < argc; ++i) {
+		const std::string arg = argv[i];
+		if (arg == "--seconds" && i + 1 < argc) {
+			seconds = atof(argv[++i]);
+		}
+		else if (arg == "--rate" && i + 1 < argc) {
+			rate = atof(argv[++i]);
+		}
+		else if (arg == "--hogs" && i + 1 < argc) {
+			hogs = (unsigned)atoi(argv[++i]);
+		}
+		else if (arg == "--port" && i + 1 < argc) {
+			port = (uint16_t)atoi(argv[++i]);
+		}
+		else {
+			printf("usage: %s [--seconds S] [--rate datagrams/s] [--hogs N] [--port P]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (rate <= 0.0) {
+		printf("--rate must be positive\n");
+		return 1;
+	}
+
+	// Warnings (a priority that cannot be set) are worth seeing, the
+	// "Receiving tracking data" lines of every run are not.
+	set_log_handler([](TrkLogLevel_t level, const char* message) {
+		if (level != TRK_LOG_DISPLAY) {
+			fprintf(stderr, "%s\n", message);
+		}
+	});
+
+	std::atomic<bool> keep_hogging{ true };
+	std::vector<std::thread> hog_threads;
+	for (unsigned i = 0; i < hogs; ++i) {
+		hog_threads.emplace_back(hog, std::cref(keep_hogging));
+	}
+	printf("%u busy threads on %u CPUs, %.0f datagrams/s for %.1f s per configuration\n",
+		hogs, std::thread::hardware_concurrency(), rate, seconds);
+
+	for (const Configuration& configuration : configurations()) {
+		run(configuration, port, seconds, rate);
+	}
+
+	keep_hogging = false;
+	for (std::thread& thread : hog_threads) {
+		thread.join();
+	}
+	return 0;
+}
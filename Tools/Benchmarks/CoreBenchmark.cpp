@@ -0,0 +1,226 @@
+/* Copyright 2021 TrackMen GmbH <mail@trackmen.de> */
+
+// Google Benchmark suite of the engine-independent tracking core.
+//
+// Built by Tools/CMakeLists.txt when Google Benchmark is installed:
+//   build/CoreBenchmark [--benchmark_filter=<regex>] [--benchmark_format=json]
+//
+// Covers the stages a datagram passes in the plugin: decoding (GameEngineOpen,
+// DMC01 binary and ASCII), the sample queue, the conversion to an Unreal
+// camera frame, and the whole path from a loopback sendto() to a converted
+// frame on the consumer side of a CameraTrackingInterface.
+
+#include "TrackMenAsciiParser.h"
+#include "TrackMenCameraConversion.h"
+#include "TrackMenCameraTrackingInterface.h"
+#include "TrackMenLog.h"
+#include "TrackMenRingBuffer.h"
+#include "TrackMenWireFormat.h"
+
+#include <benchmark/benchmark.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+using namespace TrackMen;
+
+namespace {
+
+	static const unsigned trkEuler = 0x0001;
+	static const unsigned trkFieldOfView = 0x0010;
+
+	TrkCameraParams_t euler_params() {
+		TrkCameraParams_t params;
+		params.format = trkEuler | trkFieldOfView;
+		memset(&params.t, 0, sizeof(params.t));
+		params.t.e.x = 1.25;
+		params.t.e.y = -3.5;
+		params.t.e.z = 1.7;
+		params.t.e.pan = 33.0;
+		params.t.e.tilt = -4.5;
+		params.t.e.roll = 0.75;
+		params.fov = 42.0;
+		params.counter = 1234;
+		return params;
+	}
+
+	// Camera matrix of pan 33, tilt -4.5, roll 0.75 at (1.25, -3.5, 1.7).
+	TrkCameraParams_t matrix_params() {
+		static const double DEG = 3.14159265358979323846 / 180.0;
+		const double sp = sin(-4.5 * DEG), cp = cos(-4.5 * DEG);
+		const double sy = sin(33.0 * DEG), cy = cos(33.0 * DEG);
+		const double sr = sin(0.75 * DEG), cr = cos(0.75 * DEG);
+
+		TrkCameraParams_t params = euler_params();
+		params.format = trkFieldOfView;
+		const double m[4][4] = {
+			{ cp * cy, cp * sy, sp, 0.0 },
+			{ sr * sp * cy - cr * sy, sr * sp * sy + cr * cy, -sr * cp, 0.0 },
+			{ -(cr * sp * cy + sr * sy), cy * sr - cr * sp * sy, cr * cp, 0.0 },
+			{ 1.25, -3.5, 1.7, 1.0 }
+		};
+		memcpy(params.t.m, m, sizeof(m));
+		return params;
+	}
+
+	void BM_DecodeGameEngine(benchmark::State& state) {
+		TrkGameEngineMessage_t message;
+		message.params = euler_params();
+		uint8_t datagram[GameEngineWireLayout::size];
+		GameEngineWireLayout::encode(message, datagram);
+
+		for (auto _ : state) {
+			TrkGameEngineMessage_t decoded;
+			benchmark::DoNotOptimize(GameEngineWireLayout::decode(datagram, sizeof(datagram), decoded));
+			benchmark::DoNotOptimize(decoded);
+		}
+		state.SetItemsProcessed(state.iterations());
+	}
+	BENCHMARK(BM_DecodeGameEngine);
+
+	void BM_DecodeBinaryParams(benchmark::State& state) {
+		uint8_t body[BinaryCameraParamsWireLayout::size];
+		BinaryCameraParamsWireLayout::encode(matrix_params(), body);
+
+		for (auto _ : state) {
+			TrkCameraParams_t decoded;
+			benchmark::DoNotOptimize(BinaryCameraParamsWireLayout::decode(body, sizeof(body), decoded));
+			benchmark::DoNotOptimize(decoded);
+		}
+		state.SetItemsProcessed(state.iterations());
+	}
+	BENCHMARK(BM_DecodeBinaryParams);
+
+	void BM_ParseAsciiParams(benchmark::State& state) {
+		const TrkCameraParams_t params = euler_params();
+		char body[512];
+		const int length = snprintf(body, sizeof(body),
+			"I%u %x %.6f %.6f %.6f %.6f %.6f %.6f %.6f %.6f %.6f %.6f %.6f %.6f %.6f %lu",
+			params.id, params.format, params.t.e.x, params.t.e.y, params.t.e.z,
+			params.t.e.pan, params.t.e.tilt, params.t.e.roll, params.fov,
+			params.centerX, params.centerY, params.k1, params.k2, params.focdist,
+			params.aperture, params.counter);
+
+		for (auto _ : state) {
+			TrkCameraParams_t parsed;
+			benchmark::DoNotOptimize(parse_ascii_camera_params(body, (size_t)length, parsed));
+			benchmark::DoNotOptimize(parsed);
+		}
+		state.SetItemsProcessed(state.iterations());
+		state.SetBytesProcessed(state.iterations() * length);
+	}
+	BENCHMARK(BM_ParseAsciiParams);
+
+	void BM_QueuePushPop(benchmark::State& state) {
+		SpscRingBuffer<TrkCameraSample_t> queue(64);
+		TrkCameraSample_t sample;
+		sample.params = euler_params();
+		TrkCameraSample_t popped;
+
+		for (auto _ : state) {
+			queue.push(sample);
+			queue.pop(popped);
+			benchmark::DoNotOptimize(popped);
+		}
+		state.SetItemsProcessed(state.iterations());
+	}
+	BENCHMARK(BM_QueuePushPop);
+
+	void BM_ConvertEuler(benchmark::State& state) {
+		const TrkCameraParams_t params = euler_params();
+		const TrkCameraConstants_t constants;
+		for (auto _ : state) {
+			TrkCameraFrame_t frame;
+			convert_camera_frame(params, constants, frame);
+			benchmark::DoNotOptimize(frame);
+		}
+		state.SetItemsProcessed(state.iterations());
+	}
+	BENCHMARK(BM_ConvertEuler);
+
+	void BM_ConvertMatrix(benchmark::State& state) {
+		const TrkCameraParams_t params = matrix_params();
+		const TrkCameraConstants_t constants;
+		for (auto _ : state) {
+			TrkCameraFrame_t frame;
+			convert_camera_frame(params, constants, frame);
+			benchmark::DoNotOptimize(frame);
+		}
+		state.SetItemsProcessed(state.iterations());
+	}
+	BENCHMARK(BM_ConvertMatrix);
+
+	// One GameEngineOpen datagram per iteration, sent to a loopback port and
+	// taken from the interface as a converted frame. Arg 0 is the dedicated
+	// receiver thread, 1 the shared ReceiverService.
+	void BM_EndToEndLoopback(benchmark::State& state) {
+		static const uint16_t PORT = 47611;
+
+		TrkTrackingOptions_t options;
+		options.receiverThreading = state.range(0) ? TRK_RECEIVER_SHARED : TRK_RECEIVER_DEDICATED;
+		CameraTrackingInterface tracking;
+		tracking.start_camera_tracking(PORT, options);
+		if (tracking.check_error() != TRK_ERROR_NO_ERROR) {
+			state.SkipWithError("cannot open the loopback port");
+			return;
+		}
+
+		const int sender = ::socket(AF_INET, SOCK_DGRAM, 0);
+		sockaddr_in address;
+		memset(&address, 0, sizeof(address));
+		address.sin_family = AF_INET;
+		address.sin_port = htons(PORT);
+		address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+		TrkGameEngineMessage_t message;
+		message.params = euler_params();
+		uint8_t datagram[GameEngineWireLayout::size];
+		TrkCameraSample_t sample;
+		uint32_t counter = 0;
+		uint64_t timeouts = 0;
+
+		for (auto _ : state) {
+			message.params.counter = ++counter;
+			GameEngineWireLayout::encode(message, datagram);
+			::sendto(sender, datagram, sizeof(datagram), 0, (const sockaddr*)&address, sizeof(address));
+
+			while (tracking.get_camera_samples(&sample, 1) == 0) {
+				if (!tracking.wait_for_data(std::chrono::milliseconds(100))) {
+					++timeouts;
+					break;
+				}
+			}
+			TrkCameraFrame_t frame;
+			convert_camera_frame(sample.params, tracking.get_camera_constants(), frame);
+			benchmark::DoNotOptimize(frame);
+		}
+
+		::close(sender);
+		tracking.stop_camera_tracking();
+		state.SetItemsProcessed(state.iterations());
+		state.counters["timeouts"] = (double)timeouts;
+	}
+	BENCHMARK(BM_EndToEndLoopback)->Arg(0)->Arg(1)->UseRealTime();
+}
+
+int main(int argc, char** argv) {
+	// Keep the "Receiving tracking data" lines of every run out of the table.
+	set_log_handler([](TrkLogLevel_t level, const char* message) {
+		if (level != TRK_LOG_DISPLAY) {
+			fprintf(stderr, "%s\n", message);
+		}
+	});
+
+	benchmark::Initialize(&argc, argv);
+	if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+		return 1;
+	}
+	benchmark::RunSpecifiedBenchmarks();
+	return 0;
+}
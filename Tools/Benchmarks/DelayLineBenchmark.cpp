@@ -0,0 +1,152 @@
+/* Copyright 2021 TrackMen GmbH <mail@trackmen.de> */
+
+// Cost and accuracy of the DelayLine that holds the tracking back to match
+// the video.
+//
+// Built by Tools/CMakeLists.txt, it links the whole TrackMenCore library.
+//
+// Usage: DelayLineBenchmark [--rate Hz] [--seconds S] [--capacity samples]
+//
+// A camera pans and dollies at --rate with 300 us (mean) of arrival jitter.
+// Every sample is pushed to a DelayLine and the frame "now minus delay" read
+// back, like LiveLinkCameraSource does it, for delays of 1 field, 2 frames at
+// 50 fps, 100 ms and one beyond the capacity. "switching" changes between
+// 1 and 4 frames every 0.5 s, like a delay edited while the source runs.
+// Reported are the time per push and lookup, the worst single lookup, and
+// the error against the noiseless pose at the delayed time, which is the
+// error of interpolating between samples.
+
+#include "TrackMenDelayLine.h"
+#include "TrackMenLog.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace TrackMen;
+
+namespace {
+
+	TrkCameraFrame_t pose(double t) {
+		TrkCameraFrame_t frame;
+		frame.position[0] = 200.0 * sin(t * 1.3);
+		frame.position[1] = 50.0 * sin(t * 0.7);
+		frame.position[2] = 150.0;
+		frame.yaw = std::remainder(90.0 * t, 360.0);
+		frame.pitch = 5.0 * sin(t * 2.1);
+		frame.focalLength = 35.0;
+		return frame;
+	}
+
+	struct Run {
+		const char* label;
+		int64_t delay_ns;
+		int64_t switch_delay_ns; /* alternates with delay_ns every 0.5 s if not 0 */
+	};
+
+	void run(const Run& settings, double rate, double seconds, size_t capacity) {
+		std::mt19937 random(1);
+		std::exponential_distribution<double> jitter_us(1.0 / 300.0);
+		DelayLine line(capacity);
+
+		const size_t count = (size_t)(seconds * rate);
+		std::vector<double> position_error;
+		std::vector<double> yaw_error;
+		position_error.reserve(count);
+		yaw_error.reserve(count);
+		int64_t total_ns = 0;
+		int64_t worst_ns = 0;
+		size_t exceeded = 0;
+		for (size_t i = 0; i < count; ++i) {
+			const double t = (double)i / rate;
+			const int64_t arrival_ns = (int64_t)(t * 1e9) + (int64_t)(jitter_us(random) * 1e3);
+			int64_t delay_ns = settings.delay_ns;
+			if (settings.switch_delay_ns != 0 && ((int64_t)(t * 2.0) & 1) != 0) {
+				delay_ns = settings.switch_delay_ns;
+			}
+
+			const TrkCameraFrame_t measured = pose(t);
+			TrkCameraFrame_t delayed;
+			uint32_t counter;
+			const int64_t start_ns = steady_time_ns();
+			line.push(measured, (uint32_t)i, arrival_ns);
+			const bool covered = line.sample_at(arrival_ns - delay_ns, delayed, counter);
+			const int64_t elapsed_ns = steady_time_ns() - start_ns;
+			total_ns += elapsed_ns;
+			worst_ns = std::max(worst_ns, elapsed_ns);
+			exceeded += covered ? 0 : 1;
+
+			// Arrival and measurement are one jitter apart, compare with the
+			// pose measured delay_ns before this sample.
+			const double delayed_t = t - (double)delay_ns * 1e-9;
+			if (!covered || delayed_t < 0.1) {
+				continue;
+			}
+			const TrkCameraFrame_t expected = pose(delayed_t);
+			const double dx = delayed.position[0] - expected.position[0];
+			const double dy = delayed.position[1] - expected.position[1];
+			position_error.push_back(sqrt(dx * dx + dy * dy));
+			yaw_error.push_back(std::fabs(std::remainder(delayed.yaw - expected.yaw, 360.0)));
+		}
+
+		std::sort(position_error.begin(), position_error.end());
+		std::sort(yaw_error.begin(), yaw_error.end());
+		printf("%-14s | %6.1f ns per sample, worst %7.1f us | pos cm p50 %6.3f max %6.3f | yaw deg p50 %6.3f max %6.3f | %zu beyond capacity\n",
+			settings.label, (double)total_ns / (double)count, (double)worst_ns * 1e-3,
+			position_error.empty() ? 0.0 : position_error[position_error.size() / 2],
+			position_error.empty() ? 0.0 : position_error.back(),
+			yaw_error.empty() ? 0.0 : yaw_error[yaw_error.size() / 2],
+			yaw_error.empty() ? 0.0 : yaw_error.back(), exceeded);
+	}
+}
+
+int main(int argc, char** argv) {
+	double rate = 1000.0;
+	double seconds = 10.0;
+	size_t capacity = TrkDelaySettings_t().capacity;
+	for (int i = 1; i < argc; ++i) {
+		const std::string arg = argv[i];
+		if (arg == "--rate" && i + 1 < argc) {
+			rate = atof(argv[++i]);
+		}
+		else if (arg == "--seconds" && i + 1 < argc) {
+			seconds = atof(argv[++i]);
+		}
+		else if (arg == "--capacity" && i + 1 < argc) {
+			capacity = (size_t)atoi(argv[++i]);
+		}
+		else {
+			printf("usage: %s [--rate Hz] [--seconds S] [--capacity samples]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (rate <= 0.0 || seconds * rate < 1.0) {
+		printf("need at least one sample\n");
+		return 1;
+	}
+
+	TrkDelaySettings_t field;
+	field.amount = 1.0;
+	field.unit = TRK_DELAY_FIELDS;
+	TrkDelaySettings_t frames;
+	frames.amount = 2.0;
+	frames.unit = TRK_DELAY_FRAMES;
+	const int64_t frame_ns = 20000000;
+	const int64_t beyond_ns = (int64_t)((double)capacity * 1.5e9 / rate);
+	const Run runs[] = {
+		{ "1 field", field.delay_ns(50.0), 0 },
+		{ "2 frames", frames.delay_ns(50.0), 0 },
+		{ "100 ms", 100000000, 0 },
+		{ "switching", frame_ns, 4 * frame_ns },
+		{ "beyond", beyond_ns, 0 }
+	};
+	printf("%.0f samples/s for %.1f s, %zu samples kept (%.1f ms)\n", rate, seconds, capacity, (double)capacity * 1e3 / rate);
+	for (const Run& settings : runs) {
+		run(settings, rate, seconds, capacity);
+	}
+	return 0;
+}
@@ -0,0 +1,221 @@
+/* Copyright 2021 TrackMen GmbH <mail@trackmen.de> */
+
+// Start/stop stress test of the tracking threads, like re-adding the sources
+// of a LiveLink preset over and over.
+//
+// Built by Tools/CMakeLists.txt, it links the whole TrackMenCore library.
+//
+// Usage: LifecycleBenchmark [--sources N] [--rounds R] [--port first port]
+//
+// Every round starts N CameraTrackingInterfaces on consecutive loopback
+// ports, sends each one datagram, waits until all of them delivered it and
+// stops them again. The consumers are set up the way LiveLinkCameraSource
+// does it: a data callback in event mode, a push thread of their own in the
+// legacy polling mode, stopped through interrupt_wait(). Reported are the
+// start and stop times per source and the datagrams that did not arrive
+// within a second, which would point at a source that did not come up.
+// The exit code is 1 if a source failed to start or missed its datagram.
+
+#include "TrackMenCameraTrackingInterface.h"
+#include "TrackMenLog.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace TrackMen;
+
+namespace {
+
+	/**
+	* One source as LiveLinkCameraSource runs it, reduced to counting the
+	* samples it would push.
+	*/
+	class Source {
+	public:
+		void start(uint16_t port, const TrkTrackingOptions_t& options) {
+			m_pushed = 0;
+			if (options.wakeupMode == TRK_WAKEUP_POLL) {
+				m_tracking.set_data_callback(nullptr);
+				m_tracking.start_camera_tracking(port, options);
+				m_keep_pushing.store(true);
+				m_push_thread = std::thread([this]() {
+					while (m_keep_pushing.load()) {
+						if (!m_tracking.got_parameters()) {
+							m_tracking.wait_for_data(std::chrono::milliseconds(50));
+						}
+						push();
+					}
+				});
+			}
+			else {
+				m_tracking.set_data_callback([this]() { push(); });
+				m_tracking.start_camera_tracking(port, options);
+			}
+		}
+
+		void stop() {
+			m_keep_pushing.store(false);
+			if (m_push_thread.joinable()) {
+				m_tracking.interrupt_wait();
+				m_push_thread.join();
+			}
+			m_tracking.stop_camera_tracking();
+		}
+
+		bool started() { return m_tracking.check_error() == TRK_ERROR_NO_ERROR; }
+		uint64_t pushed() const { return m_pushed.load(); }
+
+	private:
+		void push() {
+			TrkCameraSample_t samples[8];
+			size_t count;
+			while ((count = m_tracking.get_camera_samples(samples, 8)) > 0) {
+				m_pushed.fetch_add(count);
+			}
+		}
+
+		CameraTrackingInterface m_tracking;
+		std::thread m_push_thread;
+		std::atomic<bool> m_keep_pushing{ false };
+		std::atomic<uint64_t> m_pushed{ 0 };
+	};
+
+	struct Mode {
+		const char* label;
+		TrkTrackingOptions_t options;
+	};
+
+	std::vector<Mode> modes() {
+		std::vector<Mode> result;
+		TrkTrackingOptions_t options;
+		result.push_back({ "shared", options });
+
+		options.receiverThreading = TRK_RECEIVER_DEDICATED;
+		result.push_back({ "dedicated", options });
+
+		options.receiveBackend = TRK_BACKEND_IO_URING;
+		result.push_back({ "io_uring", options });
+
+		TrkTrackingOptions_t poll_options;
+		poll_options.wakeupMode = TRK_WAKEUP_POLL;
+		result.push_back({ "poll", poll_options });
+		return result;
+	}
+
+	double percentile_us(std::vector<int64_t>& values_ns, size_t numerator, size_t denominator) {
+		std::sort(values_ns.begin(), values_ns.end());
+		return (double)values_ns[(values_ns.size() - 1) * numerator / denominator] * 1e-3;
+	}
+
+	bool run(const Mode& mode, size_t source_count, int rounds, uint16_t first_port) {
+		std::vector<std::unique_ptr<Source>> sources;
+		for (size_t i = 0; i < source_count; ++i) {
+			sources.emplace_back(new Source());
+		}
+
+		const int sender = ::socket(AF_INET, SOCK_DGRAM, 0);
+		sockaddr_in address;
+		memset(&address, 0, sizeof(address));
+		address.sin_family = AF_INET;
+		address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		TrkGameEngineMessage_t message = {};
+		uint8_t datagram[GameEngineWireLayout::size];
+
+		std::vector<int64_t> start_ns;
+		std::vector<int64_t> stop_ns;
+		std::vector<int64_t> round_ns;
+		uint64_t failed_starts = 0;
+		uint64_t missing = 0;
+
+		for (int round = 0; round < rounds; ++round) {
+			const int64_t round_start_ns = steady_time_ns();
+			for (size_t i = 0; i < source_count; ++i) {
+				const int64_t begin_ns = steady_time_ns();
+				sources[i]->start((uint16_t)(first_port + i), mode.options);
+				start_ns.push_back(steady_time_ns() - begin_ns);
+				failed_starts += sources[i]->started() ? 0 : 1;
+			}
+
+			for (size_t i = 0; i < source_count; ++i) {
+				message.params.counter = (uint32_t)round + 1;
+				GameEngineWireLayout::encode(message, datagram);
+				address.sin_port = htons((uint16_t)(first_port + i));
+				::sendto(sender, datagram, sizeof(datagram), 0, (const sockaddr*)&address, sizeof(address));
+			}
+			const int64_t deadline_ns = steady_time_ns() + 1000000000;
+			for (size_t i = 0; i < source_count; ++i) {
+				while (sources[i]->pushed() == 0 && steady_time_ns() < deadline_ns) {
+					std::this_thread::sleep_for(std::chrono::microseconds(100));
+				}
+				missing += sources[i]->pushed() == 0 ? 1 : 0;
+			}
+
+			for (size_t i = 0; i < source_count; ++i) {
+				const int64_t begin_ns = steady_time_ns();
+				sources[i]->stop();
+				stop_ns.push_back(steady_time_ns() - begin_ns);
+			}
+			round_ns.push_back(steady_time_ns() - round_start_ns);
+		}
+		::close(sender);
+
+		printf("%-9s | round %8.1f ms | start p50 %7.1f us max %8.1f us | stop p50 %7.1f us p99 %8.1f us max %8.1f us | %llu failed, %llu missing\n",
+			mode.label, percentile_us(round_ns, 1, 2) * 1e-3,
+			percentile_us(start_ns, 1, 2), percentile_us(start_ns, 1, 1),
+			percentile_us(stop_ns, 1, 2), percentile_us(stop_ns, 99, 100), percentile_us(stop_ns, 1, 1),
+			(unsigned long long)failed_starts, (unsigned long long)missing);
+		return failed_starts == 0 && missing == 0;
+	}
+}
+
+int main(int argc, char** argv) {
+	size_t sources = 200;
+	int rounds = 10;
+	uint16_t first_port = 61000;
+	for (int i = 1; i < argc; ++i) {
+		const std::string arg = argv[i];
+		if (arg == "--sources" && i + 1 < argc) {
+			sources = (size_t)atoi(argv[++i]);
+		}
+		else if (arg == "--rounds" && i + 1 < argc) {
+			rounds = atoi(argv[++i]);
+		}
+		else if (arg == "--port" && i + 1 < argc) {
+			first_port = (uint16_t)atoi(argv[++i]);
+		}
+		else {
+			printf("usage: %s [--sources N] [--rounds R] [--port first port]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (sources == 0 || rounds <= 0 || first_port + sources > 65536) {
+		printf("need at least one source and round, and ports up to 65535\n");
+		return 1;
+	}
+
+	// Every start logs a line, only problems are of interest here.
+	set_log_handler([](TrkLogLevel_t level, const char* message) {
+		if (level != TRK_LOG_DISPLAY) {
+			fprintf(stderr, "%s\n", message);
+		}
+	});
+
+	printf("%zu sources, %d rounds\n", sources, rounds);
+	bool passed = true;
+	for (const Mode& mode : modes()) {
+		passed = run(mode, sources, rounds, first_port) && passed;
+	}
+	return passed ? 0 : 1;
+}
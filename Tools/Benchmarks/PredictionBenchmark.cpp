@@ -0,0 +1,387 @@
+/* Copyright 2021 TrackMen GmbH <mail@trackmen.de> */
+
+// Offline accuracy and cost of the pose prediction models.
+//
+// Built by Tools/CMakeLists.txt, it links the whole TrackMenCore library.
+//
+// Usage: PredictionBenchmark [--lead ms] [--agility a] [--rate Hz] [--smoothing] [capture file]
+//
+// The parameters of one camera (the id of the first sample) are read from a
+// capture of the plugin, decoded and converted like in LiveLinkCameraSource,
+// and fed through a PosePredictor per model in arrival order. Every
+// prediction --lead milliseconds ahead is compared to what the tracker
+// measured at that time, interpolated between the recorded samples by
+// counter. Without a file, 60 s of a handheld camera on a slow orbit with
+// zoom and focus pulls are generated at --rate with measurement noise and
+// arrival jitter, and the predictions are compared to the noiseless motion.
+// Every 10 s the generated camera comes to rest for 2 s.
+//
+// Reported per model and lead time are the RMS, 99th percentile and maximum
+// of the position error (cm), the rotation error (largest of the three
+// angles, degrees) and the focal length error (mm), and the time per
+// sample. "none" is the error of the latency that is not compensated at
+// all. For a generated recording the still jitter follows, the RMS change
+// of the output from one sample to the next while the camera rests, which
+// shows as shimmer in CG layers. With --smoothing the samples pass the
+// JitterFilter with its default settings before the prediction.
+
+#include "TrackMenAsciiParser.h"
+#include "TrackMenCameraConversion.h"
+#include "TrackMenCaptureFormat.h"
+#include "TrackMenJitterFilter.h"
+#include "TrackMenLog.h"
+#include "TrackMenPosePredictor.h"
+#include "TrackMenWireFormat.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace TrackMen;
+
+namespace {
+
+	static const double PI = 3.14159265358979323846;
+
+	struct Recording {
+		std::vector<int64_t> arrival_ns;
+		std::vector<uint32_t> counters;
+		std::vector<TrkCameraFrame_t> frames;
+		double period_s = 0.0;
+		bool synthetic = false;
+		std::vector<bool> still; /* generated samples of the camera at rest */
+	};
+
+	// The generated camera moves for 6 s of every 10, slows down within a
+	// second, rests for 2 s and speeds up again. Returns how far it got
+	// along its path by time t.
+	double motion_time(double t, bool& still) {
+		const double cycle = floor(t / 10.0);
+		const double phase = t - cycle * 10.0;
+		still = phase >= 7.0 && phase < 9.0;
+		double travelled = phase;
+		if (phase >= 9.0) {
+			const double u = phase - 9.0;
+			travelled = 6.5 + u / 2.0 - sin(PI * u) / (2.0 * PI);
+		}
+		else if (phase >= 7.0) {
+			travelled = 6.5;
+		}
+		else if (phase >= 6.0) {
+			const double u = phase - 6.0;
+			travelled = 6.0 + u / 2.0 + sin(PI * u) / (2.0 * PI);
+		}
+		return cycle * 7.0 + travelled;
+	}
+
+	// Noiseless pose of the generated camera at time t in seconds.
+	TrkCameraFrame_t synthetic_pose(double time) {
+		bool still;
+		const double t = motion_time(time, still);
+		TrkCameraFrame_t frame;
+		const double orbit = 2.0 * PI * t / 20.0;
+		frame.position[0] = -500.0 * cos(orbit) + 2.0 * sin(t * 11.3) + 0.7 * sin(t * 37.1);
+		frame.position[1] = -500.0 * sin(orbit) + 2.0 * sin(t * 13.7);
+		frame.position[2] = 170.0 + 1.5 * sin(t * 9.1) + 30.0 * sin(t * 0.7);
+		frame.pitch = -5.0 + 0.6 * sin(t * 6.1) + 3.0 * sin(t * 0.9);
+		frame.yaw = orbit * 180.0 / PI + 0.8 * sin(t * 7.9) + 0.2 * sin(t * 41.3);
+		frame.roll = 0.4 * sin(t * 5.3);
+		frame.focalLength = 35.0 + 25.0 * sin(t * 0.5);
+		frame.focusDistance = 400.0 + 250.0 * sin(t * 0.3);
+		frame.yaw = std::remainder(frame.yaw, 360.0);
+		return frame;
+	}
+
+	Recording generate(double rate, double seconds) {
+		std::mt19937 random(1);
+		std::normal_distribution<double> noise(0.0, 1.0);
+		std::exponential_distribution<double> jitter_us(1.0 / 300.0);
+
+		Recording recording;
+		recording.synthetic = true;
+		recording.period_s = 1.0 / rate;
+		const size_t count = (size_t)(seconds * rate);
+		for (size_t i = 0; i < count; ++i) {
+			const double t = (double)i / rate;
+			bool still;
+			motion_time(t, still);
+			recording.still.push_back(still);
+			TrkCameraFrame_t frame = synthetic_pose(t);
+			for (int axis = 0; axis < 3; ++axis) {
+				frame.position[axis] += 0.05 * noise(random);
+			}
+			frame.pitch += 0.01 * noise(random);
+			frame.yaw += 0.01 * noise(random);
+			frame.roll += 0.01 * noise(random);
+			frame.focalLength += 0.01 * noise(random);
+			frame.focusDistance += 1.0 * noise(random);
+			recording.arrival_ns.push_back((int64_t)(t * 1e9) + 1000000 + (int64_t)(jitter_us(random) * 1e3));
+			recording.counters.push_back((uint32_t)i + 1);
+			recording.frames.push_back(frame);
+		}
+		return recording;
+	}
+
+	// Parameters of the first camera in the capture, converted with the
+	// latest constants like in LiveLinkCameraSource.
+	bool load(const std::string& path, Recording& recording) {
+		static const size_t DMC_HEADER_SIZE = 8;
+
+		std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+		const std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+		TrkCaptureHeader_t header;
+		if (data.size() < CaptureHeaderWireLayout::size
+			|| !CaptureHeaderWireLayout::decode(data.data(), CaptureHeaderWireLayout::size, header)
+			|| header.version != TRK_CAPTURE_VERSION) {
+			return false;
+		}
+
+		TrkCameraConstants_t constants;
+		bool first = true;
+		unsigned camera_id = 0;
+		size_t offset = CaptureHeaderWireLayout::size;
+		while (offset + CaptureRecordWireLayout::size <= data.size()) {
+			TrkCaptureRecord_t record;
+			CaptureRecordWireLayout::decode(data.data() + offset, CaptureRecordWireLayout::size, record);
+			offset += CaptureRecordWireLayout::size;
+			if (offset + record.length > data.size()) {
+				break;
+			}
+			const uint8_t* datagram = data.data() + offset;
+			const size_t length = record.length;
+			offset += length;
+
+			TrkCameraParams_t params;
+			bool decoded = false;
+			if (length == GameEngineWireLayout::size && load_le<uint32_t>(datagram) == TRK_GAME_ENGINE_MAGIC) {
+				TrkGameEngineMessage_t message;
+				decoded = GameEngineWireLayout::decode(datagram, length, message);
+				params = message.params;
+				constants = message.constants;
+			}
+			else if (length >= DMC_HEADER_SIZE && memcmp(datagram, "DMC01", 5) == 0) {
+				const uint8_t* payload = datagram + DMC_HEADER_SIZE;
+				const size_t payload_length = length - DMC_HEADER_SIZE;
+				const bool binary = datagram[7] == 'B';
+				if (datagram[6] == 'C') {
+					TrkCameraConstants_t received;
+					if (binary ? BinaryCameraConstantsWireLayout::decode(payload, payload_length, received)
+						: parse_ascii_camera_constants((const char*)payload, payload_length, received)) {
+						constants = received;
+					}
+					continue;
+				}
+				decoded = binary ? BinaryCameraParamsWireLayout::decode(payload, payload_length, params)
+					: parse_ascii_camera_params((const char*)payload, payload_length, params);
+			}
+			if (!decoded || (!first && params.id != camera_id)) {
+				continue;
+			}
+			if (first) {
+				first = false;
+				camera_id = params.id;
+			}
+			// Only samples in counter order can be interpolated.
+			if (!recording.counters.empty() && (int32_t)((uint32_t)params.counter - recording.counters.back()) <= 0) {
+				continue;
+			}
+
+			TrkCameraFrame_t frame;
+			convert_camera_frame(params, constants, frame);
+			recording.arrival_ns.push_back(record.arrivalTimeNs);
+			recording.counters.push_back((uint32_t)params.counter);
+			recording.frames.push_back(frame);
+		}
+
+		if (recording.frames.size() < 3) {
+			return false;
+		}
+		const double steps = (double)(uint32_t)(recording.counters.back() - recording.counters.front());
+		recording.period_s = (double)(recording.arrival_ns.back() - recording.arrival_ns.front()) * 1e-9 / steps;
+		return true;
+	}
+
+	// What the tracker measured at counter time `at` (in periods since the
+	// first sample), false beyond the recording.
+	bool truth(const Recording& recording, double at, TrkCameraFrame_t& frame) {
+		if (recording.synthetic) {
+			frame = synthetic_pose(at * recording.period_s);
+			return at <= (double)(recording.counters.back() - recording.counters.front());
+		}
+
+		const uint32_t first = recording.counters.front();
+		const auto upper = std::upper_bound(recording.counters.begin(), recording.counters.end(), at,
+			[first](double value, uint32_t counter) { return value < (double)(uint32_t)(counter - first); });
+		if (upper == recording.counters.begin() || upper == recording.counters.end()) {
+			return false;
+		}
+		const size_t index = (size_t)(upper - recording.counters.begin());
+		const double before = (double)(uint32_t)(recording.counters[index - 1] - first);
+		const double after = (double)(uint32_t)(recording.counters[index] - first);
+		const double w = (at - before) / (after - before);
+		const TrkCameraFrame_t& a = recording.frames[index - 1];
+		const TrkCameraFrame_t& b = recording.frames[index];
+		for (int axis = 0; axis < 3; ++axis) {
+			frame.position[axis] = a.position[axis] + w * (b.position[axis] - a.position[axis]);
+		}
+		frame.pitch = a.pitch + w * std::remainder(b.pitch - a.pitch, 360.0);
+		frame.yaw = a.yaw + w * std::remainder(b.yaw - a.yaw, 360.0);
+		frame.roll = a.roll + w * std::remainder(b.roll - a.roll, 360.0);
+		frame.focalLength = a.focalLength + w * (b.focalLength - a.focalLength);
+		frame.focusDistance = a.focusDistance + w * (b.focusDistance - a.focusDistance);
+		return true;
+	}
+
+	struct Errors {
+		std::vector<double> position;
+		std::vector<double> rotation;
+		std::vector<double> focal;
+		std::vector<double> still_position;
+		std::vector<double> still_rotation;
+	};
+
+	void summarize(std::vector<double>& values, double& rms, double& p99, double& max) {
+		rms = p99 = max = 0.0;
+		if (values.empty()) {
+			return;
+		}
+		double sum = 0.0;
+		for (double value : values) {
+			sum += value * value;
+		}
+		rms = sqrt(sum / (double)values.size());
+		std::sort(values.begin(), values.end());
+		p99 = values[values.size() * 99 / 100];
+		max = values.back();
+	}
+
+	void run(const char* label, const Recording& recording, TrkPredictionModel_t model, double lead_ms, double agility, bool smoothing) {
+		TrkPredictionSettings_t settings;
+		settings.model = model;
+		settings.leadTimeMs = lead_ms;
+		settings.kalmanAgility = agility;
+		PosePredictor predictor;
+		predictor.configure(settings);
+		TrkJitterFilterSettings_t filter_settings;
+		filter_settings.enabled = smoothing;
+		JitterFilter filter;
+		filter.configure(filter_settings);
+
+		const int64_t lead_ns = (int64_t)(lead_ms * 1e6);
+		const double lead_periods = lead_ms * 1e-3 / recording.period_s;
+		const uint32_t first = recording.counters.front();
+		Errors errors;
+		std::vector<TrkCameraFrame_t> predictions(recording.frames.size());
+
+		const int64_t start_ns = steady_time_ns();
+		for (size_t i = 0; i < recording.frames.size(); ++i) {
+			predictions[i] = recording.frames[i];
+			filter.filter(predictions[i], recording.counters[i], recording.arrival_ns[i]);
+			predictor.update(predictions[i], recording.counters[i], recording.arrival_ns[i]);
+			predictor.extrapolate(predictions[i], lead_ns);
+		}
+		const double cost_ns = (double)(steady_time_ns() - start_ns) / (double)recording.frames.size();
+
+		for (size_t i = 0; i < recording.frames.size(); ++i) {
+			const TrkCameraFrame_t& predicted = predictions[i];
+			if (i > 0 && !recording.still.empty() && recording.still[i - 1] && recording.still[i]) {
+				const TrkCameraFrame_t& before = predictions[i - 1];
+				const double dx = predicted.position[0] - before.position[0];
+				const double dy = predicted.position[1] - before.position[1];
+				const double dz = predicted.position[2] - before.position[2];
+				errors.still_position.push_back(sqrt(dx * dx + dy * dy + dz * dz));
+				errors.still_rotation.push_back(std::max(std::fabs(predicted.pitch - before.pitch),
+					std::max(std::fabs(std::remainder(predicted.yaw - before.yaw, 360.0)), std::fabs(predicted.roll - before.roll))));
+			}
+
+			TrkCameraFrame_t expected;
+			if (!truth(recording, (double)(uint32_t)(recording.counters[i] - first) + lead_periods, expected)) {
+				continue;
+			}
+			const double dx = predicted.position[0] - expected.position[0];
+			const double dy = predicted.position[1] - expected.position[1];
+			const double dz = predicted.position[2] - expected.position[2];
+			errors.position.push_back(sqrt(dx * dx + dy * dy + dz * dz));
+			errors.rotation.push_back(std::max(std::fabs(std::remainder(predicted.pitch - expected.pitch, 360.0)),
+				std::max(std::fabs(std::remainder(predicted.yaw - expected.yaw, 360.0)),
+					std::fabs(std::remainder(predicted.roll - expected.roll, 360.0)))));
+			errors.focal.push_back(std::fabs(predicted.focalLength - expected.focalLength));
+		}
+
+		double position[3], rotation[3], focal[3], still_position[3], still_rotation[3];
+		summarize(errors.position, position[0], position[1], position[2]);
+		summarize(errors.rotation, rotation[0], rotation[1], rotation[2]);
+		summarize(errors.focal, focal[0], focal[1], focal[2]);
+		summarize(errors.still_position, still_position[0], still_position[1], still_position[2]);
+		summarize(errors.still_rotation, still_rotation[0], still_rotation[1], still_rotation[2]);
+		printf("%-12s %5.1f ms | pos cm rms %6.3f p99 %6.3f max %7.3f | rot deg rms %6.3f p99 %6.3f max %7.3f | focal mm rms %6.3f max %6.3f | %5.1f ns",
+			label, lead_ms, position[0], position[1], position[2], rotation[0], rotation[1], rotation[2],
+			focal[0], focal[2], cost_ns);
+		if (!errors.still_position.empty()) {
+			printf(" | still jitter %6.4f cm %6.4f deg", still_position[0], still_rotation[0]);
+		}
+		printf("\n");
+	}
+}
+
+int main(int argc, char** argv) {
+	std::vector<double> leads = { 20.0, 40.0 };
+	double agility = 1.0;
+	double rate = 50.0;
+	bool smoothing = false;
+	std::string path;
+	for (int i = 1; i < argc; ++i) {
+		const std::string arg = argv[i];
+		if (arg == "--lead" && i + 1 < argc) {
+			leads.assign(1, atof(argv[++i]));
+		}
+		else if (arg == "--agility" && i + 1 < argc) {
+			agility = atof(argv[++i]);
+		}
+		else if (arg == "--rate" && i + 1 < argc) {
+			rate = atof(argv[++i]);
+		}
+		else if (arg == "--smoothing") {
+			smoothing = true;
+		}
+		else if (arg.compare(0, 2, "--") != 0 && path.empty()) {
+			path = arg;
+		}
+		else {
+			printf("usage: %s [--lead ms] [--agility a] [--rate Hz] [--smoothing] [capture file]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (rate <= 0.0) {
+		printf("--rate must be positive\n");
+		return 1;
+	}
+
+	Recording recording;
+	if (path.empty()) {
+		recording = generate(rate, 60.0);
+		printf("generated %zu samples at %.0f Hz, compared to the noiseless motion\n", recording.frames.size(), rate);
+	}
+	else if (load(path, recording)) {
+		printf("%s: %zu samples at %.1f Hz, compared to the recorded samples\n", path.c_str(), recording.frames.size(), 1.0 / recording.period_s);
+	}
+	else {
+		printf("%s is no capture with at least 3 samples in counter order\n", path.c_str());
+		return 1;
+	}
+
+	for (double lead_ms : leads) {
+		run("none", recording, TRK_PREDICTION_NONE, lead_ms, agility, smoothing);
+		run("velocity", recording, TRK_PREDICTION_CONSTANT_VELOCITY, lead_ms, agility, smoothing);
+		run("acceleration", recording, TRK_PREDICTION_CONSTANT_ACCELERATION, lead_ms, agility, smoothing);
+		run("kalman", recording, TRK_PREDICTION_KALMAN, lead_ms, agility, smoothing);
+	}
+	return 0;
+}
@@ -0,0 +1,229 @@
+/* Copyright 2021 TrackMen GmbH <mail@trackmen.de> */
+
+// Loopback receive benchmark for the CameraTrackingInterface receive backends.
+//
+// Built by Tools/CMakeLists.txt, or by hand (Linux, from the repository root):
+//   g++ -O2 -std=c++14 -pthread -IUE4.27/TrackMenVPCam/Source/TrackMenVPCam/Public
+//       Tools/Benchmarks/ReceiveBackendBenchmark.cpp
+//       UE4.27/TrackMenVPCam/Source/TrackMenVPCam/Private/TrackMenRecvmmsgReceiveBackend.cpp
+//       UE4.27/TrackMenVPCam/Source/TrackMenVPCam/Private/TrackMenIoUringReceiveBackend.cpp
+//       -o ReceiveBackendBenchmark
+//
+// A sender thread floods 127.0.0.1 with 124-byte GameEngineOpen datagrams (or
+// paces them with --rate) while the receiver thread runs one backend. Reported
+// are received datagrams per second, receiver CPU time per datagram and the
+// mean age of a datagram when receive() returns it. With kernel timestamps
+// the age includes the time spent in the socket buffer.
+//
+// The FSocket backend needs the engine, so "recv" stands in for it here: it
+// does what FSocketBSD::Wait/Recv do on Linux, one poll() and one recv() per
+// datagram.
+
+#include "TrackMenReceiveBackend.h"
+#include "TrackMenWireFormat.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
+using namespace TrackMen;
+
+namespace {
+
+	class RecvReceiveBackend : public ReceiveBackend {
+	public:
+		~RecvReceiveBackend() override { close(); }
+		const char* name() const override { return "recv"; }
+
+		bool open(uint16_t port, const TrkTrackingOptions_t&) override {
+			m_socket = ::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+			int reuse = 1;
+			setsockopt(m_socket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+			sockaddr_in address;
+			memset(&address, 0, sizeof(address));
+			address.sin_family = AF_INET;
+			address.sin_port = htons(port);
+			return ::bind(m_socket, (const sockaddr*)&address, sizeof(address)) == 0;
+		}
+
+		void close() override {
+			if (m_socket >= 0) {
+				::close(m_socket);
+				m_socket = -1;
+			}
+		}
+
+		bool wait(std::chrono::microseconds timeout) override {
+			pollfd descriptor = { m_socket, POLLIN, 0 };
+			return ::poll(&descriptor, 1, (int)(timeout.count() / 1000)) > 0;
+		}
+
+		// The benchmark ends its receiver by the wait timeout.
+		void interrupt() override {}
+
+		size_t receive(DatagramBatch& batch) override {
+			size_t count = 0;
+			while (count < batch.capacity()) {
+				const ssize_t bytes_read = ::recv(m_socket, batch.data(count), TRK_MAX_DATAGRAM_SIZE, 0);
+				if (bytes_read <= 0) {
+					break;
+				}
+				batch.set(count, (int32_t)bytes_read, steady_time_ns());
+				++count;
+			}
+			batch.set_size(count);
+			return count;
+		}
+
+	private:
+		int m_socket = -1;
+	};
+
+	double thread_cpu_seconds() {
+		timespec ts;
+		clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+		return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+	}
+
+	void fill_game_engine_datagram(uint8_t* buffer, uint32_t counter) {
+		TrkGameEngineMessage_t message = {};
+		message.params.counter = counter;
+		GameEngineWireLayout::encode(message, buffer);
+	}
+
+	void run(ReceiveBackend& backend, uint16_t port, double seconds, double rate, size_t batch_size) {
+		TrkTrackingOptions_t options;
+		options.receiveBatchSize = batch_size;
+		if (!backend.open(port, options)) {
+			printf("%-9s cannot open port %u\n", backend.name(), port);
+			return;
+		}
+
+		std::atomic<bool> sending{ true };
+		std::atomic<uint64_t> sent{ 0 };
+		std::atomic<uint64_t> received{ 0 };
+		double receiver_cpu = 0.0;
+		double total_age_ns = 0.0;
+
+		std::thread receiver([&]() {
+			DatagramBatch batch(batch_size);
+			const double cpu_start = thread_cpu_seconds();
+			uint64_t count = 0;
+			for (;;) {
+				if (!backend.wait(std::chrono::milliseconds(20))) {
+					if (!sending) {
+						break;
+					}
+					continue;
+				}
+				size_t n;
+				while ((n = backend.receive(batch)) > 0) {
+					const int64_t now_ns = steady_time_ns();
+					for (size_t i = 0; i < n; ++i) {
+						total_age_ns += (double)(now_ns - batch.arrival_time_ns(i));
+					}
+					count += n;
+				}
+			}
+			receiver_cpu = thread_cpu_seconds() - cpu_start;
+			received = count;
+		});
+
+		std::thread sender([&]() {
+			const int sock = ::socket(AF_INET, SOCK_DGRAM, 0);
+			sockaddr_in address;
+			memset(&address, 0, sizeof(address));
+			address.sin_family = AF_INET;
+			address.sin_port = htons(port);
+			address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+			uint8_t buffer[GameEngineWireLayout::size];
+			const auto start = std::chrono::steady_clock::now();
+			const auto end = start + std::chrono::duration<double>(seconds);
+			uint64_t count = 0;
+			for (auto now = start; now < end; now = std::chrono::steady_clock::now()) {
+				if (rate > 0.0) {
+					const auto due = start + std::chrono::duration<double>((double)count / rate);
+					if (now < due) {
+						std::this_thread::sleep_until(due);
+					}
+				}
+				fill_game_engine_datagram(buffer, (uint32_t)count);
+				if (::sendto(sock, buffer, sizeof(buffer), 0, (const sockaddr*)&address, sizeof(address)) == (ssize_t)sizeof(buffer)) {
+					++count;
+				}
+			}
+			sent = count;
+			::close(sock);
+			sending = false;
+		});
+
+		sender.join();
+		receiver.join();
+		const bool kernel_timestamps = backend.kernel_timestamps();
+		backend.close();
+		const uint64_t received_count = received;
+		printf("%-9s batch %3zu | sent %9llu received %9llu (%5.1f%%) | %10.0f datagrams/s | %7.0f ns CPU/datagram | %8.1f us age (%s)\n",
+			backend.name(), batch_size,
+			(unsigned long long)sent.load(), (unsigned long long)received_count,
+			sent ? 100.0 * (double)received_count / (double)sent : 0.0,
+			(double)received_count / seconds,
+			received_count ? receiver_cpu * 1e9 / (double)received_count : 0.0,
+			received_count ? total_age_ns * 1e-3 / (double)received_count : 0.0,
+			kernel_timestamps ? "kernel" : "userspace");
+	}
+}
+
+int main(int argc, char** argv) {
+	double seconds = 2.0;
+	double rate = 0.0;
+	size_t batch_size = 32;
+	uint16_t port = 60099;
+	for (int i = 1; i < argc; ++i) {
+		const std::string arg = argv[i];
+		if (arg == "--seconds" && i + 1 < argc) {
+			seconds = atof(argv[++i]);
+		}
+		else if (arg == "--rate" && i + 1 < argc) {
+			rate = atof(argv[++i]);
+		}
+		else if (arg == "--batch" && i + 1 < argc) {
+			batch_size = (size_t)atoi(argv[++i]);
+		}
+		else if (arg == "--port" && i + 1 < argc) {
+			port = (uint16_t)atoi(argv[++i]);
+		}
+		else {
+			printf("usage: %s [--seconds S] [--rate datagrams/s, 0 = flood] [--batch N] [--port P]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	{
+		RecvReceiveBackend backend;
+		run(backend, port, seconds, rate, batch_size);
+	}
+	{
+		std::unique_ptr<ReceiveBackend> backend = create_recvmmsg_receive_backend();
+		run(*backend, port, seconds, rate, batch_size);
+	}
+	{
+		std::unique_ptr<ReceiveBackend> backend = create_io_uring_receive_backend();
+		if (backend) {
+			run(*backend, port, seconds, rate, batch_size);
+		}
+		else {
+			printf("io_uring  not supported by the kernel headers\n");
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,332 @@
+/* Copyright 2021 TrackMen GmbH <mail@trackmen.de> */
+
+// Receive path scaling with the number of tracked cameras (UDP ports).
+//
+// Built by Tools/CMakeLists.txt, or by hand (Linux, from the repository root):
+//   g++ -O2 -std=c++14 -pthread -IUE4.27/TrackMenVPCam/Source/TrackMenVPCam/Public
+//       Tools/Benchmarks/ReceiverScalingBenchmark.cpp
+//       UE4.27/TrackMenVPCam/Source/TrackMenVPCam/Private/TrackMenRecvmmsgReceiveBackend.cpp
+//       UE4.27/TrackMenVPCam/Source/TrackMenVPCam/Private/TrackMenReceiverService.cpp
+//       -o ReceiverScalingBenchmark
+//
+// One sender thread sends a 124-byte GameEngineOpen datagram to each of 1, 8,
+// 32 and 64 loopback ports at --rate Hz. Each port is received in three ways:
+//
+//   poll       legacy plugin: receiver thread sleeping 1ms, consumer 10ms
+//   dedicated  receiver thread blocking on the socket, consumer thread
+//              blocking on a DataSignal (two threads per port)
+//   shared     one ReceiverService thread for all ports, the consumer runs
+//              inline in the data callback
+//
+// Reported are the number of threads, receive-side CPU time, context switches
+// (wake-ups) per second and send-to-consumer latency. The sender's own CPU
+// time and context switches are subtracted.
+
+#include "TrackMenCameraTrackingTypes.h"
+#include "TrackMenDataSignal.h"
+#include "TrackMenReceiveBackend.h"
+#include "TrackMenReceiverService.h"
+#include "TrackMenRingBuffer.h"
+
+#include <arpa/inet.h>
+#include <dirent.h>
+#include <netinet/in.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace TrackMen;
+
+namespace {
+
+	enum Mode {
+		MODE_POLL,
+		MODE_DEDICATED,
+		MODE_SHARED
+	};
+
+	const char* mode_name(Mode mode) {
+		switch (mode) {
+		case MODE_POLL:      return "poll";
+		case MODE_DEDICATED: return "dedicated";
+		default:             return "shared";
+		}
+	}
+
+	struct Sample {
+		int64_t sentNs;
+		int64_t arrivalNs;
+	};
+
+	struct Usage {
+		double cpuSeconds = 0.0;
+		long contextSwitches = 0;
+	};
+
+	Usage get_usage(int who) {
+		rusage usage;
+		getrusage(who, &usage);
+		Usage result;
+		result.cpuSeconds = (double)(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec)
+			+ (double)(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e-6;
+		result.contextSwitches = usage.ru_nvcsw + usage.ru_nivcsw;
+		return result;
+	}
+
+	int count_threads() {
+		int count = 0;
+		DIR* dir = opendir("/proc/self/task");
+		if (dir) {
+			while (dirent* entry = readdir(dir)) {
+				if (entry->d_name[0] != '.') {
+					++count;
+				}
+			}
+			closedir(dir);
+		}
+		return count;
+	}
+
+	/**
+	* One tracked camera: socket, sample queue and consumer statistics.
+	*/
+	class Port : public ReceiverService::Client {
+	public:
+		Port(Mode mode, uint16_t port)
+			: m_mode(mode)
+			, m_queue(64)
+			, m_batch(32) {
+			TrkTrackingOptions_t options;
+			m_backend = create_recvmmsg_receive_backend();
+			m_open = m_backend->open(port, options);
+		}
+
+		bool is_open() const { return m_open; }
+
+		void start() {
+			m_running = true;
+			if (m_mode == MODE_SHARED) {
+				ReceiverService::get().add(m_backend->native_handle(), this);
+				return;
+			}
+			m_receiver = std::thread(&Port::receiver_main, this);
+			m_consumer = std::thread(&Port::consumer_main, this);
+		}
+
+		void stop() {
+			m_running = false;
+			if (m_mode == MODE_SHARED) {
+				ReceiverService::get().remove(this);
+			}
+			if (m_receiver.joinable()) {
+				m_receiver.join();
+			}
+			if (m_consumer.joinable()) {
+				m_consumer.join();
+			}
+			m_backend->close();
+		}
+
+		void on_readable() override {
+			if (receive()) {
+				consume();
+			}
+		}
+
+		uint64_t consumed() const { return m_consumed; }
+		double latency_sum_us() const { return m_latency_sum_us; }
+		double latency_max_us() const { return m_latency_max_us; }
+
+	private:
+		bool receive() {
+			bool received = false;
+			for (;;) {
+				const size_t count = m_backend->receive(m_batch);
+				for (size_t i = 0; i < count; ++i) {
+					Sample sample;
+					memcpy(&sample.sentNs, m_batch.data(i) + 16, sizeof(sample.sentNs));
+					sample.arrivalNs = m_batch.arrival_time_ns(i);
+					while (!m_queue.push(sample)) {
+						m_queue.discard_oldest();
+					}
+				}
+				received = received || count > 0;
+				if (count < m_batch.capacity()) {
+					return received;
+				}
+			}
+		}
+
+		void consume() {
+			Sample samples[64];
+			const size_t count = m_queue.pop_all(samples, 64);
+			const int64_t now = steady_time_ns();
+			for (size_t i = 0; i < count; ++i) {
+				const double latency_us = (double)(now - samples[i].sentNs) * 1e-3;
+				m_latency_sum_us += latency_us;
+				m_latency_max_us = std::max(m_latency_max_us, latency_us);
+			}
+			m_consumed += count;
+		}
+
+		void receiver_main() {
+			while (m_running) {
+				if (receive()) {
+					m_signal.notify();
+				}
+				if (m_mode == MODE_POLL) {
+					std::this_thread::sleep_for(std::chrono::milliseconds(1));
+				}
+				else {
+					m_backend->wait(std::chrono::milliseconds(50));
+				}
+			}
+		}
+
+		void consumer_main() {
+			while (m_running) {
+				if (m_mode == MODE_POLL) {
+					std::this_thread::sleep_for(std::chrono::milliseconds(10));
+				}
+				else {
+					m_signal.wait_for(std::chrono::milliseconds(50));
+				}
+				consume();
+			}
+		}
+
+		Mode m_mode;
+		bool m_open = false;
+		std::atomic<bool> m_running{ false };
+		std::unique_ptr<ReceiveBackend> m_backend;
+		SpscRingBuffer<Sample> m_queue;
+		DatagramBatch m_batch;
+		DataSignal m_signal;
+		std::thread m_receiver;
+		std::thread m_consumer;
+
+		// Written by the consumer only, read after stop().
+		uint64_t m_consumed = 0;
+		double m_latency_sum_us = 0.0;
+		double m_latency_max_us = 0.0;
+	};
+
+	void run(Mode mode, int port_count, uint16_t base_port, double rate, double seconds) {
+		std::vector<std::unique_ptr<Port>> ports;
+		for (int i = 0; i < port_count; ++i) {
+			ports.emplace_back(new Port(mode, (uint16_t)(base_port + i)));
+			if (!ports.back()->is_open()) {
+				printf("cannot open port %d\n", base_port + i);
+				return;
+			}
+		}
+		for (auto& port : ports) {
+			port->start();
+		}
+
+		// Let the threads settle before measuring.
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		const int threads = count_threads() + 1; // + sender
+		const Usage start = get_usage(RUSAGE_SELF);
+		Usage sender_usage;
+		uint64_t sent = 0;
+
+		std::thread sender([&]() {
+			const Usage sender_start = get_usage(RUSAGE_THREAD);
+			const int sock = ::socket(AF_INET, SOCK_DGRAM, 0);
+			sockaddr_in address;
+			memset(&address, 0, sizeof(address));
+			address.sin_family = AF_INET;
+			address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+			uint8_t buffer[124] = {};
+			const uint32_t magic = 0x544d4531;
+			memcpy(buffer, &magic, sizeof(magic));
+
+			const auto begin = std::chrono::steady_clock::now();
+			const uint64_t ticks = (uint64_t)(rate * seconds);
+			for (uint64_t tick = 0; tick < ticks; ++tick) {
+				std::this_thread::sleep_until(begin + std::chrono::duration<double>((double)tick / rate));
+				for (int i = 0; i < port_count; ++i) {
+					const int64_t now = steady_time_ns();
+					memcpy(buffer + 16, &now, sizeof(now));
+					address.sin_port = htons((uint16_t)(base_port + i));
+					if (::sendto(sock, buffer, sizeof(buffer), 0, (const sockaddr*)&address, sizeof(address)) > 0) {
+						++sent;
+					}
+				}
+			}
+			::close(sock);
+			const Usage sender_end = get_usage(RUSAGE_THREAD);
+			sender_usage.cpuSeconds = sender_end.cpuSeconds - sender_start.cpuSeconds;
+			sender_usage.contextSwitches = sender_end.contextSwitches - sender_start.contextSwitches;
+		});
+		sender.join();
+
+		// Give the consumers time to pick up the last samples.
+		std::this_thread::sleep_for(std::chrono::milliseconds(60));
+		const Usage end = get_usage(RUSAGE_SELF);
+
+		for (auto& port : ports) {
+			port->stop();
+		}
+
+		uint64_t consumed = 0;
+		double latency_sum_us = 0.0;
+		double latency_max_us = 0.0;
+		for (auto& port : ports) {
+			consumed += port->consumed();
+			latency_sum_us += port->latency_sum_us();
+			latency_max_us = std::max(latency_max_us, port->latency_max_us());
+		}
+
+		const double elapsed = seconds + 0.06;
+		const double cpu = end.cpuSeconds - start.cpuSeconds - sender_usage.cpuSeconds;
+		const long switches = end.contextSwitches - start.contextSwitches - sender_usage.contextSwitches;
+		printf("%-9s %3d ports | %3d threads | %6.1f ms CPU/s | %8.0f wakeups/s | %8llu/%-8llu samples | latency mean %7.1f us max %8.1f us\n",
+			mode_name(mode), port_count, threads,
+			cpu * 1e3 / elapsed, (double)switches / elapsed,
+			(unsigned long long)consumed, (unsigned long long)sent,
+			consumed ? latency_sum_us / (double)consumed : 0.0, latency_max_us);
+	}
+}
+
+int main(int argc, char** argv) {
+	double rate = 100.0;
+	double seconds = 2.0;
+	uint16_t base_port = 61000;
+	for (int i = 1; i < argc; ++i) {
+		const std::string arg = argv[i];
+		if (arg == "--rate" && i + 1 < argc) {
+			rate = atof(argv[++i]);
+		}
+		else if (arg == "--seconds" && i + 1 < argc) {
+			seconds = atof(argv[++i]);
+		}
+		else if (arg == "--port" && i + 1 < argc) {
+			base_port = (uint16_t)atoi(argv[++i]);
+		}
+		else {
+			printf("usage: %s [--rate Hz per port] [--seconds S] [--port first port]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	const int port_counts[] = { 1, 8, 32, 64 };
+	const Mode modes[] = { MODE_POLL, MODE_DEDICATED, MODE_SHARED };
+	for (int port_count : port_counts) {
+		for (Mode mode : modes) {
+			run(mode, port_count, base_port, rate, seconds);
+		}
+	}
+	return 0;
+}
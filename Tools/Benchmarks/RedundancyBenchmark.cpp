@@ -0,0 +1,217 @@
+/* Copyright 2021 TrackMen GmbH <mail@trackmen.de> */
+
+// Redundant receive paths: one stream sent over two links, merged by tracker
+// counter.
+//
+// Built by Tools/CMakeLists.txt, it links the whole TrackMenCore library.
+//
+// Usage: RedundancyBenchmark [--seconds S] [--rate datagrams/s] [--spike us] [--port P]
+//
+// A sender produces GameEngineOpen samples at --rate and sends every one to
+// the loopback ports P and P + 1, each copy delayed like on a link of its own:
+// a few tens of microseconds, and on 2% of the datagrams a spike of up to
+// --spike microseconds. The primary link is pulled for the middle fifth of
+// the run. The same schedule is received once on P alone and once on P with
+// P + 1 as backup port. Reported is the time from the production of a sample
+// to its push, the samples that never arrived, the longest gap between two
+// pushed counters and, with the backup, which path delivered first.
+
+#include "TrackMenCameraTrackingInterface.h"
+#include "TrackMenLog.h"
+#include "TrackMenWireFormat.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace TrackMen;
+
+namespace {
+
+	struct Send {
+		int64_t due_ns;   /* relative to the start of the run */
+		uint32_t counter;
+		size_t path;
+	};
+
+	// Both copies of every counter, in sending order.
+	std::vector<Send> schedule(double seconds, double rate, double spike_us, uint32_t seed) {
+		std::mt19937 random(seed);
+		std::uniform_real_distribution<double> chance(0.0, 1.0);
+		std::exponential_distribution<double> base_us(1.0 / 30.0);
+
+		const uint32_t count = (uint32_t)(seconds * rate);
+		const uint32_t pull_begin = count * 2 / 5;
+		const uint32_t pull_end = count * 3 / 5;
+		std::vector<Send> sends;
+		sends.reserve(2 * (size_t)count);
+		for (uint32_t i = 0; i < count; ++i) {
+			const double produced_us = (double)i * 1e6 / rate;
+			for (size_t path = 0; path < 2; ++path) {
+				if (path == 0 && i >= pull_begin && i < pull_end) {
+					continue;
+				}
+				double delay_us = 20.0 + base_us(random);
+				if (chance(random) < 0.02) {
+					delay_us += chance(random) * spike_us;
+				}
+				sends.push_back({ (int64_t)((produced_us + delay_us) * 1e3), i + 1, path });
+			}
+		}
+		std::sort(sends.begin(), sends.end(), [](const Send& a, const Send& b) { return a.due_ns < b.due_ns; });
+		return sends;
+	}
+
+	// Pushed samples, filled on the receiver thread through the data callback.
+	struct PushRecord {
+		std::vector<int64_t> push_ns;
+		std::vector<uint32_t> counters;
+		std::vector<TrkCameraSample_t> samples;
+
+		PushRecord() : samples(64) {
+			push_ns.reserve(1 << 20);
+			counters.reserve(1 << 20);
+		}
+
+		void drain(CameraTrackingInterface& tracking) {
+			size_t count;
+			while ((count = tracking.get_camera_samples(samples.data(), samples.size())) > 0) {
+				const int64_t now_ns = steady_time_ns();
+				for (size_t i = 0; i < count; ++i) {
+					push_ns.push_back(now_ns);
+					counters.push_back((uint32_t)samples[i].params.counter);
+				}
+			}
+		}
+	};
+
+	void run(const char* label, bool backup, const std::vector<Send>& sends, double rate, uint16_t port) {
+		TrkTrackingOptions_t options;
+		options.receiverThreading = TRK_RECEIVER_DEDICATED;
+		options.backupPort = backup ? (uint16_t)(port + 1) : 0;
+
+		CameraTrackingInterface tracking;
+		PushRecord record;
+		tracking.set_data_callback([&]() { record.drain(tracking); });
+		tracking.start_camera_tracking(port, options);
+		if (tracking.check_error() != TRK_ERROR_NO_ERROR) {
+			printf("%-16s | cannot open UDP port %u\n", label, port);
+			return;
+		}
+
+		const int sender = ::socket(AF_INET, SOCK_DGRAM, 0);
+		sockaddr_in address;
+		memset(&address, 0, sizeof(address));
+		address.sin_family = AF_INET;
+		address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+		TrkGameEngineMessage_t message = {};
+		uint8_t datagram[GameEngineWireLayout::size];
+		const int64_t start_ns = steady_time_ns() + 10000000;
+		for (const Send& send : sends) {
+			const int64_t wait_ns = start_ns + send.due_ns - steady_time_ns();
+			if (wait_ns > 0) {
+				std::this_thread::sleep_for(std::chrono::nanoseconds(wait_ns));
+			}
+			message.params.counter = send.counter;
+			GameEngineWireLayout::encode(message, datagram);
+			address.sin_port = htons((uint16_t)(port + send.path));
+			::sendto(sender, datagram, sizeof(datagram), 0, (const sockaddr*)&address, sizeof(address));
+		}
+		::close(sender);
+
+		std::this_thread::sleep_for(std::chrono::milliseconds(100));
+		tracking.stop_camera_tracking();
+
+		if (record.counters.empty()) {
+			printf("%-16s | nothing received\n", label);
+			return;
+		}
+		std::vector<int64_t> latency_ns;
+		latency_ns.reserve(record.counters.size());
+		uint32_t longest_gap = 0;
+		for (size_t i = 0; i < record.counters.size(); ++i) {
+			const int64_t produced_ns = start_ns + (int64_t)((double)(record.counters[i] - 1) * 1e9 / rate);
+			latency_ns.push_back(record.push_ns[i] - produced_ns);
+			if (i > 0) {
+				longest_gap = std::max(longest_gap, record.counters[i] - record.counters[i - 1]);
+			}
+		}
+		std::sort(latency_ns.begin(), latency_ns.end());
+
+		uint32_t produced = 0;
+		for (const Send& send : sends) {
+			produced = std::max(produced, send.counter);
+		}
+		printf("%-16s | p50 %7.1f us p99 %7.1f us p99.9 %7.1f us max %8.1f us | %5llu of %llu lost | longest gap %6.1f ms\n",
+			label,
+			(double)latency_ns[latency_ns.size() / 2] * 1e-3,
+			(double)latency_ns[latency_ns.size() * 99 / 100] * 1e-3,
+			(double)latency_ns[latency_ns.size() * 999 / 1000] * 1e-3,
+			(double)latency_ns.back() * 1e-3,
+			(unsigned long long)(produced - std::min<uint32_t>(produced, (uint32_t)record.counters.size())),
+			(unsigned long long)produced, (double)longest_gap * 1e3 / rate);
+
+		for (size_t path = 0; backup && path < tracking.receive_path_count(); ++path) {
+			const TrkPathStatistics_t statistics = tracking.get_path_statistics(path);
+			printf("  %-7s path | %7llu datagrams, first %5.1f%%, %7llu duplicates, mean lead %6.1f us\n",
+				path == 0 ? "primary" : "backup", (unsigned long long)statistics.datagrams,
+				100.0 * (double)statistics.firstArrivals / (double)std::max<uint64_t>(1, statistics.datagrams),
+				(unsigned long long)statistics.duplicates,
+				(double)statistics.leadNs * 1e-3 / (double)std::max<uint64_t>(1, statistics.firstArrivals));
+		}
+	}
+}
+
+int main(int argc, char** argv) {
+	double seconds = 5.0;
+	double rate = 1000.0;
+	double spike_us = 2000.0;
+	uint16_t port = 60120;
+	for (int i = 1; i < argc; ++i) {
+		const std::string arg = argv[i];
+		if (arg == "--seconds" && i + 1 < argc) {
+			seconds = atof(argv[++i]);
+		}
+		else if (arg == "--rate" && i + 1 < argc) {
+			rate = atof(argv[++i]);
+		}
+		else if (arg == "--spike" && i + 1 < argc) {
+			spike_us = atof(argv[++i]);
+		}
+		else if (arg == "--port" && i + 1 < argc) {
+			port = (uint16_t)atoi(argv[++i]);
+		}
+		else {
+			printf("usage: %s [--seconds S] [--rate datagrams/s] [--spike us] [--port P]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (rate <= 0.0 || seconds * rate < 10.0 || port == 65535) {
+		printf("need at least 10 samples and a port below 65535\n");
+		return 1;
+	}
+
+	set_log_handler([](TrkLogLevel_t level, const char* message) {
+		if (level != TRK_LOG_DISPLAY) {
+			fprintf(stderr, "%s\n", message);
+		}
+	});
+
+	const std::vector<Send> sends = schedule(seconds, rate, spike_us, 1);
+	printf("%.0f samples/s for %.1f s to UDP ports %u and %u, 2%% spikes up to %.0f us, primary pulled for %.1f s\n",
+		rate, seconds, port, port + 1, spike_us, seconds / 5.0);
+	run("primary only", false, sends, rate, port);
+	run("primary + backup", true, sends, rate, port);
+	return 0;
+}
@@ -0,0 +1,212 @@
+/* Copyright 2021 TrackMen GmbH <mail@trackmen.de> */
+
+// Headless replay of tracking captures through the datagram decoders.
+//
+// Built by Tools/CMakeLists.txt, or by hand (Linux, from the repository root):
+//   g++ -O2 -std=c++14 -pthread -IUE4.27/TrackMenVPCam/Source/TrackMenVPCam/Public
+//       Tools/Benchmarks/ReplayBenchmark.cpp
+//       UE4.27/TrackMenVPCam/Source/TrackMenVPCam/Private/TrackMenReplayReceiveBackend.cpp
+//       UE4.27/TrackMenVPCam/Source/TrackMenVPCam/Private/TrackMenAsciiParser.cpp
+//       -o ReplayBenchmark
+//
+// Usage: ReplayBenchmark [capture file]
+//
+// Without a file, a capture of 1 kHz GameEngineOpen and binary DMC01
+// datagrams is generated in /tmp. The capture is replayed at recorded speed,
+// reporting how late datagrams come out of receive() relative to their due
+// time, and as fast as possible, reporting decoded datagrams per second. The
+// datagrams are classified and decoded like in
+// CameraTrackingInterface::handle_datagram; converting and pushing to
+// LiveLink needs the engine and is not part of this.
+
+#include "TrackMenAsciiParser.h"
+#include "TrackMenCaptureFormat.h"
+#include "TrackMenReceiveBackend.h"
+#include "TrackMenWireFormat.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace TrackMen;
+
+namespace {
+
+	struct DecodeCounts {
+		uint64_t datagrams = 0;
+		uint64_t params = 0;
+		uint64_t constants = 0;
+		uint64_t rejected = 0;
+	};
+
+	void decode(const uint8_t* buffer, int32_t length, DecodeCounts& counts) {
+		static const int32_t PUBLIC_HEADER_SIZE = 8;
+		++counts.datagrams;
+
+		if (length == (int32_t)GameEngineWireLayout::size && load_le<uint32_t>(buffer) == TRK_GAME_ENGINE_MAGIC) {
+			TrkGameEngineMessage_t message;
+			GameEngineWireLayout::decode(buffer, (size_t)length, message) ? ++counts.params : ++counts.rejected;
+			return;
+		}
+		if (length < PUBLIC_HEADER_SIZE || memcmp(buffer, "DMC01", 5) != 0) {
+			++counts.rejected;
+			return;
+		}
+
+		const uint8_t* payload = buffer + PUBLIC_HEADER_SIZE;
+		const size_t payload_length = (size_t)(length - PUBLIC_HEADER_SIZE);
+		const bool binary = buffer[7] == 'B';
+		if (buffer[6] == 'C') {
+			TrkCameraConstants_t constants;
+			const bool ok = binary ? BinaryCameraConstantsWireLayout::decode(payload, payload_length, constants)
+				: parse_ascii_camera_constants((const char*)payload, payload_length, constants);
+			ok ? ++counts.constants : ++counts.rejected;
+		}
+		else {
+			TrkCameraParams_t params;
+			const bool ok = binary ? BinaryCameraParamsWireLayout::decode(payload, payload_length, params)
+				: parse_ascii_camera_params((const char*)payload, payload_length, params);
+			ok ? ++counts.params : ++counts.rejected;
+		}
+	}
+
+	void append(std::vector<uint8_t>& capture, uint16_t port, int64_t arrival_ns, const uint8_t* data, size_t length) {
+		TrkCaptureRecord_t record;
+		record.arrivalTimeNs = arrival_ns;
+		record.length = (uint32_t)length;
+		record.port = port;
+		const size_t offset = capture.size();
+		capture.resize(offset + CaptureRecordWireLayout::size + length);
+		CaptureRecordWireLayout::encode(record, &capture[offset]);
+		memcpy(&capture[offset + CaptureRecordWireLayout::size], data, length);
+	}
+
+	// Writes a capture of `seconds` at 1 kHz, alternating GameEngineOpen and
+	// binary DMC01 parameter datagrams with a constants datagram every second.
+	// Written directly rather than through a CaptureRecorder, which would drop
+	// datagrams that come faster than the disk takes them.
+	bool generate(const std::string& path, double seconds) {
+		std::vector<uint8_t> capture(CaptureHeaderWireLayout::size);
+		TrkCaptureHeader_t header;
+		header.startSteadyNs = steady_time_ns();
+		CaptureHeaderWireLayout::encode(header, capture.data());
+
+		uint8_t datagram[TRK_MAX_DATAGRAM_SIZE];
+		const uint64_t count = (uint64_t)(seconds * 1000.0);
+		for (uint64_t i = 0; i < count; ++i) {
+			const int64_t arrival_ns = header.startSteadyNs + (int64_t)i * 1000000;
+			if (i % 1000 == 0) {
+				TrkCameraConstants_t constants = {};
+				memcpy(datagram, "DMC01\0CB", 8);
+				BinaryCameraConstantsWireLayout::encode(constants, datagram + 8);
+				append(capture, 40000, arrival_ns, datagram, 8 + BinaryCameraConstantsWireLayout::size);
+			}
+			if (i % 2 == 0) {
+				TrkGameEngineMessage_t message = {};
+				message.params.counter = (uint32_t)i;
+				GameEngineWireLayout::encode(message, datagram);
+				append(capture, 40000, arrival_ns, datagram, GameEngineWireLayout::size);
+			}
+			else {
+				TrkCameraParams_t params = {};
+				params.counter = (uint32_t)i;
+				memcpy(datagram, "DMC01\0PB", 8);
+				BinaryCameraParamsWireLayout::encode(params, datagram + 8);
+				append(capture, 40001, arrival_ns, datagram, 8 + BinaryCameraParamsWireLayout::size);
+			}
+		}
+
+		std::ofstream file(path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+		return (bool)file.write((const char*)capture.data(), (std::streamsize)capture.size());
+	}
+
+	void run(const char* label, const std::string& path, double speed, double max_seconds) {
+		TrkTrackingOptions_t options;
+		options.receiveBackend = TRK_BACKEND_REPLAY;
+		options.replayFile = path;
+		options.replaySpeed = speed;
+
+		std::unique_ptr<ReceiveBackend> backend = create_replay_receive_backend();
+		if (!backend->open(0, options)) {
+			printf("%-8s | cannot replay %s\n", label, path.c_str());
+			return;
+		}
+
+		DatagramBatch batch(64);
+		DecodeCounts counts;
+		std::vector<int64_t> lateness_ns;
+		const int64_t start_ns = steady_time_ns();
+		const int64_t end_ns = start_ns + (int64_t)(max_seconds * 1e9);
+		int idle_waits = 0;
+		while (steady_time_ns() < end_ns && idle_waits < 2) {
+			if (!backend->wait(std::chrono::milliseconds(100))) {
+				++idle_waits;
+				continue;
+			}
+			const size_t count = backend->receive(batch);
+			idle_waits = count > 0 ? 0 : idle_waits + 1;
+			const int64_t now_ns = steady_time_ns();
+			for (size_t i = 0; i < count; ++i) {
+				if (speed > 0.0) {
+					lateness_ns.push_back(now_ns - batch.arrival_time_ns(i));
+				}
+				decode(batch.data(i), batch.length(i), counts);
+			}
+		}
+		const double elapsed = (double)(steady_time_ns() - start_ns) * 1e-9;
+		backend->close();
+
+		printf("%-8s | %9llu datagrams | %7llu params %5llu constants %3llu rejected",
+			label, (unsigned long long)counts.datagrams, (unsigned long long)counts.params,
+			(unsigned long long)counts.constants, (unsigned long long)counts.rejected);
+		if (lateness_ns.empty()) {
+			printf(" | %12.0f datagrams/s\n", (double)counts.datagrams / elapsed);
+			return;
+		}
+		std::sort(lateness_ns.begin(), lateness_ns.end());
+		printf(" | late p50 %5.0f us p99 %5.0f us max %5.0f us\n",
+			(double)lateness_ns[lateness_ns.size() / 2] * 1e-3,
+			(double)lateness_ns[lateness_ns.size() * 99 / 100] * 1e-3,
+			(double)lateness_ns.back() * 1e-3);
+	}
+}
+
+int main(int argc, char** argv) {
+	std::string path;
+	bool generated = false;
+	if (argc > 1) {
+		path = argv[1];
+	}
+	else {
+		char name[] = "/tmp/ReplayBenchmarkXXXXXX";
+		const int fd = mkstemp(name);
+		if (fd < 0) {
+			printf("cannot create a temporary file\n");
+			return 1;
+		}
+		::close(fd);
+		path = name;
+		if (!generate(path, 60.0)) {
+			printf("cannot write %s\n", path.c_str());
+			unlink(path.c_str());
+			return 1;
+		}
+		generated = true;
+	}
+
+	// The timed replays only play the first seconds of long captures.
+	run("1x", path, 1.0, 3.0);
+	run("10x", path, 10.0, 3.0);
+	run("max", path, 0.0, 60.0);
+
+	if (generated) {
+		unlink(path.c_str());
+	}
+	return 0;
+}
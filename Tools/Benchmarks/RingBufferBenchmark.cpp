@@ -0,0 +1,252 @@
+/* Copyright 2021 TrackMen GmbH <mail@trackmen.de> */
+
+// Compares the lock-free SpscRingBuffer used by CameraTrackingInterface with
+// the previous std::deque + std::mutex sample queue.
+//
+// Built by Tools/CMakeLists.txt, or by hand (Linux, from the repository root):
+//   g++ -O2 -std=c++14 -pthread -IUE4.27/TrackMenVPCam/Source/TrackMenVPCam/Public
+//       Tools/Benchmarks/RingBufferBenchmark.cpp -o RingBufferBenchmark
+//
+// One producer thread pushes TrkCameraParams_t samples at 100 Hz, 1 kHz or as
+// fast as possible (flood) while one consumer thread drains the queue. Reported
+// are per-call push/pop latencies, enqueue-to-dequeue latency and throughput.
+//
+// The "evict" run floods a small ring the way CameraTrackingInterface does
+// with TRK_OVERFLOW_DROP_OLDEST: a full ring evicts its oldest item instead of
+// waiting. Every sample carries a checksum of its bytes, a popped sample that
+// was overwritten while being copied, or one that comes out of order, fails
+// the run (exit code 1).
+
+#include "TrackMenCameraTrackingTypes.h"
+#include "TrackMenRingBuffer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace TrackMen;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+	int64_t now_ns() {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+	}
+
+	struct TimedSample {
+		TrkCameraParams_t params;
+		int64_t enqueue_ns = 0;
+	};
+
+	// The queue as it was used by CameraTrackingInterface before the ring buffer.
+	class DequeMutexQueue {
+	public:
+		explicit DequeMutexQueue(size_t) {}
+		bool push(const TimedSample& item) {
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_container.push_back(item);
+			return true;
+		}
+		bool pop(TimedSample& item) {
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (m_container.empty()) {
+				return false;
+			}
+			item = m_container.front();
+			m_container.pop_front();
+			return true;
+		}
+	private:
+		std::deque<TimedSample> m_container;
+		std::mutex m_mutex;
+	};
+
+	uint64_t checksum(const TrkCameraParams_t& params) {
+		// FNV-1a
+		const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&params);
+		uint64_t hash = 14695981039346656037ull;
+		for (size_t i = 0; i < sizeof(params); ++i) {
+			hash = (hash ^ bytes[i]) * 1099511628211ull;
+		}
+		return hash;
+	}
+
+	struct Percentiles {
+		double p50 = 0.0, p99 = 0.0, max = 0.0;
+	};
+
+	Percentiles percentiles(std::vector<int64_t>& values) {
+		Percentiles result;
+		if (values.empty()) {
+			return result;
+		}
+		std::sort(values.begin(), values.end());
+		result.p50 = (double)values[values.size() / 2];
+		result.p99 = (double)values[std::min(values.size() - 1, (values.size() * 99) / 100)];
+		result.max = (double)values.back();
+		return result;
+	}
+
+	struct Scenario {
+		const char* name;
+		double rate_hz; // 0 = flood
+		size_t samples;
+	};
+
+	template <typename Queue>
+	void run(const char* queue_name, const Scenario& scenario) {
+		Queue queue(256);
+		std::vector<int64_t> push_ns, pop_ns, latency_ns;
+		push_ns.reserve(scenario.samples);
+		pop_ns.reserve(scenario.samples);
+		latency_ns.reserve(scenario.samples);
+
+		size_t full_retries = 0;
+
+		const int64_t start_ns = now_ns();
+
+		std::thread consumer([&]() {
+			TimedSample sample;
+			size_t received = 0;
+			while (received < scenario.samples) {
+				const int64_t before = now_ns();
+				if (queue.pop(sample)) {
+					const int64_t after = now_ns();
+					pop_ns.push_back(after - before);
+					latency_ns.push_back(after - sample.enqueue_ns);
+					++received;
+				}
+				else {
+					std::this_thread::yield();
+				}
+			}
+		});
+
+		std::thread producer([&]() {
+			TimedSample sample;
+			const int64_t period_ns = scenario.rate_hz > 0.0 ? (int64_t)(1e9 / scenario.rate_hz) : 0;
+			int64_t next_ns = now_ns();
+			for (size_t i = 0; i < scenario.samples; ++i) {
+				if (period_ns > 0) {
+					next_ns += period_ns;
+					while (now_ns() < next_ns) {
+						std::this_thread::sleep_for(std::chrono::microseconds(50));
+					}
+				}
+				sample.params.counter = (unsigned long)i;
+				for (;;) {
+					const int64_t before = now_ns();
+					sample.enqueue_ns = before;
+					const bool pushed = queue.push(sample);
+					const int64_t after = now_ns();
+					if (pushed) {
+						push_ns.push_back(after - before);
+						break;
+					}
+					++full_retries;
+					std::this_thread::yield();
+				}
+			}
+		});
+
+		producer.join();
+		consumer.join();
+		const double seconds = (double)(now_ns() - start_ns) * 1e-9;
+
+		const Percentiles push = percentiles(push_ns);
+		const Percentiles pop = percentiles(pop_ns);
+		const Percentiles latency = percentiles(latency_ns);
+
+		printf("%-8s %-12s push p50 %6.0f p99 %7.0f max %8.0f | pop p50 %6.0f p99 %7.0f | e2e p50 %8.0f p99 %9.0f ns | %8.3f Mops/s | full %zu\n",
+			scenario.name, queue_name,
+			push.p50, push.p99, push.max,
+			pop.p50, pop.p99,
+			latency.p50, latency.p99,
+			(double)scenario.samples / seconds * 1e-6,
+			full_retries);
+	}
+
+	bool run_evicting(size_t samples) {
+		struct CheckedSample {
+			TrkCameraParams_t params;
+			uint64_t check;
+		};
+		SpscRingBuffer<CheckedSample> queue(4);
+		std::atomic<bool> done{ false };
+		size_t dropped = 0;
+		size_t popped = 0;
+		size_t torn = 0;
+		size_t reordered = 0;
+
+		std::thread consumer([&]() {
+			CheckedSample sample;
+			unsigned long last = 0;
+			for (;;) {
+				const bool finished = done.load(std::memory_order_acquire);
+				if (!queue.pop(sample)) {
+					if (finished) {
+						break;
+					}
+					std::this_thread::yield();
+					continue;
+				}
+				++popped;
+				torn += checksum(sample.params) != sample.check ? 1 : 0;
+				reordered += (popped > 1 && sample.params.counter <= last) ? 1 : 0;
+				last = sample.params.counter;
+			}
+		});
+
+		CheckedSample sample;
+		for (size_t i = 1; i <= samples; ++i) {
+			memset(&sample.params, (int)(i * 31), sizeof(sample.params));
+			sample.params.counter = (unsigned long)i;
+			sample.check = checksum(sample.params);
+			while (!queue.push(sample)) {
+				dropped += queue.discard_oldest();
+			}
+		}
+		done.store(true, std::memory_order_release);
+		consumer.join();
+
+		printf("evict    spsc ring    popped %zu dropped %zu | torn %zu reordered %zu\n", popped, dropped, torn, reordered);
+		return torn == 0 && reordered == 0 && popped + dropped == samples;
+	}
+}
+
+int main(int argc, char** argv) {
+	double seconds = 2.0;
+	size_t flood_samples = 2000000;
+	for (int i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+			seconds = atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--flood-samples") == 0 && i + 1 < argc) {
+			flood_samples = (size_t)atoll(argv[++i]);
+		}
+		else {
+			printf("usage: %s [--seconds S] [--flood-samples N]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	const Scenario scenarios[] = {
+		{ "100Hz", 100.0, (size_t)(100.0 * seconds) },
+		{ "1kHz", 1000.0, (size_t)(1000.0 * seconds) },
+		{ "flood", 0.0, flood_samples },
+	};
+
+	printf("sample size %zu bytes\n", sizeof(TimedSample));
+	for (const Scenario& scenario : scenarios) {
+		run<DequeMutexQueue>("deque+mutex", scenario);
+		run<SpscRingBuffer<TimedSample>>("spsc ring", scenario);
+	}
+	return run_evicting(flood_samples) ? 0 : 1;
+}
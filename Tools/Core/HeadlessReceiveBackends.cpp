@@ -0,0 +1,13 @@
+/* Copyright 2021 TrackMen GmbH <mail@trackmen.de> */
+
+// Stands in for TrackMenFSocketReceiveBackend.cpp in headless builds, engine
+// sockets need the editor. TRK_BACKEND_AUTO picks recvmmsg on Linux anyway.
+
+#include "TrackMenReceiveBackend.h"
+
+namespace TrackMen {
+
+	std::unique_ptr<ReceiveBackend> create_fsocket_receive_backend() {
+		return nullptr;
+	}
+}
@@ -0,0 +1,462 @@
+/* Copyright 2021 TrackMen GmbH <mail@trackmen.de> */
+
+// Synthetic tracking stream for load tests without a tracker.
+//
+// Built by Tools/CMakeLists.txt, or by hand (Linux, from the repository root):
+//   g++ -O2 -std=c++14 -IUE4.27/TrackMenVPCam/Source/TrackMenVPCam/Public
+//       Tools/TrafficGenerator/TrafficGenerator.cpp -o TrafficGenerator
+//
+// Sends GameEngineOpen and DMC01 binary or ASCII datagrams for a number of
+// cameras to one or more UDP ports. Every camera has its own counter and is
+// sent to port + (camera index % ports), so several LiveLink sources can be
+// fed at once. Loss and reordering are injected per datagram: a lost datagram
+// still uses up its counter value, a reordered one is held back and sent
+// right after the next datagram of the same camera. Run without arguments
+// for 1 camera at 1 kHz on 127.0.0.1:40000; --help lists the options.
+//
+// Datagrams are built with the same wire layouts the plugin decodes, so
+// anything the plugin rejects points at the receive path, not the generator.
+
+#include "TrackMenWireFormat.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace TrackMen;
+
+namespace {
+
+	static const unsigned trkEuler = 0x0001;
+	static const size_t DMC_HEADER_SIZE = 8;
+	static const size_t MAX_BATCH = 64;
+	static const size_t MAX_DATAGRAM_SIZE = 1472; /* one Ethernet frame */
+
+	enum Format {
+		FORMAT_GAME_ENGINE,
+		FORMAT_BINARY,
+		FORMAT_ASCII,
+		FORMAT_MIXED
+	};
+
+	enum Motion {
+		MOTION_STATIC, /* camera does not move */
+		MOTION_ORBIT,  /* circles the origin looking at it, one turn per 10 s */
+		MOTION_SHAKE,  /* handheld: small fast position and rotation noise */
+		MOTION_JUMP    /* cuts to a new position every 2 s */
+	};
+
+	struct Settings {
+		std::string host = "127.0.0.1";
+		std::string multicastInterface; /* IPv4 address of the interface multicast is sent on */
+		uint16_t port = 40000;
+		unsigned ports = 1;
+		unsigned cameras = 1;
+		double rate = 1000.0; /* datagrams per second and camera */
+		double seconds = 0.0; /* 0 runs until killed */
+		Format format = FORMAT_GAME_ENGINE;
+		Motion motion = MOTION_ORBIT;
+		double loss = 0.0;
+		double reorder = 0.0;
+		uint32_t seed = 1;
+	};
+
+	struct Datagram {
+		uint16_t port = 0;
+		size_t length = 0;
+		uint8_t data[MAX_DATAGRAM_SIZE];
+	};
+
+	struct Camera {
+		unsigned id = 0;
+		uint16_t port = 0;
+		uint32_t counter = 0;
+		double phase = 0.0;
+		bool has_held = false;
+		Datagram held;
+	};
+
+	struct Counters {
+		uint64_t sent = 0;
+		uint64_t lost = 0;
+		uint64_t reordered = 0;
+		uint64_t errors = 0;
+	};
+
+	void print_usage() {
+		printf("TrafficGenerator [options]\n"
+			"  --host <address>     destination, unicast or multicast group, default 127.0.0.1\n"
+			"  --interface <addr>   IPv4 address of the interface to send multicast on\n"
+			"  --port <port>        first destination port, default 40000\n"
+			"  --ports <n>          cameras are spread over n consecutive ports, default 1\n"
+			"  --cameras <n>        number of cameras, default 1\n"
+			"  --rate <hz>          datagrams per second and camera, default 1000\n"
+			"  --seconds <s>        run time, default until killed\n"
+			"  --format <f>         gameengine, binary, ascii or mixed, default gameengine\n"
+			"  --motion <m>         static, orbit, shake or jump, default orbit\n"
+			"  --loss <p>           probability a datagram is not sent, default 0\n"
+			"  --reorder <p>        probability a datagram is swapped with the next, default 0\n"
+			"  --seed <n>           random seed, default 1\n");
+	}
+
+	bool parse_arguments(int argc, char** argv, Settings& settings) {
+		for (int i = 1; i < argc; ++i) {
+			const std::string name = argv[i];
+			if (name == "--help" || name == "-h" || i + 1 >= argc) {
+				return false;
+			}
+			const char* value = argv[++i];
+			if (name == "--host") settings.host = value;
+			else if (name == "--interface") settings.multicastInterface = value;
+			else if (name == "--port") settings.port = (uint16_t)atoi(value);
+			else if (name == "--ports") settings.ports = (unsigned)atoi(value);
+			else if (name == "--cameras") settings.cameras = (unsigned)atoi(value);
+			else if (name == "--rate") settings.rate = atof(value);
+			else if (name == "--seconds") settings.seconds = atof(value);
+			else if (name == "--loss") settings.loss = atof(value);
+			else if (name == "--reorder") settings.reorder = atof(value);
+			else if (name == "--seed") settings.seed = (uint32_t)strtoul(value, nullptr, 10);
+			else if (name == "--format") {
+				const std::string format = value;
+				if (format == "gameengine") settings.format = FORMAT_GAME_ENGINE;
+				else if (format == "binary") settings.format = FORMAT_BINARY;
+				else if (format == "ascii") settings.format = FORMAT_ASCII;
+				else if (format == "mixed") settings.format = FORMAT_MIXED;
+				else return false;
+			}
+			else if (name == "--motion") {
+				const std::string motion = value;
+				if (motion == "static") settings.motion = MOTION_STATIC;
+				else if (motion == "orbit") settings.motion = MOTION_ORBIT;
+				else if (motion == "shake") settings.motion = MOTION_SHAKE;
+				else if (motion == "jump") settings.motion = MOTION_JUMP;
+				else return false;
+			}
+			else {
+				return false;
+			}
+		}
+		return settings.ports > 0 && settings.cameras > 0 && settings.rate > 0.0;
+	}
+
+	// Euler pose of a camera at time t. Positions in meters, angles in degrees.
+	TrkCameraParams_t pose(Motion motion, const Camera& camera, double t) {
+		static const double PI = 3.14159265358979323846;
+
+		TrkCameraParams_t params;
+		params.id = camera.id;
+		params.format = trkEuler;
+		memset(&params.t, 0, sizeof(params.t));
+		params.t.e.z = 1.7;
+		params.fov = 40.0;
+		params.counter = camera.counter;
+
+		const double angle = 2.0 * PI * (t / 10.0) + camera.phase;
+		switch (motion) {
+		case MOTION_STATIC:
+			params.t.e.x = -5.0 * cos(camera.phase);
+			params.t.e.y = -5.0 * sin(camera.phase);
+			params.t.e.pan = camera.phase * 180.0 / PI;
+			break;
+		case MOTION_ORBIT:
+			params.t.e.x = -5.0 * cos(angle);
+			params.t.e.y = -5.0 * sin(angle);
+			params.t.e.pan = angle * 180.0 / PI;
+			params.t.e.tilt = -5.0 + 3.0 * sin(angle * 3.0);
+			params.fov = 40.0 + 15.0 * sin(angle * 0.5);
+			break;
+		case MOTION_SHAKE:
+			params.t.e.x = 0.02 * sin(t * 11.3 + camera.phase) + 0.007 * sin(t * 37.1);
+			params.t.e.y = -3.0 + 0.02 * sin(t * 13.7 + camera.phase);
+			params.t.e.z = 1.6 + 0.015 * sin(t * 9.1);
+			params.t.e.pan = 90.0 + 0.8 * sin(t * 7.9 + camera.phase) + 0.2 * sin(t * 41.3);
+			params.t.e.tilt = 0.6 * sin(t * 6.1);
+			params.t.e.roll = 0.4 * sin(t * 5.3 + camera.phase);
+			break;
+		case MOTION_JUMP: {
+			const double shot = floor(t / 2.0);
+			params.t.e.x = 2.0 * cos(shot * 2.4 + camera.phase);
+			params.t.e.y = 2.0 * sin(shot * 1.7 + camera.phase);
+			params.t.e.pan = fmod(shot * 77.0, 360.0) - 180.0;
+			params.fov = 25.0 + fmod(shot * 13.0, 40.0);
+			break;
+		}
+		}
+		return params;
+	}
+
+	TrkCameraConstants_t constants_for(const Camera& camera) {
+		TrkCameraConstants_t constants;
+		constants.id = camera.id;
+		return constants;
+	}
+
+	void write_dmc_header(uint8_t* data, char type, char format) {
+		memcpy(data, "DMC01", 5);
+		data[5] = 0;
+		data[6] = (uint8_t)type;
+		data[7] = (uint8_t)format;
+	}
+
+	void encode_params(Format format, const TrkCameraParams_t& params, Datagram& datagram) {
+		switch (format) {
+		case FORMAT_GAME_ENGINE: {
+			TrkGameEngineMessage_t message;
+			message.params = params;
+			GameEngineWireLayout::encode(message, datagram.data);
+			datagram.length = GameEngineWireLayout::size;
+			break;
+		}
+		case FORMAT_BINARY:
+			write_dmc_header(datagram.data, 'P', 'B');
+			BinaryCameraParamsWireLayout::encode(params, datagram.data + DMC_HEADER_SIZE);
+			datagram.length = DMC_HEADER_SIZE + BinaryCameraParamsWireLayout::size;
+			break;
+		default: {
+			write_dmc_header(datagram.data, 'P', 'A');
+			const int written = snprintf((char*)datagram.data + DMC_HEADER_SIZE, MAX_DATAGRAM_SIZE - DMC_HEADER_SIZE,
+				"I%u %x %.6f %.6f %.6f %.6f %.6f %.6f %.6f %.6f %.6f %.6f %.6f %.6f %.6f %lu",
+				params.id, params.format,
+				params.t.e.x, params.t.e.y, params.t.e.z, params.t.e.pan, params.t.e.tilt, params.t.e.roll,
+				params.fov, params.centerX, params.centerY, params.k1, params.k2,
+				params.focdist, params.aperture, params.counter);
+			datagram.length = DMC_HEADER_SIZE + (size_t)written;
+			break;
+		}
+		}
+	}
+
+	// GameEngineOpen carries the chip size in every datagram, the DMC01
+	// formats send constants separately.
+	bool encode_constants(Format format, const TrkCameraConstants_t& constants, Datagram& datagram) {
+		if (format == FORMAT_GAME_ENGINE) {
+			return false;
+		}
+		if (format == FORMAT_BINARY) {
+			write_dmc_header(datagram.data, 'C', 'B');
+			BinaryCameraConstantsWireLayout::encode(constants, datagram.data + DMC_HEADER_SIZE);
+			datagram.length = DMC_HEADER_SIZE + BinaryCameraConstantsWireLayout::size;
+			return true;
+		}
+		write_dmc_header(datagram.data, 'C', 'A');
+		const int written = snprintf((char*)datagram.data + DMC_HEADER_SIZE, MAX_DATAGRAM_SIZE - DMC_HEADER_SIZE,
+			"%d %d %d %d %d %d %.6f %.6f %.6f %.6f",
+			constants.imageWidth, constants.imageHeight,
+			constants.blankLeft, constants.blankRight, constants.blankTop, constants.blankBottom,
+			constants.chipWidth, constants.chipHeight, constants.fakeChipWidth, constants.fakeChipHeight);
+		datagram.length = DMC_HEADER_SIZE + (size_t)written;
+		return true;
+	}
+
+	/**
+	* Collects datagrams and sends them with one sendmmsg() call.
+	*/
+	class Sender {
+	public:
+		Sender(int socket, in_addr host)
+			: m_socket(socket)
+			, m_datagrams(MAX_BATCH)
+			, m_addresses(MAX_BATCH)
+			, m_iovecs(MAX_BATCH)
+			, m_messages(MAX_BATCH) {
+			for (size_t i = 0; i < MAX_BATCH; ++i) {
+				m_addresses[i].sin_family = AF_INET;
+				m_addresses[i].sin_addr = host;
+			}
+		}
+
+		void add(const Datagram& datagram, Counters& counters) {
+			if (m_size == MAX_BATCH) {
+				flush(counters);
+			}
+			m_datagrams[m_size] = datagram;
+			++m_size;
+		}
+
+		void flush(Counters& counters) {
+			for (size_t i = 0; i < m_size; ++i) {
+				m_addresses[i].sin_port = htons(m_datagrams[i].port);
+				m_iovecs[i].iov_base = m_datagrams[i].data;
+				m_iovecs[i].iov_len = m_datagrams[i].length;
+				memset(&m_messages[i], 0, sizeof(mmsghdr));
+				m_messages[i].msg_hdr.msg_name = &m_addresses[i];
+				m_messages[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+				m_messages[i].msg_hdr.msg_iov = &m_iovecs[i];
+				m_messages[i].msg_hdr.msg_iovlen = 1;
+			}
+
+			size_t done = 0;
+			while (done < m_size) {
+				const int sent = sendmmsg(m_socket, &m_messages[done], (unsigned)(m_size - done), 0);
+				if (sent <= 0) {
+					// Skip the datagram the kernel refused, e.g. ECONNREFUSED
+					// from an ICMP error of an earlier datagram.
+					++counters.errors;
+					++done;
+					continue;
+				}
+				counters.sent += (uint64_t)sent;
+				done += (size_t)sent;
+			}
+			m_size = 0;
+		}
+
+	private:
+		int m_socket;
+		size_t m_size = 0;
+		std::vector<Datagram> m_datagrams;
+		std::vector<sockaddr_in> m_addresses;
+		std::vector<iovec> m_iovecs;
+		std::vector<mmsghdr> m_messages;
+	};
+}
+
+int main(int argc, char** argv) {
+	Settings settings;
+	if (!parse_arguments(argc, argv, settings)) {
+		print_usage();
+		return 1;
+	}
+
+	in_addr host;
+	if (inet_pton(AF_INET, settings.host.c_str(), &host) != 1) {
+		printf("invalid host %s\n", settings.host.c_str());
+		return 1;
+	}
+	const int udp_socket = ::socket(AF_INET, SOCK_DGRAM, 0);
+	if (udp_socket < 0) {
+		printf("cannot create a socket\n");
+		return 1;
+	}
+	int send_buffer = 4 << 20;
+	setsockopt(udp_socket, SOL_SOCKET, SO_SNDBUF, &send_buffer, sizeof(send_buffer));
+
+	if (IN_MULTICAST(ntohl(host.s_addr))) {
+		// Local receivers on the same host get a copy, a TTL above 1 lets
+		// the stream cross one router.
+		unsigned char loop = 1;
+		unsigned char ttl = 2;
+		setsockopt(udp_socket, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop));
+		setsockopt(udp_socket, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl));
+		in_addr multicast_interface;
+		if (!settings.multicastInterface.empty()) {
+			if (inet_pton(AF_INET, settings.multicastInterface.c_str(), &multicast_interface) != 1
+				|| setsockopt(udp_socket, IPPROTO_IP, IP_MULTICAST_IF, &multicast_interface, sizeof(multicast_interface)) != 0) {
+				printf("cannot send multicast on %s\n", settings.multicastInterface.c_str());
+				return 1;
+			}
+		}
+	}
+
+	std::vector<Camera> cameras(settings.cameras);
+	for (unsigned i = 0; i < settings.cameras; ++i) {
+		cameras[i].id = i + 1;
+		cameras[i].port = (uint16_t)(settings.port + i % settings.ports);
+		cameras[i].phase = 2.0 * 3.14159265358979323846 * i / settings.cameras;
+	}
+
+	printf("%u camera(s) at %.0f Hz to %s:%u-%u, loss %.3f, reorder %.3f\n",
+		settings.cameras, settings.rate, settings.host.c_str(),
+		settings.port, settings.port + std::min(settings.ports, settings.cameras) - 1,
+		settings.loss, settings.reorder);
+
+	std::mt19937 random(settings.seed);
+	std::uniform_real_distribution<double> chance(0.0, 1.0);
+	Sender sender(udp_socket, host);
+	Counters counters;
+	Counters reported;
+	Datagram datagram;
+
+	typedef std::chrono::steady_clock Clock;
+	const Clock::time_point start = Clock::now();
+	Clock::time_point next_report = start + std::chrono::seconds(1);
+	const double period = 1.0 / settings.rate;
+	uint64_t tick = 0;
+
+	for (;;) {
+		// Ticks are scheduled from the start, a late tick is sent right away
+		// so the average rate holds. After a long stall the backlog is
+		// dropped instead of sent as one burst.
+		const Clock::time_point due = start + std::chrono::duration_cast<Clock::duration>(
+			std::chrono::duration<double>((double)tick * period));
+		Clock::time_point now = Clock::now();
+		if (now < due) {
+			sender.flush(counters);
+			std::this_thread::sleep_until(due);
+			now = Clock::now();
+		}
+		else if (now - due > std::chrono::seconds(1)) {
+			tick = (uint64_t)(std::chrono::duration<double>(now - start).count() / period);
+			continue;
+		}
+
+		const double t = (double)tick * period;
+		if (settings.seconds > 0.0 && t >= settings.seconds) {
+			break;
+		}
+
+		for (Camera& camera : cameras) {
+			Format format = settings.format;
+			if (format == FORMAT_MIXED) {
+				format = (Format)((camera.counter + camera.id) % FORMAT_MIXED);
+			}
+			datagram.port = camera.port;
+
+			// Once per second, and before the first parameters.
+			if (camera.counter % (uint32_t)std::max(1.0, settings.rate) == 0
+				&& encode_constants(format, constants_for(camera), datagram)) {
+				sender.add(datagram, counters);
+			}
+
+			encode_params(format, pose(settings.motion, camera, t), datagram);
+			++camera.counter;
+
+			if (chance(random) < settings.loss) {
+				++counters.lost;
+				continue;
+			}
+			if (!camera.has_held && chance(random) < settings.reorder) {
+				camera.held = datagram;
+				camera.has_held = true;
+				++counters.reordered;
+				continue;
+			}
+			sender.add(datagram, counters);
+			if (camera.has_held) {
+				sender.add(camera.held, counters);
+				camera.has_held = false;
+			}
+		}
+		++tick;
+
+		if (now >= next_report) {
+			sender.flush(counters);
+			printf("%10llu datagrams/s | lost %llu | reordered %llu | send errors %llu\n",
+				(unsigned long long)(counters.sent - reported.sent),
+				(unsigned long long)(counters.lost - reported.lost),
+				(unsigned long long)(counters.reordered - reported.reordered),
+				(unsigned long long)(counters.errors - reported.errors));
+			fflush(stdout);
+			reported = counters;
+			next_report += std::chrono::seconds(1);
+		}
+	}
+
+	sender.flush(counters);
+	printf("sent %llu datagrams, lost %llu, reordered %llu, send errors %llu\n",
+		(unsigned long long)counters.sent, (unsigned long long)counters.lost,
+		(unsigned long long)counters.reordered, (unsigned long long)counters.errors);
+	::close(udp_socket);
+	return 0;
+}
@@ -3,6 +3,7 @@
 #include "ITrackMenVPCamModule.h"
 #include "CoreMinimal.h"
 #include "PluginLogging.h"
+#include "TrackMenLog.h"
 
 
 class FTrackMenVPCamModule : public TrackMen::ITrackMenVPCamModule {
@@ -12,10 +13,21 @@ class FTrackMenVPCamModule : public TrackMen::ITrackMenVPCamModule {
 
 IMPLEMENT_MODULE(FTrackMenVPCamModule, TrackMenVPCam)
 
+// Messages of the engine-independent tracking core.
+static void LogTrackingCoreMessage(TrackMen::TrkLogLevel_t level, const char* message) {
+	switch (level) {
+	case TrackMen::TRK_LOG_ERROR:   UE_LOG(LogTrackMenPlugin, Error, TEXT("%s"), UTF8_TO_TCHAR(message));   break;
+	case TrackMen::TRK_LOG_WARNING: UE_LOG(LogTrackMenPlugin, Warning, TEXT("%s"), UTF8_TO_TCHAR(message)); break;
+	default:                        UE_LOG(LogTrackMenPlugin, Display, TEXT("%s"), UTF8_TO_TCHAR(message)); break;
+	}
+}
+
 void FTrackMenVPCamModule::StartupModule() {
+	TrackMen::set_log_handler(&LogTrackingCoreMessage);
 	UE_LOG(LogTrackMenPlugin, Display, TEXT("TrackMen: StartupModule"));
 }
 
 void FTrackMenVPCamModule::ShutdownModule() {
 	UE_LOG(LogTrackMenPlugin, Display, TEXT("TrackMen: ShutdownModule"));
+	TrackMen::set_log_handler(nullptr);
 }
@@ -2,33 +2,282 @@
 
 #include "LiveLinkCameraSource.h"
 #include "PluginLogging.h"
+#include "TrackMenCameraConversion.h"
+#include "TrackMenThreadSettings.h"
 #include "UTrackMenCameraRole.h"
 #include "Misc/App.h"
 #include <chrono>
 #include <functional>
 
+#define LOCTEXT_NAMESPACE "TrackMenLiveLinkCameraSource"
+
 namespace TrackMen {
 
-	static FTrackMenCameraFrameData GetCameraFrameFromTrkData(const TrkCameraParams_t& params,
-		const TrkCameraConstants_t& constants, const FFrameRate& frameRate);
+	static FTrackMenCameraFrameData GetCameraFrameFromTrkData(const TrkCameraFrame_t& converted, uint32 counter,
+		const FFrameRate& frameRate, double arrivalTime);
 
-	LiveLinkCameraSource::LiveLinkCameraSource(const FText& InSourceType, const FText& InSourceMachineName, uint16_t port)
+	LiveLinkCameraSource::LiveLinkCameraSource(const FText& InSourceType, const FText& InSourceMachineName, uint16_t port,
+		const TrkTrackingOptions_t& options)
 		: sourceType(InSourceType)
 		, sourceMachineName(InSourceMachineName)
-		, udpPort(port) {
+		, udpPort(port)
+		, trackingOptions(options)
+		, delaySettings(options.delay) {
+		UpdateDelay();
+	}
+
+	// Connection string keys of a tracking thread, see CameraSourceFactory.
+	static FString ThreadSettingsToConnectionString(const TrkThreadSettings_t& settings, const TCHAR* priorityKey, const TCHAR* cpusKey) {
+		FString result;
+		if (settings.priority != TRK_THREAD_PRIORITY_DEFAULT) {
+			result += FString::Printf(TEXT(" %s%s"), priorityKey,
+				settings.priority == TRK_THREAD_PRIORITY_HIGH ? TEXT("High") : TEXT("TimeCritical"));
+		}
+		if (settings.affinityMask != 0) {
+			result += FString::Printf(TEXT(" %s0x%llx"), cpusKey, (unsigned long long)settings.affinityMask);
+		}
+		return result;
 	}
 
 	void LiveLinkCameraSource::InitializeSettings(ULiveLinkSourceSettings* Settings) {
 		// Save UDP port in connection string for recreation from presets.
-		Settings->ConnectionString = FString::FromInt(udpPort);
+		Settings->ConnectionString = BuildConnectionString();
+		UTrackMenLiveLinkSourceSettings* trackMenSettings = Cast<UTrackMenLiveLinkSourceSettings>(Settings);
+		if (trackMenSettings != nullptr) {
+			trackMenSettings->FromTrackingOptions(udpPort, trackingOptions, delaySettings);
+		}
+	}
+
+	// Connection string keys, see CameraSourceFactory.
+	FString LiveLinkCameraSource::BuildConnectionString() const {
+		FString connectionString = FString::FromInt(udpPort);
+		if (!trackingOptions.multicastGroup.empty()) {
+			connectionString += FString(TEXT(" MulticastGroup=")) + UTF8_TO_TCHAR(trackingOptions.multicastGroup.c_str());
+		}
+		if (!trackingOptions.multicastSource.empty()) {
+			connectionString += FString(TEXT(" MulticastSource=")) + UTF8_TO_TCHAR(trackingOptions.multicastSource.c_str());
+		}
+		if (!trackingOptions.multicastInterface.empty()) {
+			connectionString += FString(TEXT(" MulticastInterface=")) + UTF8_TO_TCHAR(trackingOptions.multicastInterface.c_str());
+		}
+		if (trackingOptions.queueDepth != TrkTrackingOptions_t().queueDepth) {
+			connectionString += FString::Printf(TEXT(" QueueDepth=%d"), (int32)trackingOptions.queueDepth);
+		}
+		if (trackingOptions.queueMode != TRK_QUEUE_FIFO) {
+			connectionString += TEXT(" QueueMode=LatestOnly");
+		}
+		if (trackingOptions.overflowPolicy != TRK_OVERFLOW_DROP_OLDEST) {
+			static const TCHAR* const overflowPolicies[] = { TEXT("DropOldest"), TEXT("KeepLatest"), TEXT("Block") };
+			connectionString += FString::Printf(TEXT(" Overflow=%s"), overflowPolicies[trackingOptions.overflowPolicy]);
+		}
+		if (trackingOptions.sequencePolicy != TRK_SEQUENCE_COUNT_ONLY) {
+			static const TCHAR* const sequencePolicies[] = { TEXT("CountOnly"), TEXT("DropLate"), TEXT("Reorder") };
+			connectionString += FString::Printf(TEXT(" Sequence=%s"), sequencePolicies[trackingOptions.sequencePolicy]);
+			if (trackingOptions.sequencePolicy == TRK_SEQUENCE_REORDER) {
+				connectionString += FString::Printf(TEXT(" ReorderWindow=%d"), (int32)trackingOptions.reorderWindow);
+			}
+		}
+		if (trackingOptions.receiveBackend != TRK_BACKEND_AUTO && trackingOptions.receiveBackend != TRK_BACKEND_REPLAY) {
+			static const TCHAR* const backends[] = { TEXT("Auto"), TEXT("FSocket"), TEXT("Recvmmsg"), TEXT("IoUring") };
+			connectionString += FString::Printf(TEXT(" Backend=%s"), backends[trackingOptions.receiveBackend]);
+		}
+		if (trackingOptions.receiveBufferSize > 0) {
+			connectionString += FString::Printf(TEXT(" ReceiveBuffer=%d"), trackingOptions.receiveBufferSize);
+		}
+		if (trackingOptions.busyPollMicroseconds > 0) {
+			connectionString += FString::Printf(TEXT(" BusyPoll=%d"), trackingOptions.busyPollMicroseconds);
+		}
+		connectionString += ThreadSettingsToConnectionString(trackingOptions.receiverThread, TEXT("ReceiverPriority="), TEXT("ReceiverCpus="));
+		connectionString += ThreadSettingsToConnectionString(trackingOptions.pushThread, TEXT("PushPriority="), TEXT("PushCpus="));
+		if (trackingOptions.demultiplexCameras) {
+			connectionString += TEXT(" Demultiplex");
+		}
+		if (!trackingOptions.bindAddress.empty()) {
+			connectionString += FString(TEXT(" Bind=")) + UTF8_TO_TCHAR(trackingOptions.bindAddress.c_str());
+		}
+		if (trackingOptions.backupPort != 0) {
+			connectionString += FString::Printf(TEXT(" Backup=%d"), (int32)trackingOptions.backupPort);
+		}
+		if (!trackingOptions.backupBindAddress.empty()) {
+			connectionString += FString(TEXT(" BackupAddress=")) + UTF8_TO_TCHAR(trackingOptions.backupBindAddress.c_str());
+		}
+		if (!trackingOptions.backupMulticastInterface.empty()) {
+			connectionString += FString(TEXT(" BackupInterface=")) + UTF8_TO_TCHAR(trackingOptions.backupMulticastInterface.c_str());
+		}
+		if (trackingOptions.jitterFilter.enabled) {
+			static const TCHAR* const smoothingChannels[TRK_POSE_CHANNELS] = {
+				TEXT("X"), TEXT("Y"), TEXT("Z"), TEXT("Tilt"), TEXT("Pan"), TEXT("Roll"), TEXT("Zoom"), TEXT("Focus")
+			};
+			connectionString += TEXT(" Smoothing");
+			for (int32 channel = 0; channel < TRK_POSE_CHANNELS; ++channel) {
+				const TrkFilterChannel_t& settings = trackingOptions.jitterFilter.channels[channel];
+				connectionString += FString::Printf(TEXT(" Smooth%s=%g Smooth%sBeta=%g"),
+					smoothingChannels[channel], settings.minCutoffHz, smoothingChannels[channel], settings.beta);
+			}
+		}
+		if (delaySettings.amount > 0.0) {
+			static const TCHAR* const delayUnits[] = { TEXT("Microseconds"), TEXT("Frames"), TEXT("Fields") };
+			connectionString += FString::Printf(TEXT(" Delay=%g DelayUnit=%s"), delaySettings.amount, delayUnits[delaySettings.unit]);
+		}
+		if (trackingOptions.delay.capacity != TrkDelaySettings_t().capacity) {
+			connectionString += FString::Printf(TEXT(" DelayCapacity=%d"), (int32)trackingOptions.delay.capacity);
+		}
+		static const TCHAR* const predictionModels[] = { TEXT("None"), TEXT("ConstantVelocity"), TEXT("ConstantAcceleration"), TEXT("Kalman") };
+		if (trackingOptions.prediction.model != TRK_PREDICTION_NONE) {
+			connectionString += FString::Printf(TEXT(" Prediction=%s LeadTime=%g"),
+				predictionModels[trackingOptions.prediction.model], trackingOptions.prediction.leadTimeMs);
+			if (trackingOptions.prediction.model == TRK_PREDICTION_KALMAN) {
+				connectionString += FString::Printf(TEXT(" KalmanAgility=%g"), trackingOptions.prediction.kalmanAgility);
+			}
+		}
+		if (!trackingOptions.captureFile.empty()) {
+			connectionString += FString::Printf(TEXT(" Capture=\"%s\""), UTF8_TO_TCHAR(trackingOptions.captureFile.c_str()));
+		}
+		if (trackingOptions.receiveBackend == TRK_BACKEND_REPLAY) {
+			connectionString += FString::Printf(TEXT(" Replay=\"%s\" Speed=%g"),
+				UTF8_TO_TCHAR(trackingOptions.replayFile.c_str()), trackingOptions.replaySpeed);
+			if (trackingOptions.replayLoop) {
+				connectionString += TEXT(" Loop");
+			}
+		}
+		return connectionString;
 	}
 
 	void LiveLinkCameraSource::OnSettingsChanged(ULiveLinkSourceSettings* Settings, const FPropertyChangedEvent& PropertyChangedEvent) {
 		frameRate = Settings->BufferSettings.DetectedFrameRate;
+		const UTrackMenLiveLinkSourceSettings* trackMenSettings = Cast<UTrackMenLiveLinkSourceSettings>(Settings);
+		if (trackMenSettings != nullptr) {
+			ApplySettings(*trackMenSettings);
+			Settings->ConnectionString = BuildConnectionString();
+		}
+		UpdateDelay();
+	}
+
+	void LiveLinkCameraSource::ApplySettings(const UTrackMenLiveLinkSourceSettings& settings) {
+		uint16 port = udpPort;
+		TrkTrackingOptions_t options = trackingOptions;
+		settings.ToTrackingOptions(port, options, delaySettings);
+
+		// Smoothing, prediction, delay capacity and batch size change
+		// between two batches.
+		{
+			std::lock_guard<std::mutex> lock(processingMutex);
+			pendingProcessing = ProcessingSettingsFor(options);
+			processingGeneration.fetch_add(1, std::memory_order_release);
+		}
+
+		const bool portChanged = port != udpPort;
+		if (client == nullptr) {
+			// Not started yet.
+			udpPort = port;
+			trackingOptions = options;
+			if (portChanged) {
+				UpdateSourceMachineName();
+			}
+			return;
+		}
+
+		// Only another socket needs a restart of the receive path.
+		const bool reopen = portChanged
+			|| options.receiveBackend != trackingOptions.receiveBackend
+			|| options.receiveBufferSize != trackingOptions.receiveBufferSize
+			|| options.busyPollMicroseconds != trackingOptions.busyPollMicroseconds;
+		if (reopen) {
+			UE_LOG(LogTrackMenPlugin, Display, TEXT("Reopening UDP port %d for the changed settings"), udpPort);
+			StopTrackingThreads();
+			if (portChanged) {
+				// The subjects are named after the port.
+				RemoveMySubjects();
+			}
+			udpPort = port;
+			trackingOptions = options;
+			if (portChanged) {
+				UpdateSourceMachineName();
+				CreateMySubject();
+			}
+			StartTrackingThreads();
+			return;
+		}
+
+		UpdateReceivePath(options);
+
+		// The pushing thread reads none of these.
+		trackingOptions.queueDepth = options.queueDepth;
+		trackingOptions.queueMode = options.queueMode;
+		trackingOptions.overflowPolicy = options.overflowPolicy;
+		trackingOptions.sequencePolicy = options.sequencePolicy;
+		trackingOptions.reorderWindow = options.reorderWindow;
+		trackingOptions.captureFile = options.captureFile;
+		trackingOptions.receiverThread = options.receiverThread;
+		trackingOptions.pushThread = options.pushThread;
+		trackingOptions.jitterFilter = options.jitterFilter;
+		trackingOptions.prediction = options.prediction;
+		trackingOptions.delay = options.delay;
+	}
+
+	void LiveLinkCameraSource::UpdateReceivePath(const TrkTrackingOptions_t& options) {
+		// The push thread of the polling mode pops the queue, it pauses while
+		// the queue is rebuilt or swapped for the mailbox. A data callback
+		// runs under the lock of the receiver and needs no pause.
+		const bool pausePushThread = trackingThread.joinable()
+			&& (options.queueDepth != trackingOptions.queueDepth || options.queueMode != trackingOptions.queueMode);
+		if (pausePushThread) {
+			keepTrackingThreadRunning.store(false);
+			trackingInterface.interrupt_wait();
+			trackingThread.join();
+		}
+		trackingInterface.update_options(options);
+		if (pausePushThread) {
+			keepTrackingThreadRunning.store(true);
+			trackingThread = std::thread(std::bind(&LiveLinkCameraSource::TrackingThreadMain, this));
+		}
+
+		const bool pushThreadChanged = options.pushThread != trackingOptions.pushThread;
+		if (trackingThread.joinable() && (pushThreadChanged || (pausePushThread && !options.pushThread.is_default()))
+			&& apply_thread_settings(trackingThread, options.pushThread, "LiveLink push")) {
+			UE_LOG(LogTrackMenPlugin, Display, TEXT("LiveLink push thread of UDP port %d: %s"), udpPort,
+				UTF8_TO_TCHAR(describe_thread_settings(options.pushThread).c_str()));
+		}
+	}
+
+	void LiveLinkCameraSource::RemoveMySubjects() {
+		// The threads are stopped, cameraSubjects still holds the cameras.
+		if (!trackingOptions.demultiplexCameras) {
+			client->RemoveSubject_AnyThread(subjectPreset.Key);
+			return;
+		}
+		for (const auto& entry : cameraSubjects) {
+			client->RemoveSubject_AnyThread(FLiveLinkSubjectKey(sourceGUID, entry.Value.subjectName));
+		}
+	}
+
+	void LiveLinkCameraSource::UpdateSourceMachineName() {
+		if (trackingOptions.receiveBackend == TRK_BACKEND_REPLAY) {
+			return;
+		}
+		FString ports = FString::FromInt(udpPort);
+		if (trackingOptions.backupPort != 0) {
+			ports += FString::Printf(TEXT("+%d"), (int32)trackingOptions.backupPort);
+		}
+		sourceMachineName = trackingOptions.multicastGroup.empty()
+			? FText::FromString(TEXT("UDP ") + ports)
+			: FText::FromString(FString(TEXT("UDP ")) + UTF8_TO_TCHAR(trackingOptions.multicastGroup.c_str()) + TEXT(":") + ports);
+	}
+
+	void LiveLinkCameraSource::SetDelay(const TrkDelaySettings_t& delay) {
+		delaySettings.amount = delay.amount;
+		delaySettings.unit = delay.unit;
+		UpdateDelay();
+	}
+
+	void LiveLinkCameraSource::UpdateDelay() {
+		const int64 delay = delaySettings.delay_ns(frameRate.AsDecimal());
+		if (delayNs.exchange(delay) != delay) {
+			UE_LOG(LogTrackMenPlugin, Display, TEXT("Tracking of UDP port %d delayed by %.3f ms"), udpPort, (double)delay * 1e-6);
+		}
 	}
 
 	void LiveLinkCameraSource::ReceiveClient(ILiveLinkClient* InClient, FGuid InSourceGuid) {
-		sentStaticOnce = false;
 		client = InClient;
 		sourceGUID = InSourceGuid;
 		CreateMySubject();
@@ -43,6 +292,7 @@ namespace TrackMen {
 			// to SourceTimecodeFrameRate.
 			settings->BufferSettings.SourceTimecodeFrameRate = frameRate;
 		}
+		UpdateDelay();
 
 		StartTrackingThreads();
 	}
@@ -52,23 +302,10 @@ namespace TrackMen {
 	}
 
 	bool LiveLinkCameraSource::RequestSourceShutdown() {
-		// Set flag for tracking thread to stop
-		keepTrackingThreadRunning = false;
-
-		// Check if the thread has finished all live link processing
-		if (!isTrackingThreadRunning) {
-
-			// Make sure the thread is completely finished
-			if (trackingThread.joinable()) {
-				trackingThread.join();
-			}
-
-			// Stop the network interface.
-			trackingInterface.stop_camera_tracking();
-		}
-
-		// Return false while we're still processing live link data.
-		return !isTrackingThreadRunning;
+		// Blocked threads are woken and joined right here, so LiveLink never
+		// has to ask again.
+		StopTrackingThreads();
+		return true;
 	}
 
 	inline FText LiveLinkCameraSource::GetSourceType() const {
@@ -80,11 +317,71 @@ namespace TrackMen {
 	}
 
 	inline FText LiveLinkCameraSource::GetSourceStatus() const {
+		static const int64 STATUS_INTERVAL_NS = 1000000000;
+
+		// The push path only updates counters, the text is built here at a
+		// fixed rate no matter how often the LiveLink window asks.
+		const int64 nowNs = steady_time_ns();
+		if (nowNs - sourceStatusTimeNs < STATUS_INTERVAL_NS) {
+			return sourceStatus;
+		}
+		sourceStatusTimeNs = nowNs;
+
+		const SourceStatistics& statistics = trackingInterface.statistics();
+		const TrkSourceStatistics_t rates = statisticsSampler.sample(statistics, nowNs);
+		if (statistics.datagrams() == 0) {
+			sourceStatus = LOCTEXT("NoDataStatus", "Waiting for data");
+			return sourceStatus;
+		}
+
+		const TrkQueueStatistics_t queue = trackingInterface.get_queue_statistics();
+		const TrkSequenceStatistics_t sequence = trackingInterface.get_sequence_statistics();
+
+		FNumberFormattingOptions milliseconds;
+		milliseconds.SetMinimumFractionalDigits(1).SetMaximumFractionalDigits(1);
+
+		FFormatNamedArguments arguments;
+		arguments.Add(TEXT("Received"), FText::AsNumber(FMath::RoundToInt(rates.datagramsPerSecond)));
+		arguments.Add(TEXT("Parsed"), FText::AsNumber(FMath::RoundToInt(rates.parsedPerSecond)));
+		arguments.Add(TEXT("Pushed"), FText::AsNumber(FMath::RoundToInt(rates.pushedPerSecond)));
+		arguments.Add(TEXT("Queue"), FText::AsNumber((uint64)queue.queueDepth));
+		arguments.Add(TEXT("Dropped"), FText::AsNumber((uint64)(queue.droppedSamples + sequence.rejected)));
+		arguments.Add(TEXT("Lost"), FText::AsNumber((uint64)sequence.missing));
+		arguments.Add(TEXT("P50"), FText::AsNumber(rates.latencyP50Ms, &milliseconds));
+		arguments.Add(TEXT("P99"), FText::AsNumber(rates.latencyP99Ms, &milliseconds));
+		sourceStatus = FText::Format(LOCTEXT("SourceStatus",
+			"{Received} rx/s  {Parsed} parsed/s  {Pushed} pushed/s  q {Queue}  drop {Dropped}  lost {Lost}  p50 {P50} ms  p99 {P99} ms"),
+			arguments);
+		if (trackingInterface.receive_path_count() > 1) {
+			// Share of the samples each path delivered first since the last
+			// update, or "down" if nothing arrived on it for an interval.
+			uint64 firstArrivals[CameraTrackingInterface::MAX_RECEIVE_PATHS];
+			bool down[CameraTrackingInterface::MAX_RECEIVE_PATHS];
+			uint64 total = 0;
+			for (size_t path = 0; path < CameraTrackingInterface::MAX_RECEIVE_PATHS; ++path) {
+				const TrkPathStatistics_t pathStatistics = trackingInterface.get_path_statistics(path);
+				firstArrivals[path] = pathStatistics.firstArrivals >= pathFirstArrivals[path]
+					? pathStatistics.firstArrivals - pathFirstArrivals[path] : pathStatistics.firstArrivals;
+				pathFirstArrivals[path] = pathStatistics.firstArrivals;
+				down[path] = nowNs - pathStatistics.lastArrivalNs >= STATUS_INTERVAL_NS;
+				total += firstArrivals[path];
+			}
+			auto pathText = [&](size_t path) {
+				return down[path] ? LOCTEXT("PathDown", "down")
+					: FText::Format(LOCTEXT("PathShare", "{0}%"), FText::AsNumber(total > 0 ? (uint64)(100 * firstArrivals[path] / total) : (uint64)0));
+			};
+			sourceStatus = FText::Format(LOCTEXT("RedundantSourceStatus", "{0}  first {1}/{2}"),
+				sourceStatus, pathText(0), pathText(1));
+		}
+		if (trackingOptions.demultiplexCameras) {
+			sourceStatus = FText::Format(LOCTEXT("DemultiplexedSourceStatus", "{0} cams  {1}"),
+				FText::AsNumber(cameraCount.load()), sourceStatus);
+		}
 		return sourceStatus;
 	}
 
 	void LiveLinkCameraSource::CreateMySubject() {
-		// Every camera source has exactly one subject.
+		// A camera source has one subject, unless it demultiplexes.
 		// 1. Define subject data.
 		// 2. Search existing subject.
 		// 3. If no subject is found, create a new subject.
@@ -94,6 +391,13 @@ namespace TrackMen {
 		subjectPreset.Role = UTrackMenCameraRole::StaticClass();
 		subjectPreset.bEnabled = true;
 
+		if (trackingOptions.demultiplexCameras) {
+			// "<port subject>-<camera id>" subjects are created by LiveLink
+			// when their first static data is pushed.
+			UE_LOG(LogTrackMenPlugin, Display, TEXT("UDP port %d demultiplexes cameras, their LiveLink subjects are added as they appear."), udpPort);
+			return;
+		}
+
 		// 2. Search existing subject.
 		bool foundSubject = false;
 		auto subjects = client->GetSubjects(true, true);
@@ -116,183 +420,224 @@ namespace TrackMen {
 	}
 
 	void LiveLinkCameraSource::StartTrackingThreads() {
-		trackingInterface.start_camera_tracking(udpPort);
-		keepTrackingThreadRunning = true;
-		trackingThread = std::thread(std::bind(&LiveLinkCameraSource::TrackingThreadMain, this));
-	}
+		// Re-adding a source restarts it.
+		StopTrackingThreads();
+
+		ResetSampleProcessing();
+		statisticsSampler.restart(trackingInterface.statistics(), steady_time_ns());
+
+		if (trackingOptions.wakeupMode == TRK_WAKEUP_POLL) {
+			// Legacy: a tracking thread polls the receiver queue.
+			trackingInterface.set_data_callback(nullptr);
+			trackingInterface.start_camera_tracking(udpPort, trackingOptions);
+			keepTrackingThreadRunning.store(true);
+			trackingThread = std::thread(std::bind(&LiveLinkCameraSource::TrackingThreadMain, this));
+			if (!trackingOptions.pushThread.is_default() && apply_thread_settings(trackingThread, trackingOptions.pushThread, "LiveLink push")) {
+				UE_LOG(LogTrackMenPlugin, Display, TEXT("LiveLink push thread of UDP port %d: %s"), udpPort,
+					UTF8_TO_TCHAR(describe_thread_settings(trackingOptions.pushThread).c_str()));
+			}
+			return;
+		}
 
-	void LiveLinkCameraSource::TrackingThreadMain() {
-		// This thread function polls the network interface for new tracking data.
-		// Incoming data is converted and forwarded to the LiveLink client.
+		if (!trackingOptions.pushThread.is_default()) {
+			UE_LOG(LogTrackMenPlugin, Display, TEXT("UDP port %d pushes to LiveLink on the receiver thread, the push thread settings are not used."), udpPort);
+		}
 
-		// Update status flag for UI thread.
-		isTrackingThreadRunning = true;
+		// Samples are pushed to LiveLink right on the receiver thread, which is
+		// shared by all sources if the platform supports it.
+		trackingInterface.set_data_callback([this]() { ProcessPendingSamples(); });
+		trackingInterface.start_camera_tracking(udpPort, trackingOptions);
+		if (trackingInterface.check_error() == TRK_ERROR_CANNOT_CREATE_HANDLE_FOR_PORT) {
+			UE_LOG(LogTrackMenPlugin, Display, TEXT("Error: Cannot create handle for UDP port %d."), udpPort);
+		}
+	}
 
-		UE_LOG(LogTrackMenPlugin, Display, TEXT("Tracking thread started"));
+	void LiveLinkCameraSource::StopTrackingThreads() {
+		keepTrackingThreadRunning.store(false);
+		if (trackingThread.joinable()) {
+			trackingInterface.interrupt_wait();
+			trackingThread.join();
+		}
 
-		// This lambda is called after every loop iteration. We sleep 1ms in order
-		// in order to save some CPU load.
-		auto loop_end_callback = []() {
-			FPlatformProcess::Sleep(0.01f);
-		};
+		// Joins the receiver thread, or waits for a push running on the shared one.
+		trackingInterface.stop_camera_tracking();
+	}
 
-		FTrackMenCameraFrameData frame;
-		frame.chip_size = FVector2D(9.6, 5.4);
+	LiveLinkCameraSource::FProcessingSettings LiveLinkCameraSource::ProcessingSettingsFor(const TrkTrackingOptions_t& options) {
+		FProcessingSettings settings;
+		settings.jitterFilter = options.jitterFilter;
+		settings.prediction = options.prediction;
+		settings.delayCapacity = options.delay.capacity;
+		// Every wake-up drains the whole queue into a preallocated batch.
+		settings.batchSize = FMath::Max(1, (int32)options.queueDepth);
+		return settings;
+	}
 
-		TrkCameraConstants_t constants;
-		constants.chipHeight = frame.chip_size.X;
-		constants.chipWidth = frame.chip_size.Y;
+	void LiveLinkCameraSource::ResetSampleProcessing() {
+		cameraSubjects.Reset();
+		cameraCount.store(0);
+		activeProcessing = ProcessingSettingsFor(trackingOptions);
+		appliedProcessingGeneration = processingGeneration.load();
+		samples.SetNum(activeProcessing.batchSize);
+	}
 
-		for (; keepTrackingThreadRunning; loop_end_callback()) {
+	LiveLinkCameraSource::FCameraSubject& LiveLinkCameraSource::FindOrAddCameraSubject(uint32 cameraId) {
+		const uint32 key = trackingOptions.demultiplexCameras ? cameraId : 0;
+		FCameraSubject* subject = cameraSubjects.Find(key);
+		if (subject != nullptr) {
+			return *subject;
+		}
 
-			auto error = CheckTrackingInterfaceErrors();
-			if (error != TrkErrorType_t::TRK_ERROR_NO_ERROR) {
-				continue;
+		FCameraSubject& added = cameraSubjects.Add(key);
+		added.chipSize = FVector2D(9.6, 5.4);
+		added.constants.chipHeight = added.chipSize.X;
+		added.constants.chipWidth = added.chipSize.Y;
+		added.jitterFilter.configure(activeProcessing.jitterFilter);
+		added.predictor.configure(activeProcessing.prediction);
+		added.delayLine = DelayLine(activeProcessing.delayCapacity);
+		if (trackingOptions.demultiplexCameras) {
+			added.subjectName = FName(*FString::Printf(TEXT("%s-%u"), *subjectPreset.Key.SubjectName.ToString(), key));
+			UE_LOG(LogTrackMenPlugin, Display, TEXT("Camera id %u on UDP port %d, LiveLink subject %s"), key, udpPort, *added.subjectName.ToString());
+		}
+		else {
+			added.subjectName = subjectPreset.Key.SubjectName;
+		}
+		cameraCount.store(cameraSubjects.Num());
+		return added;
+	}
+
+	void LiveLinkCameraSource::ApplyProcessingSettings(uint32 generation) {
+		const size_t delayCapacity = activeProcessing.delayCapacity;
+		{
+			std::lock_guard<std::mutex> lock(processingMutex);
+			activeProcessing = pendingProcessing;
+		}
+		appliedProcessingGeneration = generation;
+		samples.SetNum(activeProcessing.batchSize);
+
+		// The cameras start over with the new settings.
+		for (auto& entry : cameraSubjects) {
+			FCameraSubject& subject = entry.Value;
+			subject.jitterFilter.configure(activeProcessing.jitterFilter);
+			subject.predictor.configure(activeProcessing.prediction);
+			if (activeProcessing.delayCapacity != delayCapacity) {
+				subject.delayLine = DelayLine(activeProcessing.delayCapacity);
+				subject.delayExceeded = false;
 			}
+		}
+	}
 
-			// Check data availability
-			auto gotParams = trackingInterface.got_parameters();
-			auto gotConstants = trackingInterface.got_constants();
+	void LiveLinkCameraSource::ProcessPendingSamples() {
+		const uint32 generation = processingGeneration.load(std::memory_order_acquire);
+		if (generation != appliedProcessingGeneration) {
+			ApplyProcessingSettings(generation);
+		}
 
-			if (!gotParams) {
-				continue;
+		// Get data
+		const int32 sampleCount = (int32)trackingInterface.get_camera_samples(samples.GetData(), samples.Num());
+		if (sampleCount == 0) {
+			return;
+		}
+
+		// Only the most recent constants of each camera are relevant for the batch.
+		while (trackingInterface.got_constants()) {
+			const TrkCameraConstants_t constants = trackingInterface.get_camera_constants();
+			FindOrAddCameraSubject(constants.id).constants = constants;
+		}
+
+		// Arrival times are steady clock stamps, LiveLink world time is
+		// based on FPlatformTime::Seconds().
+		const double platformNow = FPlatformTime::Seconds();
+		const int64 steadyNowNs = steady_time_ns();
+		const int64 leadTimeNs = (int64)(activeProcessing.prediction.leadTimeMs * 1e6);
+		const int64 delay = delayNs.load();
+
+		for (int32 i = 0; i < sampleCount; ++i) {
+			const TrkCameraSample_t& sample = samples[i];
+			const double arrivalTime = platformNow - (double)(steadyNowNs - sample.arrivalTimeNs) * 1e-9;
+			FCameraSubject& subject = FindOrAddCameraSubject(sample.params.id);
+
+			// Convert data to LiveLink format, smooth the encoder jitter and
+			// predict the lead time plus the time the sample already waited
+			// since its arrival.
+			TrkCameraFrame_t converted;
+			convert_camera_frame(sample.params, subject.constants, converted);
+			subject.jitterFilter.filter(converted, (uint32_t)sample.params.counter, sample.arrivalTimeNs);
+			if (activeProcessing.prediction.model != TRK_PREDICTION_NONE) {
+				subject.predictor.update(converted, (uint32_t)sample.params.counter, sample.arrivalTimeNs);
+				subject.predictor.extrapolate(converted, leadTimeNs + (steadyNowNs - sample.arrivalTimeNs));
 			}
 
-			// Get data
-			auto params = trackingInterface.get_camera_parameters();
-			if (trackingInterface.got_constants()) {
-				constants = trackingInterface.get_camera_constants();
+			// The delay line always records, so a new delay applies at once
+			// as far as the recorded frames reach back.
+			uint32_t counter = (uint32_t)sample.params.counter;
+			subject.delayLine.push(converted, counter, sample.arrivalTimeNs);
+			if (delay > 0 && !subject.delayLine.sample_at(sample.arrivalTimeNs - delay, converted, counter) && !subject.delayExceeded) {
+				subject.delayExceeded = true;
+				UE_LOG(LogTrackMenPlugin, Warning, TEXT("Delay of %s exceeds the %d samples kept, it is shortened"),
+					*subject.subjectName.ToString(), (int32)subject.delayLine.capacity());
 			}
+			const FTrackMenCameraFrameData frame = GetCameraFrameFromTrkData(converted, counter, frameRate, arrivalTime);
+
+			// Push data to LiveLink client, in arrival order
+			PushStaticToSubjectIfChipSizeChanged(subject, frame);
+			PushFrameToSubject(subject.subjectName, frame);
+			trackingInterface.statistics().add_pushed(steady_time_ns() - sample.arrivalTimeNs);
+		}
+	}
+
+	void LiveLinkCameraSource::TrackingThreadMain() {
+		// This thread function waits for new tracking data on the network interface.
+		// Incoming data is converted and forwarded to the LiveLink client.
 
-			// Save previous chip size to check for changes
-			FVector2D old_chip_size = frame.chip_size;
+		UE_LOG(LogTrackMenPlugin, Display, TEXT("Tracking thread started"));
+
+		// This lambda is called after every loop iteration. In the legacy
+		// polling mode wait_for_data() sleeps for a fixed interval.
+		auto loop_end_callback = [this]() {
+			if (!trackingInterface.got_parameters()) {
+				trackingInterface.wait_for_data(std::chrono::milliseconds(50));
+			}
+		};
 
-			// Convert data to LiveLink format
-			frame = GetCameraFrameFromTrkData(params, constants, frameRate);
+		for (; keepTrackingThreadRunning.load(); loop_end_callback()) {
 
-			// Push data to LiveLink client
-			PushStaticToSubjectIfChipSizeChanged(old_chip_size, frame);
-			PushFrameToSubject(frame);
+			auto error = CheckTrackingInterfaceErrors();
+			if (error != TrkErrorType_t::TRK_ERROR_NO_ERROR) {
+				continue;
+			}
+
+			ProcessPendingSamples();
 		}
 
 		UE_LOG(LogTrackMenPlugin, Display, TEXT("Tracking thread stopped"));
-
-		// Update status flag for UI thread.
-		isTrackingThreadRunning = false;
 		return;
 	}
 
-	static FTrackMenCameraFrameData GetCameraFrameFromTrkData(const TrkCameraParams_t& params, const TrkCameraConstants_t& constants, const FFrameRate& frameRate)
+	static FTrackMenCameraFrameData GetCameraFrameFromTrkData(const TrkCameraFrame_t& converted, uint32 counter, const FFrameRate& frameRate, double arrivalTime)
 	{
-		// TODO: check format and convert data if necessary
-
 		FTrackMenCameraFrameData frame;
-
-		// Build LiveLink data format
-		FVector position, tmpPosition;
-		FRotator rotation, tmpRotation;
-
-		static const unsigned trkCameraEuler = 0x0001;
-		static const unsigned trkCameraY_Up = 0x0004;
-		static const unsigned trkFieldOfView = 0x0010;
-		static const unsigned trkVertical = 0x0020;
-		static const unsigned trkDiagonal = 0x0040;
-
-		if (!(params.format & trkCameraEuler)) {
-			FMatrix m;
-			m.M[0][0] = params.t.m[0][0];
-			m.M[0][1] = params.t.m[0][1];
-			m.M[0][2] = params.t.m[0][2];
-			m.M[0][3] = params.t.m[0][3];
-
-			m.M[1][0] = params.t.m[1][0];
-			m.M[1][1] = params.t.m[1][1];
-			m.M[1][2] = params.t.m[1][2];
-			m.M[1][3] = params.t.m[1][3];
-
-			m.M[2][0] = params.t.m[2][0];
-			m.M[2][1] = params.t.m[2][1];
-			m.M[2][2] = params.t.m[2][2];
-			m.M[2][3] = params.t.m[2][3];
-
-			m.M[3][0] = params.t.m[3][0];
-			m.M[3][1] = params.t.m[3][1];
-			m.M[3][2] = params.t.m[3][2];
-			m.M[3][3] = params.t.m[3][3];
-
-			tmpPosition = m.TransformPosition(FVector());
-			tmpRotation = m.Rotator();
-		}
-		else {
-			tmpPosition.X = params.t.e.x;
-			tmpPosition.Y = params.t.e.y;
-			tmpPosition.Z = params.t.e.z;
-			tmpRotation.Yaw = params.t.e.pan;
-			tmpRotation.Pitch = params.t.e.tilt;
-			tmpRotation.Roll = params.t.e.roll;
-		}
-
-		// TODO: check format type
-		static const bool publicFormat = true;
-
-		if (publicFormat) {
-
-			// Transformation with view direction X
-			//if (params.format & trkCameraY_Up) {
-			//	position.Z = 100.f*tmpPosition.Y;
-			//	position.X = -100.f*tmpPosition.Z;
-			//}
-			//else {
-			//	position.Z = 100.f*tmpPosition.Z;
-			//	position.X = 100.f*tmpPosition.Y;
-			//}
-			//position.Y = 100.f*tmpPosition.X;
-
-			// Transformation with view direction Y
-			position = 100.f*tmpPosition;
-			position.X = -1.f * position.X;
-			rotation.Yaw = -tmpRotation.Yaw + 90.0;
-			rotation.Pitch = tmpRotation.Pitch;
-			rotation.Roll = tmpRotation.Roll;
-
-		}
-		else { // Unity format
-			position.Y = 100.f*tmpPosition.X;
-			position.Z = 100.f*tmpPosition.Y;
-			position.X = 100.f*tmpPosition.Z;
-			rotation.Yaw = tmpRotation.Yaw;
-			rotation.Pitch = -tmpRotation.Pitch;
-			rotation.Roll = -tmpRotation.Roll;
-		}
+		const FVector position((float)converted.position[0], (float)converted.position[1], (float)converted.position[2]);
+		const FRotator rotation((float)converted.pitch, (float)converted.yaw, (float)converted.roll);
 		frame.Transform = FTransform(rotation, position);
 
-		if (params.format & trkFieldOfView) {
-			if (params.format & trkVertical) {
-				frame.FocalLength = (float)(0.5 * constants.chipHeight / tan(PI * 0.5 * params.fov / 180.0));
-			}
-			else {
-				frame.FocalLength = (float)(0.5 * constants.chipWidth / tan(PI * 0.5 * params.fov / 180.0));
-			}
-		}
-		else {
-			frame.FocalLength = params.fov;
-		}
-		frame.lens_distortion[0] = (float)params.k1;
-		frame.lens_distortion[1] = (float)params.k2;
+		frame.FocalLength = (float)converted.focalLength;
+		frame.lens_distortion[0] = (float)converted.lensDistortion[0];
+		frame.lens_distortion[1] = (float)converted.lensDistortion[1];
 
-		frame.center_shift[0] = (float)params.centerX;
-		frame.center_shift[1] = (float)params.centerY;
+		frame.center_shift[0] = (float)converted.centerShift[0];
+		frame.center_shift[1] = (float)converted.centerShift[1];
 
-		frame.FocusDistance = (float)(params.focdist*100.0);
+		frame.FocusDistance = (float)converted.focusDistance;
 
-		frame.chip_size[0] = (float)constants.chipWidth;
-		frame.chip_size[1] = (float)constants.chipHeight;
+		frame.chip_size[0] = (float)converted.chipSize[0];
+		frame.chip_size[1] = (float)converted.chipSize[1];
 
-		frame.Aperture = (float)params.aperture;
+		frame.Aperture = (float)converted.aperture;
 
-		FFrameTime time((int32)params.counter);
+		FFrameTime time((int32)counter);
 		frame.MetaData.SceneTime = FQualifiedFrameTime(time, frameRate);
-		frame.WorldTime = FLiveLinkWorldTime();
+		frame.WorldTime = FLiveLinkWorldTime(arrivalTime);
 
 		return frame;
 	}
@@ -324,35 +669,39 @@ namespace TrackMen {
 		return TrkErrorType_t::TRK_ERROR_NO_ERROR;
 	}
 
-	void LiveLinkCameraSource::PushFrameToSubject(const FTrackMenCameraFrameData &frame)
+	void LiveLinkCameraSource::PushFrameToSubject(const FName& cameraSubjectName, const FTrackMenCameraFrameData &frame)
 	{
 		if (client) {
 			FLiveLinkFrameDataStruct frame_data_struct = FLiveLinkFrameDataStruct(FTrackMenCameraFrameData::StaticStruct());
 			frame_data_struct.InitializeWith(&frame);
-			client->PushSubjectFrameData_AnyThread({ sourceGUID, subjectPreset.Key.SubjectName }, MoveTemp(frame_data_struct));
+			client->PushSubjectFrameData_AnyThread({ sourceGUID, cameraSubjectName }, MoveTemp(frame_data_struct));
 		}
 	}
 
-	void LiveLinkCameraSource::PushStaticToSubjectIfChipSizeChanged(const FVector2D &old_chip_size, const FTrackMenCameraFrameData &frame)
+	void LiveLinkCameraSource::PushStaticToSubjectIfChipSizeChanged(FCameraSubject& subject, const FTrackMenCameraFrameData &frame)
 	{
-		if (!sentStaticOnce || old_chip_size.X != frame.chip_size.X || old_chip_size.Y != frame.chip_size.Y) {
+		const FVector2D old_chip_size = subject.chipSize;
+		subject.chipSize = frame.chip_size;
+		if (!subject.sentStatic || old_chip_size.X != frame.chip_size.X || old_chip_size.Y != frame.chip_size.Y) {
 			// Push the first time no matter what
-			sentStaticOnce = true;
+			subject.sentStatic = true;
 			FTrackMenCameraStaticData static_data;
 			static_data.bIsFocalLengthSupported = true;
 			static_data.bIsFocusDistanceSupported = true;
 			static_data.FilmBackWidth = frame.chip_size.X;
 			static_data.FilmBackHeight = frame.chip_size.Y;
-			PushStaticToSubject(static_data);
+			PushStaticToSubject(subject.subjectName, static_data);
 		}
 	}
 
-	void LiveLinkCameraSource::PushStaticToSubject(const FTrackMenCameraStaticData& static_data)
+	void LiveLinkCameraSource::PushStaticToSubject(const FName& cameraSubjectName, const FTrackMenCameraStaticData& static_data)
 	{
 		if (client) {
 			FLiveLinkStaticDataStruct static_data_struct = FLiveLinkStaticDataStruct(FTrackMenCameraStaticData::StaticStruct());
 			static_data_struct.InitializeWith(&static_data);
-			client->PushSubjectStaticData_AnyThread(subjectPreset.Key, UTrackMenCameraRole::StaticClass(), MoveTemp(static_data_struct));
+			client->PushSubjectStaticData_AnyThread({ sourceGUID, cameraSubjectName }, UTrackMenCameraRole::StaticClass(), MoveTemp(static_data_struct));
 		}
 	}
-}
\ No newline at end of file
+}
+
+#undef LOCTEXT_NAMESPACE
@@ -0,0 +1,297 @@
+/* Copyright 2021 TrackMen GmbH <mail@trackmen.de> */
+
+#include "TrackMenAsciiParser.h"
+
+#include <limits>
+#include <type_traits>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace TrackMen {
+
+	namespace {
+
+		static const unsigned trkEuler = 0x0001;
+
+		// Longest number handed to strtod(), a datagram is never longer.
+		static const size_t MAX_NUMBER_LENGTH = 4096;
+
+		/**
+		* Cursor over the datagram text. Every read_* function skips leading
+		* white space and fails if no number can be read at the cursor.
+		*/
+		class AsciiReader {
+		public:
+			AsciiReader(const char* text, size_t length)
+				: m_pos(text)
+				, m_end(text + length) {
+			}
+
+			bool skip_char(char c) {
+				if (m_pos != m_end && *m_pos == c) {
+					++m_pos;
+					return true;
+				}
+				return false;
+			}
+
+			template <typename T>
+			bool read_integer(T& value, unsigned base) {
+				typedef typename std::make_unsigned<T>::type Unsigned;
+
+				if (!skip_space()) {
+					return false;
+				}
+
+				bool negative = false;
+				if (*m_pos == '-' || *m_pos == '+') {
+					negative = *m_pos == '-';
+					++m_pos;
+				}
+
+				// Leading zeros and the optional "0x" of hex numbers.
+				bool found_zero = false;
+				int digit_count = 0;
+				while (m_pos != m_end) {
+					const char c = *m_pos;
+					if (c == '0' && (!found_zero || base == 10)) {
+						found_zero = true;
+						++digit_count;
+					}
+					else if (found_zero && base == 16 && (c == 'x' || c == 'X')) {
+						found_zero = false;
+						digit_count = 0;
+					}
+					else {
+						break;
+					}
+					if (++m_pos != m_end && !found_zero) {
+						break;
+					}
+				}
+
+				const Unsigned max = (negative && std::numeric_limits<T>::is_signed)
+					? (Unsigned)std::numeric_limits<T>::max() + 1
+					: (Unsigned)std::numeric_limits<T>::max();
+				const Unsigned max_before_multiply = max / base;
+
+				Unsigned result = 0;
+				bool overflow = false;
+				for (; m_pos != m_end; ++m_pos) {
+					const int digit = digit_value(*m_pos, base);
+					if (digit < 0) {
+						break;
+					}
+					if (result > max_before_multiply) {
+						overflow = true;
+					}
+					else {
+						result *= base;
+						overflow |= result > max - (Unsigned)digit;
+						result += (Unsigned)digit;
+						++digit_count;
+					}
+				}
+
+				if ((digit_count == 0 && !found_zero) || overflow) {
+					return false;
+				}
+				value = (T)(negative ? (Unsigned)(0 - result) : result);
+				return true;
+			}
+
+			bool read_double(double& value) {
+				if (!skip_space()) {
+					return false;
+				}
+				const char* start = m_pos;
+
+				bool negative = false;
+				if (*m_pos == '-' || *m_pos == '+') {
+					negative = *m_pos == '-';
+					++m_pos;
+				}
+
+				// Up to 19 significant digits fit into the mantissa, the value
+				// is mantissa * 10^exponent.
+				uint64_t mantissa = 0;
+				int significant_digits = 0;
+				int exponent = 0;
+				bool found_mantissa = false;
+				bool found_point = false;
+				bool truncated = false;
+
+				for (; m_pos != m_end; ++m_pos) {
+					const char c = *m_pos;
+					if (c >= '0' && c <= '9') {
+						found_mantissa = true;
+						const int digit = c - '0';
+						if (mantissa == 0 && digit == 0) {
+							exponent -= found_point ? 1 : 0;
+						}
+						else if (significant_digits < 19) {
+							mantissa = mantissa * 10 + (uint64_t)digit;
+							++significant_digits;
+							exponent -= found_point ? 1 : 0;
+						}
+						else {
+							truncated = true;
+							exponent += found_point ? 0 : 1;
+						}
+					}
+					else if (c == '.' && !found_point) {
+						found_point = true;
+					}
+					else {
+						break;
+					}
+				}
+
+				// An exponent is only recognized after a digit and needs digits.
+				if (found_mantissa && m_pos != m_end && (*m_pos == 'e' || *m_pos == 'E')) {
+					++m_pos;
+					bool negative_exponent = false;
+					if (m_pos != m_end && (*m_pos == '-' || *m_pos == '+')) {
+						negative_exponent = *m_pos == '-';
+						++m_pos;
+					}
+					int exponent_value = 0;
+					bool found_exponent = false;
+					for (; m_pos != m_end && *m_pos >= '0' && *m_pos <= '9'; ++m_pos) {
+						found_exponent = true;
+						if (exponent_value < 100000) {
+							exponent_value = exponent_value * 10 + (*m_pos - '0');
+						}
+					}
+					if (!found_exponent) {
+						return false;
+					}
+					exponent += negative_exponent ? -exponent_value : exponent_value;
+				}
+
+				if (!found_mantissa) {
+					return false;
+				}
+
+				// Clinger's fast path: mantissa and power of ten are exact
+				// doubles, so a single multiplication or division rounds
+				// correctly and matches strtod().
+				static const double powers_of_ten[] = {
+					1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+					1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20,
+					1e21, 1e22
+				};
+				if (!truncated && mantissa <= (uint64_t(1) << 53) && exponent >= -22 && exponent <= 22) {
+					double result = (double)mantissa;
+					result = exponent < 0 ? result / powers_of_ten[-exponent] : result * powers_of_ten[exponent];
+					value = negative ? -result : result;
+					return true;
+				}
+
+				return convert_slow(start, m_pos, value);
+			}
+
+		private:
+			bool skip_space() {
+				while (m_pos != m_end && (*m_pos == ' ' || (*m_pos >= '\t' && *m_pos <= '\r'))) {
+					++m_pos;
+				}
+				return m_pos != m_end;
+			}
+
+			static int digit_value(char c, unsigned base) {
+				if (c >= '0' && c <= '9') {
+					return c - '0';
+				}
+				if (base == 16) {
+					if (c >= 'a' && c <= 'f') {
+						return c - 'a' + 10;
+					}
+					if (c >= 'A' && c <= 'F') {
+						return c - 'A' + 10;
+					}
+				}
+				return -1;
+			}
+
+			// Rare: more than 19 digits or a large exponent.
+			static bool convert_slow(const char* start, const char* end, double& value) {
+				const size_t length = (size_t)(end - start);
+				if (length >= MAX_NUMBER_LENGTH) {
+					return false;
+				}
+				char number[MAX_NUMBER_LENGTH];
+				memcpy(number, start, length);
+				number[length] = '\0';
+
+				const double result = strtod(number, nullptr);
+				if (result == std::numeric_limits<double>::infinity() || result == -std::numeric_limits<double>::infinity()) {
+					return false;
+				}
+				value = result;
+				return true;
+			}
+
+			const char* m_pos;
+			const char* m_end;
+		};
+	}
+
+	bool parse_ascii_camera_params(const char* text, size_t length, TrkCameraParams_t& params) {
+		AsciiReader reader(text, length);
+
+		if (reader.skip_char('I') && !reader.read_integer(params.id, 10)) {
+			return false;
+		}
+
+		if (!reader.read_integer(params.format, 16)) {
+			return false;
+		}
+
+		if (params.format & trkEuler) {
+			if (!reader.read_double(params.t.e.x)
+				|| !reader.read_double(params.t.e.y)
+				|| !reader.read_double(params.t.e.z)
+				|| !reader.read_double(params.t.e.pan)
+				|| !reader.read_double(params.t.e.tilt)
+				|| !reader.read_double(params.t.e.roll)) {
+				return false;
+			}
+		}
+		else {
+			for (int j = 0; j < 3; ++j) {
+				for (int i = 0; i < 4; ++i) {
+					if (!reader.read_double(params.t.m[j][i])) {
+						return false;
+					}
+				}
+			}
+			params.t.m[0][3] = params.t.m[1][3] = params.t.m[2][3] = 0.0;
+			params.t.m[3][3] = 1.0;
+		}
+
+		return reader.read_double(params.fov)
+			&& reader.read_double(params.centerX)
+			&& reader.read_double(params.centerY)
+			&& reader.read_double(params.k1)
+			&& reader.read_double(params.k2)
+			&& reader.read_double(params.focdist)
+			&& reader.read_double(params.aperture)
+			&& reader.read_integer(params.counter, 10);
+	}
+
+	bool parse_ascii_camera_constants(const char* text, size_t length, TrkCameraConstants_t& constants) {
+		AsciiReader reader(text, length);
+		return reader.read_integer(constants.imageWidth, 10)
+			&& reader.read_integer(constants.imageHeight, 10)
+			&& reader.read_integer(constants.blankLeft, 10)
+			&& reader.read_integer(constants.blankRight, 10)
+			&& reader.read_integer(constants.blankTop, 10)
+			&& reader.read_integer(constants.blankBottom, 10)
+			&& reader.read_double(constants.chipWidth)
+			&& reader.read_double(constants.chipHeight)
+			&& reader.read_double(constants.fakeChipWidth)
+			&& reader.read_double(constants.fakeChipHeight);
+	}
+}
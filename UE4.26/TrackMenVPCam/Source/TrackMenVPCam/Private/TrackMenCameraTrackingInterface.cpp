@@ -1,21 +1,149 @@
 /* Copyright 2021 TrackMen GmbH <mail@trackmen.de> */
 
 #include "TrackMenCameraTrackingInterface.h"
-#include "PluginLogging.h"
-
-#include "HAL/PlatformProcess.h"
-#include "Misc/Paths.h"
-#include "Interfaces/IPluginManager.h"
-#include "Common/UdpSocketBuilder.h"
-#include "Sockets.h"
+#include "TrackMenAsciiParser.h"
+#include "TrackMenLog.h"
+#include "TrackMenThreadSettings.h"
+#include "TrackMenWireFormat.h"
 
 #include <algorithm>
-#include <sstream>
+#include <string.h>
+#include <vector>
 
 namespace TrackMen {
 
-	CameraTrackingInterface::CameraTrackingInterface() {
+	static std::unique_ptr<ReceiveBackend> try_open(std::unique_ptr<ReceiveBackend> backend, uint16_t port, const TrkTrackingOptions_t& options) {
+		if (backend && !backend->open(port, options)) {
+			backend.reset();
+		}
+		return backend;
+	}
+
+	static std::unique_ptr<ReceiveBackend> open_receive_backend(uint16_t port, const TrkTrackingOptions_t& options) {
+		std::unique_ptr<ReceiveBackend> backend;
+
+		switch (options.receiveBackend) {
+		case TRK_BACKEND_REPLAY:
+			// Never fall back to the network, the data would not be the capture.
+			backend = try_open(create_replay_receive_backend(), port, options);
+			if (!backend) {
+				log_message(TRK_LOG_ERROR, "Cannot replay %s, it is not a readable capture file.", options.replayFile.c_str());
+				return nullptr;
+			}
+			log_message(TRK_LOG_DISPLAY, "Replaying %s at %.2fx speed (0 = as fast as possible)", options.replayFile.c_str(), options.replaySpeed);
+			return backend;
+		case TRK_BACKEND_IO_URING:
+			backend = try_open(create_io_uring_receive_backend(), port, options);
+			if (!backend) {
+				log_message(TRK_LOG_WARNING, "io_uring receive backend not available on UDP port %d, falling back to FSocket.", port);
+			}
+			break;
+		case TRK_BACKEND_RECVMMSG:
+			backend = try_open(create_recvmmsg_receive_backend(), port, options);
+			if (!backend) {
+				log_message(TRK_LOG_WARNING, "recvmmsg receive backend not available on UDP port %d, falling back to FSocket.", port);
+			}
+			break;
+		case TRK_BACKEND_AUTO:
+			backend = try_open(create_recvmmsg_receive_backend(), port, options);
+			break;
+		default:
+			break;
+		}
+
+		if (!backend) {
+			backend = try_open(create_fsocket_receive_backend(), port, options);
+			if (!backend) {
+				if (!options.multicastGroup.empty()) {
+					log_message(TRK_LOG_ERROR, "Cannot join multicast group %s on UDP port %d, check the group, source and interface addresses.",
+						options.multicastGroup.c_str(), port);
+				}
+				return nullptr;
+			}
+		}
+
+		if (options.multicastGroup.empty()) {
+			log_message(TRK_LOG_DISPLAY, "Receiving tracking data on UDP port %d%s%s (%s, %s timestamps)", port,
+				options.bindAddress.empty() ? "" : " of ", options.bindAddress.c_str(),
+				backend->name(), backend->kernel_timestamps() ? "kernel" : "userspace");
+		}
+		else {
+			log_message(TRK_LOG_DISPLAY, "Receiving tracking data on UDP port %d, multicast group %s%s%s%s%s (%s, %s timestamps)", port,
+				options.multicastGroup.c_str(),
+				options.multicastSource.empty() ? "" : " from ", options.multicastSource.c_str(),
+				options.multicastInterface.empty() ? "" : " on ", options.multicastInterface.c_str(),
+				backend->name(), backend->kernel_timestamps() ? "kernel" : "userspace");
+		}
+		return backend;
+	}
+
+	// The backup path receives the same stream on another port or interface.
+	static TrkTrackingOptions_t backup_path_options(const TrkTrackingOptions_t& options) {
+		TrkTrackingOptions_t backup = options;
+		backup.bindAddress = options.backupBindAddress;
+		if (!options.backupMulticastInterface.empty()) {
+			backup.multicastInterface = options.backupMulticastInterface;
+		}
+		return backup;
+	}
+
+	// Rebuilds a queue with another capacity, keeping the newest items.
+	// Returns the number of items that did not fit.
+	template <typename T>
+	static size_t resize_queue(SpscRingBuffer<T>& queue, size_t capacity) {
+		std::vector<T> items(queue.size());
+		items.resize(queue.pop_all(items.data(), items.size()));
+		queue.reset(capacity);
+		const size_t dropped = items.size() > capacity ? items.size() - capacity : 0;
+		for (size_t i = dropped; i < items.size(); ++i) {
+			queue.push(items[i]);
+		}
+		return dropped;
+	}
+
+	// Moves the queued items into the mailbox, only the newest survives.
+	// Returns the number of items it superseded.
+	template <typename T>
+	static size_t queue_to_mailbox(SpscRingBuffer<T>& queue, LatestValueMailbox<T>& mailbox) {
+		T item;
+		size_t count = 0;
+		while (queue.pop(item)) {
+			++count;
+		}
+		mailbox.reset();
+		if (count > 0) {
+			mailbox.publish(item);
+		}
+		return count > 0 ? count - 1 : 0;
+	}
 
+	// Moves an untaken mailbox value into the empty queue.
+	template <typename T>
+	static void mailbox_to_queue(LatestValueMailbox<T>& mailbox, SpscRingBuffer<T>& queue) {
+		T item;
+		if (mailbox.take(item)) {
+			queue.push(item);
+		}
+		mailbox.reset();
+	}
+
+	// One mailbox would only ever hold the camera that sent last.
+	static TrkQueueMode_t queue_mode_for(const TrkTrackingOptions_t& options, uint16_t port) {
+		if (options.demultiplexCameras && options.queueMode == TRK_QUEUE_LATEST_ONLY) {
+			log_message(TRK_LOG_WARNING, "UDP port %d demultiplexes cameras, it queues all samples instead of keeping only the latest.", port);
+			return TRK_QUEUE_FIFO;
+		}
+		return options.queueMode;
+	}
+
+	CameraTrackingInterface::CameraTrackingInterface()
+		: m_params_container(m_options.queueDepth)
+		, m_constants_container(m_options.queueDepth) {
+		m_camera_slots.reserve(MAX_CAMERAS_PER_PORT);
+		for (size_t i = 0; i < MAX_RECEIVE_PATHS; ++i) {
+			m_paths[i].owner = this;
+			m_paths[i].index = i;
+		}
 	}
 
 	TrkErrorType_t CameraTrackingInterface::check_error() {
@@ -23,218 +151,586 @@ namespace TrackMen {
 	}
 
 	bool CameraTrackingInterface::got_parameters() {
-		std::lock_guard<std::mutex> lock(m_params_mutex);
+		if (latest_only()) {
+			return m_params_mailbox.has_unread();
+		}
 		return !m_params_container.empty();
 	}
 
 	bool CameraTrackingInterface::got_constants() {
-		std::lock_guard<std::mutex> lock(m_constants_mutex);
+		if (latest_only()) {
+			return m_constants_mailbox.has_unread();
+		}
 		return !m_constants_container.empty();
 	}
 
-	void CameraTrackingInterface::start_camera_tracking(uint16_t port) {
-		m_port = port;
+	void CameraTrackingInterface::start_camera_tracking(uint16_t port, const TrkTrackingOptions_t& options) {
+		// A restart stops the previous receiver first.
+		stop_camera_tracking();
 
-		m_socket =
-			FUdpSocketBuilder(FString("CameraTrackingInterface ") + FString::FromInt(m_port))
-			.AsNonBlocking()
-			.AsReusable()
-			.BoundToPort(m_port)
-			.Build();
+		m_port = port;
+		m_options = options;
+		m_options.queueMode = queue_mode_for(options, port);
+		m_queue_mode.store(m_options.queueMode, std::memory_order_release);
+
+		// The receiver thread is not running, so the queues can be resized.
+		m_params_container.reset(m_options.queueDepth);
+		m_constants_container.reset(m_options.queueDepth);
+		m_params_mailbox.reset();
+		m_constants_mailbox.reset();
+		m_queued_samples = 0;
+		m_dropped_samples = 0;
+		m_blocked_pushes = 0;
+		m_superseded_samples = 0;
+		m_max_queue_depth = 0;
+		for (SequenceTracker& tracker : m_sequence_trackers) {
+			tracker.reset(m_options.sequencePolicy, m_options.reorderWindow);
+		}
+		m_camera_slots.clear();
+		m_camera_limit_logged = false;
+		for (DuplicateFilter& filter : m_duplicate_filters) {
+			filter.reset();
+		}
+		m_statistics.reset();
+		start_capture();
+
+		m_path_count = 1;
+		if (m_options.backupPort != 0) {
+			if (m_options.receiveBackend == TRK_BACKEND_REPLAY) {
+				// The capture already holds the datagrams of both paths.
+				log_message(TRK_LOG_WARNING, "Backup port %d of UDP port %d is not used while replaying a capture.", m_options.backupPort, port);
+			}
+			else {
+				m_path_count = 2;
+			}
+		}
 
-		if (m_socket) {
-			m_keep_thread_running = true;
+		m_keep_thread_running.store(true);
+		const bool primary_opened = open_receive_path(m_paths[0], port, m_options);
+		const bool backup_opened = (m_path_count > 1)
+			&& open_receive_path(m_paths[1], m_options.backupPort, backup_path_options(m_options));
+		if (m_path_count > 1 && primary_opened != backup_opened) {
+			log_message(TRK_LOG_WARNING, "Cannot open %s UDP port %d, receiving without redundancy on UDP port %d.",
+				primary_opened ? "backup" : "primary", primary_opened ? m_options.backupPort : port,
+				primary_opened ? port : m_options.backupPort);
 		}
 
-		m_receiver_worker = std::thread(std::bind(&CameraTrackingInterface::receiver_thread_func, this));
+		if (primary_opened || backup_opened) {
+			m_last_error = TRK_ERROR_NO_ERROR;
+		}
+		else {
+			m_keep_thread_running.store(false);
+			m_last_error = TRK_ERROR_CANNOT_CREATE_HANDLE_FOR_PORT;
+		}
 	}
 
 	void CameraTrackingInterface::stop_camera_tracking() {
-		m_keep_thread_running = false;
-		while (m_is_thread_running) {
-			FPlatformProcess::Sleep(0.f);
+		// The receivers see the flag right away: a thread of our own is woken
+		// through the backend or, in polling mode, the stop signal, and
+		// remove() returns only after a running on_readable().
+		m_keep_thread_running.store(false);
+		for (ReceivePath& path : m_paths) {
+			stop_receive_path(path);
 		}
-		if (m_receiver_worker.joinable()) {
-			m_receiver_worker.join();
-		}
-		close_socket();
+
+		stop_capture();
 		m_port = 0;
 	}
 
+	void CameraTrackingInterface::start_capture() {
+		if (m_options.captureFile.empty()) {
+			return;
+		}
+		if (m_recorder.open(m_options.captureFile)) {
+			log_message(TRK_LOG_DISPLAY, "Recording UDP port %d to %s", m_port, m_options.captureFile.c_str());
+		}
+		else {
+			log_message(TRK_LOG_WARNING, "Cannot create capture file %s, recording is disabled.", m_options.captureFile.c_str());
+		}
+	}
+
+	void CameraTrackingInterface::stop_capture() {
+		if (m_recorder.is_open()) {
+			m_recorder.close();
+			log_message(TRK_LOG_DISPLAY, "Recorded %llu datagrams of UDP port %d, %llu dropped%s.",
+				(unsigned long long)m_recorder.recorded_datagrams(), m_port, (unsigned long long)m_recorder.dropped_datagrams(),
+				m_recorder.write_failed() ? ", write error" : "");
+		}
+	}
+
+	void CameraTrackingInterface::update_options(const TrkTrackingOptions_t& options) {
+		if (options.receiverThread != m_options.receiverThread) {
+			m_options.receiverThread = options.receiverThread;
+			update_receiver_threads(options.receiverThread);
+		}
+
+		m_updating_options.store(true);
+		std::lock_guard<std::mutex> lock(m_receive_mutex);
+		m_updating_options.store(false);
+
+		m_options.overflowPolicy = options.overflowPolicy;
+		if (options.queueDepth != m_options.queueDepth) {
+			m_options.queueDepth = options.queueDepth;
+			m_dropped_samples.fetch_add(resize_queue(m_params_container, m_options.queueDepth), std::memory_order_relaxed);
+			resize_queue(m_constants_container, m_options.queueDepth);
+		}
+
+		const TrkQueueMode_t queueMode = queue_mode_for(options, m_port);
+		if (queueMode != m_options.queueMode) {
+			if (queueMode == TRK_QUEUE_LATEST_ONLY) {
+				m_superseded_samples.fetch_add(queue_to_mailbox(m_params_container, m_params_mailbox), std::memory_order_relaxed);
+				queue_to_mailbox(m_constants_container, m_constants_mailbox);
+			}
+			else {
+				mailbox_to_queue(m_params_mailbox, m_params_container);
+				mailbox_to_queue(m_constants_mailbox, m_constants_container);
+			}
+			m_options.queueMode = queueMode;
+			m_queue_mode.store(queueMode, std::memory_order_release);
+		}
+
+		if (options.sequencePolicy != m_options.sequencePolicy || options.reorderWindow != m_options.reorderWindow) {
+			m_options.sequencePolicy = options.sequencePolicy;
+			m_options.reorderWindow = options.reorderWindow;
+			for (SequenceTracker& tracker : m_sequence_trackers) {
+				tracker.set_policy(m_options.sequencePolicy, m_options.reorderWindow);
+			}
+		}
+
+		// The receivers record under the lock.
+		if (options.captureFile != m_options.captureFile) {
+			stop_capture();
+			m_options.captureFile = options.captureFile;
+			start_capture();
+		}
+	}
+
+	void CameraTrackingInterface::update_receiver_threads(const TrkThreadSettings_t& settings) {
+		for (size_t i = 0; i < m_path_count; ++i) {
+			ReceivePath& path = m_paths[i];
+			if (!path.backend) {
+				continue;
+			}
+			if (path.shared) {
+				if (settings.is_default()) {
+					continue;
+				}
+				// A tuned receiver gets a thread of its own, as if it had
+				// been started tuned. The socket stays open.
+				ReceiverService::get().remove(&path);
+				path.shared = false;
+				path.worker = std::thread(std::bind(&CameraTrackingInterface::receiver_thread_func, this, std::ref(path)));
+			}
+			if (apply_thread_settings(path.worker, settings, "receiver")) {
+				log_message(TRK_LOG_DISPLAY, "Receiver thread of UDP port %d: %s", path.port,
+					describe_thread_settings(settings).c_str());
+			}
+		}
+	}
+
+	bool CameraTrackingInterface::open_receive_path(ReceivePath& path, uint16_t port, const TrkTrackingOptions_t& options) {
+		path.port = port;
+		path.datagrams = 0;
+		path.firstArrivals = 0;
+		path.duplicates = 0;
+		path.leadNs = 0;
+		path.lastArrivalNs = 0;
+
+		path.backend = open_receive_backend(port, options);
+		if (!path.backend) {
+			return false;
+		}
+		if (!path.batch || path.batch->capacity() != options.receiveBatchSize) {
+			path.batch.reset(new DatagramBatch(options.receiveBatchSize));
+		}
+
+		// The legacy polling mode always keeps its own thread, and so does
+		// a source whose receiver is tuned: the shared thread serves all.
+		path.shared = (options.receiverThreading == TRK_RECEIVER_SHARED)
+			&& (options.wakeupMode == TRK_WAKEUP_EVENT)
+			&& options.receiverThread.is_default()
+			&& ReceiverService::get().add(path.backend->native_handle(), &path);
+
+		if (!path.shared) {
+			path.worker = std::thread(std::bind(&CameraTrackingInterface::receiver_thread_func, this, std::ref(path)));
+			if (!options.receiverThread.is_default()
+				&& apply_thread_settings(path.worker, options.receiverThread, "receiver")) {
+				log_message(TRK_LOG_DISPLAY, "Receiver thread of UDP port %d: %s", port,
+					describe_thread_settings(options.receiverThread).c_str());
+			}
+		}
+		return true;
+	}
+
+	void CameraTrackingInterface::stop_receive_path(ReceivePath& path) {
+		if (path.shared) {
+			ReceiverService::get().remove(&path);
+			path.shared = false;
+		}
+		else if (path.worker.joinable()) {
+			path.backend->interrupt();
+			path.stop_signal.notify();
+			path.worker.join();
+		}
+		if (path.backend) {
+			path.backend->close();
+			path.backend.reset();
+		}
+	}
+
 	TrkCameraParams_t CameraTrackingInterface::get_camera_parameters() {
-		std::lock_guard<std::mutex> lock(m_params_mutex);
-		TrkCameraParams_t tmp;
-		if (!m_params_container.empty()) {
-			tmp = m_params_container.front();
-			m_params_container.pop_front();
+		TrkCameraSample_t tmp;
+		if (latest_only()) {
+			m_params_mailbox.take(tmp);
 		}
-		return tmp;
+		else {
+			m_params_container.pop(tmp);
+		}
+		return tmp.params;
 	}
 
 	TrkCameraConstants_t CameraTrackingInterface::get_camera_constants() {
-		std::lock_guard<std::mutex> lock(m_constants_mutex);
 		TrkCameraConstants_t tmp;
-		if (!m_constants_container.empty()) {
-			tmp = m_constants_container.front();
-			m_constants_container.pop_front();
+		if (latest_only()) {
+			m_constants_mailbox.take(tmp);
+		}
+		else {
+			m_constants_container.pop(tmp);
 		}
 		return tmp;
 	}
 
-	void CameraTrackingInterface::close_socket() {
-		if (m_socket)
-		{
-			m_socket->Close();
-			ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(m_socket);
-			m_socket = nullptr;
+	size_t CameraTrackingInterface::get_camera_samples(TrkCameraSample_t* samples, size_t max_samples) {
+		if (latest_only()) {
+			return (max_samples > 0 && m_params_mailbox.take(samples[0])) ? 1 : 0;
 		}
+		return m_params_container.pop_all(samples, max_samples);
 	}
 
-	void CameraTrackingInterface::receiver_thread_func() {
-		m_is_thread_running = true;
+	TrkQueueStatistics_t CameraTrackingInterface::get_queue_statistics() const {
+		TrkQueueStatistics_t statistics;
+		statistics.queuedSamples = m_queued_samples.load(std::memory_order_relaxed);
+		statistics.droppedSamples = m_dropped_samples.load(std::memory_order_relaxed);
+		statistics.blockedPushes = m_blocked_pushes.load(std::memory_order_relaxed);
+		statistics.supersededSamples = m_superseded_samples.load(std::memory_order_relaxed);
+		if (latest_only()) {
+			statistics.queueDepth = m_params_mailbox.has_unread() ? 1 : 0;
+		}
+		else {
+			statistics.queueDepth = m_params_container.size();
+		}
+		statistics.maxQueueDepth = m_max_queue_depth.load(std::memory_order_relaxed);
+		return statistics;
+	}
+
+	TrkSequenceStatistics_t CameraTrackingInterface::get_sequence_statistics() const {
+		if (!m_options.demultiplexCameras) {
+			return m_sequence_trackers[0].statistics();
+		}
+
+		// Unused trackers count zero.
+		TrkSequenceStatistics_t total;
+		for (const SequenceTracker& tracker : m_sequence_trackers) {
+			const TrkSequenceStatistics_t camera = tracker.statistics();
+			total.samples += camera.samples;
+			total.missing += camera.missing;
+			total.duplicates += camera.duplicates;
+			total.late += camera.late;
+			total.reordered += camera.reordered;
+			total.rejected += camera.rejected;
+			total.wraps += camera.wraps;
+			total.resyncs += camera.resyncs;
+		}
+		return total;
+	}
 
-		auto loopend_callback = []() {
-			FPlatformProcess::Sleep(0.001f); // 1ms 
+	bool CameraTrackingInterface::wait_for_data(std::chrono::microseconds timeout) {
+		if (m_options.wakeupMode == TRK_WAKEUP_POLL) {
+			// Legacy behavior: the consumer looks for data every 10ms.
+			m_interrupt_signal.wait_for(std::chrono::milliseconds(10));
+			return got_parameters();
+		}
+		return m_data_signal.wait_for(timeout);
+	}
+
+	void CameraTrackingInterface::interrupt_wait() {
+		m_interrupt_signal.notify();
+		m_data_signal.notify();
+	}
+
+	void CameraTrackingInterface::set_data_callback(std::function<void()> callback) {
+		m_data_callback = std::move(callback);
+	}
+
+	bool CameraTrackingInterface::uses_shared_receiver() const {
+		return m_paths[0].shared || m_paths[1].shared;
+	}
+
+	TrkPathStatistics_t CameraTrackingInterface::get_path_statistics(size_t path) const {
+		TrkPathStatistics_t statistics;
+		if (path < MAX_RECEIVE_PATHS) {
+			const ReceivePath& source = m_paths[path];
+			statistics.datagrams = source.datagrams.load(std::memory_order_relaxed);
+			statistics.firstArrivals = source.firstArrivals.load(std::memory_order_relaxed);
+			statistics.duplicates = source.duplicates.load(std::memory_order_relaxed);
+			statistics.leadNs = source.leadNs.load(std::memory_order_relaxed);
+			statistics.lastArrivalNs = source.lastArrivalNs.load(std::memory_order_relaxed);
+		}
+		return statistics;
+	}
+
+	void CameraTrackingInterface::receiver_thread_func(ReceivePath& path) {
+		auto loopend_callback = [this, &path]() {
+			if (m_options.wakeupMode == TRK_WAKEUP_POLL) {
+				path.stop_signal.wait_for(std::chrono::milliseconds(1));
+			}
+			else {
+				// Block until the next datagram arrives. The timeout only bounds
+				// how long stop_camera_tracking() waits for this thread.
+				path.backend->wait(std::chrono::milliseconds(50));
+			}
 		};
 
-		static const int MAX_DATAGRAM_SIZE = 4096;
-		static const int GAME_ENGINE_MSG_BUFFERSIZE = 124;
+		for (; m_keep_thread_running.load(); loopend_callback()) {
+			receive_pending_datagrams(path);
+		}
+	}
+
+	void CameraTrackingInterface::ReceivePath::on_readable() {
+		owner->receive_pending_datagrams(*this);
+	}
+
+	void CameraTrackingInterface::signal_data() {
+		m_data_signal.notify();
+		if (m_data_callback) {
+			m_data_callback();
+		}
+	}
+
+	void CameraTrackingInterface::receive_pending_datagrams(ReceivePath& path) {
+		DatagramBatch& batch = *path.batch;
+		bool received = false;
+
+		for (;;) {
+			const size_t count = path.backend->receive(batch);
+			if (count > 0) {
+				std::lock_guard<std::mutex> lock(m_receive_mutex);
+				m_statistics.add_datagrams(count);
+				path.datagrams.fetch_add(count, std::memory_order_relaxed);
+				path.lastArrivalNs.store(batch.arrival_time_ns(count - 1), std::memory_order_relaxed);
+				m_arrival_path = path.index;
+				for (size_t i = 0; i < count; ++i) {
+					m_arrival_time_ns = batch.arrival_time_ns(i);
+					if (m_recorder.is_open()) {
+						m_recorder.record(path.port, m_arrival_time_ns, batch.data(i), (size_t)batch.length(i));
+					}
+					handle_datagram(batch.data(i), batch.length(i));
+				}
+				received = true;
+			}
+
+			// A batch that was not filled completely means the socket is drained.
+			if (count < batch.capacity()) {
+				break;
+			}
+		}
+
+		if (received) {
+			// The data callback must not run on the threads of both paths at once.
+			std::lock_guard<std::mutex> lock(m_receive_mutex);
+			signal_data();
+		}
+	}
+
+	void CameraTrackingInterface::handle_datagram(uint8_t* buffer, int32_t bytes_read) {
 		static const int PUBLIC_MSG_HEADERSIZE = 8;
 		static const char* PUBLIC_MAGIC = "DMC01";
 
-		uint8 buffer[MAX_DATAGRAM_SIZE];
-		int32 bytes_read = 0;
-
 		enum TrackingDataFormat {
 			GameEngineOpen,
 			Public,
 			Unknown
 		} trackingDataFormat = Unknown;
 
-		for (; m_keep_thread_running; loopend_callback()) {
+		if ((bytes_read == GameEngineWireLayout::size)
+			&& (load_le<uint32_t>(buffer) == TRK_GAME_ENGINE_MAGIC)) {
+			trackingDataFormat = GameEngineOpen;
+		}
+		else if ((bytes_read >= PUBLIC_MSG_HEADERSIZE)
+			&& (memcmp(buffer, PUBLIC_MAGIC, strlen(PUBLIC_MAGIC)) == 0)) {
+			trackingDataFormat = Public;
+		}
+		else {
+			// Not a TorqTrack packet
+			trackingDataFormat = Unknown;
+		}
 
-			m_socket->Recv(buffer, MAX_DATAGRAM_SIZE, bytes_read);
+		switch (trackingDataFormat) {
+			case GameEngineOpen:      parse_game_engine_format_parameters(buffer);        break;
+			case Public:              parse_public_format_parameters(buffer, bytes_read); break;
+			default:                                                                      break;
+		}
+	}
 
-			while (bytes_read > 0) {
-
-				if ((bytes_read == GAME_ENGINE_MSG_BUFFERSIZE)
-					&& (*((uint32_t*)&buffer[0]) == 0x544d4531)) {
-					trackingDataFormat = GameEngineOpen;
-				}
-				else if ((bytes_read >= PUBLIC_MSG_HEADERSIZE)
-					&& (memcmp(buffer, PUBLIC_MAGIC, strlen(PUBLIC_MAGIC)) == 0)) {
-					trackingDataFormat = Public;
-				}
-				else {
-					// Not a TorqTrack packet
-					trackingDataFormat = Unknown;
-				}
+	void CameraTrackingInterface::enqueue_parameters(const TrkCameraParams_t& params) {
+		size_t slot;
+		if (!camera_slot_for(params.id, slot)) {
+			m_dropped_samples.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+		if (m_path_count > 1 && !first_arrival(slot, (uint32_t)params.counter)) {
+			return;
+		}
 
-				switch (trackingDataFormat) {
-					case GameEngineOpen:      parse_game_engine_format_parameters(buffer);        break;
-					case Public:              parse_public_format_parameters(buffer, bytes_read); break;
-					default:                                                                      break;
-				}
+		TrkCameraSample_t sample;
+		sample.params = params;
+		sample.arrivalTimeNs = m_arrival_time_ns;
+		m_statistics.add_parsed();
 
-				m_socket->Recv(buffer, MAX_DATAGRAM_SIZE, bytes_read);
+		SequenceTracker& tracker = m_sequence_trackers[slot];
+		const size_t released = tracker.push(sample);
+		for (size_t i = 0; i < released; ++i) {
+			enqueue_sample(tracker.released(i));
+		}
+	}
+
+	bool CameraTrackingInterface::camera_slot_for(unsigned camera_id, size_t& slot) {
+		if (!m_options.demultiplexCameras) {
+			slot = 0;
+			return true;
+		}
+
+		const auto found = m_camera_slots.find(camera_id);
+		if (found != m_camera_slots.end()) {
+			slot = found->second;
+			return true;
+		}
+		if (m_camera_slots.size() == MAX_CAMERAS_PER_PORT) {
+			if (!m_camera_limit_logged) {
+				m_camera_limit_logged = true;
+				log_message(TRK_LOG_WARNING, "UDP port %d carries more than %d cameras, the samples of camera id %u and further ones are dropped.",
+					m_port, (int)MAX_CAMERAS_PER_PORT, camera_id);
 			}
+			return false;
 		}
-		m_is_thread_running = false;
+		slot = m_camera_slots.size();
+		m_camera_slots.emplace(camera_id, slot);
+		return true;
 	}
 
-	void CameraTrackingInterface::parse_game_engine_format_parameters(uint8* buffer) {
+	bool CameraTrackingInterface::first_arrival(size_t slot, uint32_t counter) {
+		ReceivePath& path = m_paths[m_arrival_path];
+		size_t first_path;
+		int64_t first_arrival_ns;
+		if (m_duplicate_filters[slot].first_arrival(counter, m_arrival_path, m_arrival_time_ns, first_path, first_arrival_ns)) {
+			path.firstArrivals.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		}
+
+		path.duplicates.fetch_add(1, std::memory_order_relaxed);
+		if (first_path != m_arrival_path) {
+			m_paths[first_path].leadNs.fetch_add(m_arrival_time_ns - first_arrival_ns, std::memory_order_relaxed);
+		}
+		return false;
+	}
+
+	void CameraTrackingInterface::enqueue_sample(const TrkCameraSample_t& sample) {
+		if (latest_only()) {
+			// A sample the consumer did not pick up yet is stale now.
+			if (m_params_mailbox.publish(sample)) {
+				m_superseded_samples.fetch_add(1, std::memory_order_relaxed);
+			}
+			m_queued_samples.fetch_add(1, std::memory_order_relaxed);
+			m_max_queue_depth.store(1, std::memory_order_relaxed);
+			return;
+		}
+
+		bool blocked = false;
+		while (!m_params_container.push(sample)) {
+			switch (m_options.overflowPolicy) {
+			case TRK_OVERFLOW_KEEP_LATEST:
+				m_dropped_samples.fetch_add(m_params_container.discard_all(), std::memory_order_relaxed);
+				break;
+			case TRK_OVERFLOW_BLOCK:
+				if (!m_keep_thread_running.load() || m_updating_options.load()) {
+					m_dropped_samples.fetch_add(1, std::memory_order_relaxed);
+					return;
+				}
+				if (!blocked) {
+					blocked = true;
+					m_blocked_pushes.fetch_add(1, std::memory_order_relaxed);
+				}
+				if (m_data_callback) {
+					// The consumer runs on this thread, let it make room.
+					m_data_callback();
+				}
+				else {
+					m_data_signal.notify();
+					std::this_thread::sleep_for(std::chrono::microseconds(100));
+				}
+				break;
+			case TRK_OVERFLOW_DROP_OLDEST:
+			default:
+				m_dropped_samples.fetch_add(m_params_container.discard_oldest(), std::memory_order_relaxed);
+				break;
+			}
+		}
+
+		m_queued_samples.fetch_add(1, std::memory_order_relaxed);
+		const size_t depth = m_params_container.size();
+		if (depth > m_max_queue_depth.load(std::memory_order_relaxed)) {
+			m_max_queue_depth.store(depth, std::memory_order_relaxed);
+		}
+	}
+
+	void CameraTrackingInterface::enqueue_constants(const TrkCameraConstants_t& constants) {
+		// Only the most recent constants matter, never wait for the consumer.
+		if (latest_only()) {
+			m_constants_mailbox.publish(constants);
+			return;
+		}
+		while (!m_constants_container.push(constants)) {
+			m_constants_container.discard_oldest();
+		}
+	}
+
+	void CameraTrackingInterface::parse_game_engine_format_parameters(uint8_t* buffer) {
 		// TODO: set format
 
-		TrkCameraParams_t tmpParams;
-		TrkCameraConstants_t tmpConstants;
-
-		int index = 8;
-		tmpParams.counter = *((uint32_t*)&buffer[index]);
-		index += 4;
-
-		tmpParams.t.e.x = *((double*)&buffer[index]); // pos_x
-		index += 8;
-		tmpParams.t.e.y = *((double*)&buffer[index]); // pos_y
-		index += 8;
-		tmpParams.t.e.z = *((double*)&buffer[index]); // pos_z
-		index += 8;
-
-		tmpParams.t.e.pan = *((double*)&buffer[index]); // pan
-		index += 8;
-		tmpParams.t.e.tilt = *((double*)&buffer[index]); // tilt
-		index += 8;
-		tmpParams.t.e.roll = *((double*)&buffer[index]); // roll
-		index += 8;
-
-		tmpParams.fov = *((double*)&buffer[index]); // horiz_fov
-		index += 8;
-
-		tmpParams.centerX = *((double*)&buffer[index]); // centerX
-		index += 8;
-		tmpParams.centerY = *((double*)&buffer[index]); // centerY
-		index += 8;
-
-		tmpParams.k1 = *((double*)&buffer[index]); // k1
-		index += 8;
-		tmpParams.k2 = *((double*)&buffer[index]); // k2
-		index += 8;
-
-		tmpParams.focdist = *((double*)&buffer[index]); // focdist
-		index += 8;
-
-		tmpConstants.chipWidth = *((double*)&buffer[index]); // chipWidth
-		index += 8;
-		tmpConstants.chipHeight = *((double*)&buffer[index]); // chipHeight
+		TrkGameEngineMessage_t message;
+		if (!GameEngineWireLayout::decode(buffer, GameEngineWireLayout::size, message)) {
+			return;
+		}
 
-		std::lock_guard<std::mutex> paramslock(m_params_mutex);
-		std::lock_guard<std::mutex> constantslock(m_constants_mutex);
-		m_params_container.push_back(tmpParams);
-		m_constants_container.push_back(tmpConstants);
+		// Constants first, so a consumer that sees the parameters also sees
+		// the matching chip size.
+		enqueue_constants(message.constants);
+		enqueue_parameters(message.params);
 	}
 
-	void CameraTrackingInterface::parse_public_format_parameters(uint8* buffer, int32 len) {
+	void CameraTrackingInterface::parse_public_format_parameters(uint8_t* buffer, int32_t len) {
 		static const int trkNetHeaderType = 6;
 		static const int trkNetHeaderFormat = 7;
 		static const int trkNetHeaderSize = 8;
 
-		static const int trkMatrix = 0x0000;
-		static const int trkEuler = 0x0001;
-
-		uint8 typeChar = buffer[trkNetHeaderType];
-		uint8 formatChar = buffer[trkNetHeaderFormat];
+		uint8_t typeChar = buffer[trkNetHeaderType];
+		uint8_t formatChar = buffer[trkNetHeaderFormat];
 
 		if (typeChar == 'C') {
 			// Constants
 			if (formatChar == 'B') {
 				// Binary format
-				if (len != trkNetHeaderSize + sizeof(TrkCameraConstants_t))
+				TrkCameraConstants_t tmpConstants;
+				if (!BinaryCameraConstantsWireLayout::decode(buffer + trkNetHeaderSize, len - trkNetHeaderSize, tmpConstants))
 					return;
-				TrkCameraConstants_t tmpConstants;
-				memcpy((void*)&(tmpConstants),
-					(const void*)(buffer + trkNetHeaderSize),
-					sizeof(TrkCameraConstants_t));
-				std::lock_guard<std::mutex> lock(m_constants_mutex);
-				m_constants_container.push_back(tmpConstants);
+				enqueue_constants(tmpConstants);
 			}
 			else {
 				// ASCII format
-				std::stringstream ss;
-				ss.write((char*)(buffer + trkNetHeaderSize), len - trkNetHeaderSize);
-				// Use temporary to ensure consistent data if stream fails.
+				// Use temporary to ensure consistent data if parsing fails.
 				TrkCameraConstants_t tmpConst;
-				ss >> tmpConst.imageWidth
-					>> tmpConst.imageHeight
-					>> tmpConst.blankLeft
-					>> tmpConst.blankRight
-					>> tmpConst.blankTop
-					>> tmpConst.blankBottom
-					>> tmpConst.chipWidth
-					>> tmpConst.chipHeight
-					>> tmpConst.fakeChipWidth
-					>> tmpConst.fakeChipHeight;
-				if (!ss.fail()) {
-					std::lock_guard<std::mutex> lock(m_constants_mutex);
-					m_constants_container.push_back(tmpConst);
+				if (parse_ascii_camera_constants((const char*)(buffer + trkNetHeaderSize), len - trkNetHeaderSize, tmpConst)) {
+					enqueue_constants(tmpConst);
 				}
 			}
 		}
@@ -242,52 +738,19 @@ namespace TrackMen {
 			// Parameters
 			if (formatChar == 'B') {
 				// Binary format
-				if (len != trkNetHeaderSize + sizeof(TrkCameraParams_t))
+				TrkCameraParams_t tmpParams;
+				if (!BinaryCameraParamsWireLayout::decode(buffer + trkNetHeaderSize, len - trkNetHeaderSize, tmpParams))
 					return;
-				TrkCameraParams_t tmpParams;
-				memcpy((void*)&(tmpParams),
-					(const void*)(buffer + trkNetHeaderSize),
-					sizeof(TrkCameraParams_t));
 
-				std::lock_guard<std::mutex> lock(m_params_mutex);
-				m_params_container.push_back(tmpParams);
+				enqueue_parameters(tmpParams);
 			}
 			else {
 				// ASCII format
 
-				// Use temporary to ensure consistent data if stream fails.
+				// Use temporary to ensure consistent data if parsing fails.
 				TrkCameraParams_t tmpParams;
-
-				std::stringstream ss;
-				ss.write((char*)(buffer + trkNetHeaderSize), len - trkNetHeaderSize);
-
-				if (buffer[trkNetHeaderSize] == 'I') {
-					ss >> tmpParams.id;
-				}
-
-				ss >> std::hex >> tmpParams.format >> std::dec;
-				if (tmpParams.format & trkEuler) {
-					ss >> tmpParams.t.e.x
-						>> tmpParams.t.e.y
-						>> tmpParams.t.e.z
-						>> tmpParams.t.e.pan
-						>> tmpParams.t.e.tilt
-						>> tmpParams.t.e.roll;
-				}
-				else {
-					ss >> tmpParams.t.m[0][0] >> tmpParams.t.m[0][1] >> tmpParams.t.m[0][2] >> tmpParams.t.m[0][3]
-						>> tmpParams.t.m[1][0] >> tmpParams.t.m[1][1] >> tmpParams.t.m[1][2] >> tmpParams.t.m[1][3]
-						>> tmpParams.t.m[2][0] >> tmpParams.t.m[2][1] >> tmpParams.t.m[2][2] >> tmpParams.t.m[2][3];
-					tmpParams.t.m[0][3] = tmpParams.t.m[1][3] = tmpParams.t.m[2][3] = 0.0;
-					tmpParams.t.m[3][3] = 1.0;
-				}
-				ss >> tmpParams.fov >> tmpParams.centerX >> tmpParams.centerY
-					>> tmpParams.k1 >> tmpParams.k2 >> tmpParams.focdist
-					>> tmpParams.aperture >> tmpParams.counter;
-
-				if (!ss.fail()) {
-					std::lock_guard<std::mutex> lock(m_params_mutex);
-					m_params_container.push_back(tmpParams);
+				if (parse_ascii_camera_params((const char*)(buffer + trkNetHeaderSize), len - trkNetHeaderSize, tmpParams)) {
+					enqueue_parameters(tmpParams);
 				}
 			}
 		}
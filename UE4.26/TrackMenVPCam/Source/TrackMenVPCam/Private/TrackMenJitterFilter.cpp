@@ -0,0 +1,81 @@
+/* Copyright 2021 TrackMen GmbH <mail@trackmen.de> */
+
+#include "TrackMenJitterFilter.h"
+
+#include <cmath>
+
+namespace TrackMen {
+
+	namespace {
+
+		static const double TWO_PI = 6.28318530717958647692;
+	}
+
+	void JitterFilter::configure(const TrkJitterFilterSettings_t& settings) {
+		m_enabled = settings.enabled;
+		for (size_t c = 0; c < CHANNELS; ++c) {
+			const TrkFilterChannel_t& channel = settings.channels[c];
+			const bool filtered = channel.minCutoffHz > 0.0;
+			m_min_cutoff[c] = filtered ? TWO_PI * channel.minCutoffHz : 0.0;
+			m_beta[c] = filtered && channel.beta > 0.0 ? TWO_PI * channel.beta : 0.0;
+			m_pass[c] = filtered ? 0.0 : 1.0;
+		}
+		m_derivative_cutoff = TWO_PI * (settings.derivativeCutoffHz > 0.0 ? settings.derivativeCutoffHz : 1.0);
+		reset();
+	}
+
+	void JitterFilter::reset() {
+		m_started = false;
+		m_clock.reset();
+	}
+
+	void JitterFilter::filter(TrkCameraFrame_t& frame, uint32_t counter, int64_t arrival_ns) {
+		if (!m_enabled) {
+			return;
+		}
+
+		double measured[CHANNELS];
+		frame_to_channels(frame, measured);
+		const double dt = m_clock.advance(counter, arrival_ns);
+		if (!m_started || dt < 0.0) {
+			start(measured);
+			return;
+		}
+		if (dt <= 1e-6) {
+			channels_to_frame(m_value, frame);
+			return;
+		}
+
+		for (size_t c = 0; c < CHANNELS; ++c) {
+			if (is_angle_channel(c)) {
+				measured[c] = unwrap_angle(measured[c], m_value[c]);
+			}
+			const double max_speed = channel_max_speed(c);
+			if (max_speed > 0.0 && std::fabs(measured[c] - m_value[c]) > max_speed * dt) {
+				start(measured);
+				return;
+			}
+		}
+
+		// The smoothing factor of a cutoff w (rad/s) is w dt / (w dt + 1).
+		const double wd = m_derivative_cutoff * dt;
+		const double derivative_alpha = wd / (wd + 1.0);
+		const double rate = 1.0 / dt;
+		for (size_t c = 0; c < CHANNELS; ++c) {
+			const double speed = (measured[c] - m_value[c]) * rate;
+			m_speed[c] += derivative_alpha * (speed - m_speed[c]);
+			const double w = (m_min_cutoff[c] + m_beta[c] * std::fabs(m_speed[c])) * dt;
+			const double alpha = w / (w + 1.0) * (1.0 - m_pass[c]) + m_pass[c];
+			m_value[c] += alpha * (measured[c] - m_value[c]);
+		}
+		channels_to_frame(m_value, frame);
+	}
+
+	void JitterFilter::start(const double* measured) {
+		m_started = true;
+		for (size_t c = 0; c < CHANNELS; ++c) {
+			m_value[c] = measured[c];
+			m_speed[c] = 0.0;
+		}
+	}
+}
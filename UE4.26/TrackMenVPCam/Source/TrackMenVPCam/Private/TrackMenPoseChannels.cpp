@@ -0,0 +1,75 @@
+/* Copyright 2021 TrackMen GmbH <mail@trackmen.de> */
+
+#include "TrackMenPoseChannels.h"
+
+#include <cmath>
+
+namespace TrackMen {
+
+	namespace {
+
+		const double MAX_SPEED[TRK_POSE_CHANNELS] = { 2000.0, 2000.0, 2000.0, 1000.0, 1000.0, 1000.0, 0.0, 0.0 };
+	}
+
+	void frame_to_channels(const TrkCameraFrame_t& frame, double* channels) {
+		channels[TRK_CHANNEL_POSITION_X] = frame.position[0];
+		channels[TRK_CHANNEL_POSITION_Y] = frame.position[1];
+		channels[TRK_CHANNEL_POSITION_Z] = frame.position[2];
+		channels[TRK_CHANNEL_PITCH] = frame.pitch;
+		channels[TRK_CHANNEL_YAW] = frame.yaw;
+		channels[TRK_CHANNEL_ROLL] = frame.roll;
+		channels[TRK_CHANNEL_FOCAL_LENGTH] = frame.focalLength;
+		channels[TRK_CHANNEL_FOCUS_DISTANCE] = frame.focusDistance;
+	}
+
+	void channels_to_frame(const double* channels, TrkCameraFrame_t& frame) {
+		frame.position[0] = channels[TRK_CHANNEL_POSITION_X];
+		frame.position[1] = channels[TRK_CHANNEL_POSITION_Y];
+		frame.position[2] = channels[TRK_CHANNEL_POSITION_Z];
+		frame.pitch = std::remainder(channels[TRK_CHANNEL_PITCH], 360.0);
+		frame.yaw = std::remainder(channels[TRK_CHANNEL_YAW], 360.0);
+		frame.roll = std::remainder(channels[TRK_CHANNEL_ROLL], 360.0);
+		if (channels[TRK_CHANNEL_FOCAL_LENGTH] > 0.0) {
+			frame.focalLength = channels[TRK_CHANNEL_FOCAL_LENGTH];
+		}
+		frame.focusDistance = channels[TRK_CHANNEL_FOCUS_DISTANCE] > 0.0 ? channels[TRK_CHANNEL_FOCUS_DISTANCE] : 0.0;
+	}
+
+	double unwrap_angle(double angle, double reference) {
+		return reference + std::remainder(angle - reference, 360.0);
+	}
+
+	double channel_max_speed(size_t channel) {
+		return channel < TRK_POSE_CHANNELS ? MAX_SPEED[channel] : 0.0;
+	}
+
+	double SampleClock::advance(uint32_t counter, int64_t arrival_ns) {
+		const int64_t elapsed_ns = arrival_ns - m_arrival_ns;
+		const int32_t steps = (int32_t)(counter - m_counter);
+		const bool restart = !m_started || elapsed_ns < 0 || elapsed_ns > MAX_GAP_NS || steps < 0;
+		m_started = true;
+		m_counter = counter;
+		m_arrival_ns = arrival_ns;
+		if (restart) {
+			return -1.0;
+		}
+
+		if (steps == 0) {
+			// A sender that does not count.
+			return (double)elapsed_ns * 1e-9;
+		}
+
+		// Samples the network delivered in a burst must not pull the period
+		// far off.
+		int64_t interval_ns = elapsed_ns / steps;
+		if (m_period_ns > 0) {
+			interval_ns = interval_ns < m_period_ns / 2 ? m_period_ns / 2
+				: (interval_ns > 2 * m_period_ns ? 2 * m_period_ns : interval_ns);
+			m_period_ns += (interval_ns - m_period_ns) / 16;
+		}
+		else {
+			m_period_ns = interval_ns;
+		}
+		return (double)steps * (double)m_period_ns * 1e-9;
+	}
+}
@@ -0,0 +1,232 @@
+/* Copyright 2021 TrackMen GmbH <mail@trackmen.de> */
+
+#include "TrackMenReceiveBackend.h"
+#include "TrackMenCaptureFormat.h"
+
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <string.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define TRK_HAS_MMAP 1
+#endif
+
+namespace TrackMen {
+
+	namespace {
+
+		/**
+		* Read-only view of a whole file. Memory mapped where available, so
+		* hours of capture do not have to fit into memory; read into a buffer
+		* elsewhere.
+		*/
+		class MappedFile {
+		public:
+			~MappedFile() { close(); }
+
+			bool open(const std::string& path) {
+				close();
+#if defined(TRK_HAS_MMAP)
+				const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+				if (fd < 0) {
+					return false;
+				}
+				struct stat status;
+				if (::fstat(fd, &status) != 0 || status.st_size <= 0) {
+					::close(fd);
+					return false;
+				}
+				void* memory = ::mmap(nullptr, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+				::close(fd);
+				if (memory == MAP_FAILED) {
+					return false;
+				}
+				::madvise(memory, (size_t)status.st_size, MADV_SEQUENTIAL);
+				m_data = (const uint8_t*)memory;
+				m_size = (size_t)status.st_size;
+				m_mapped = true;
+				return true;
+#else
+				std::ifstream file(path.c_str(), std::ios::in | std::ios::binary);
+				if (!file) {
+					return false;
+				}
+				m_buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+				m_data = m_buffer.data();
+				m_size = m_buffer.size();
+				return m_size > 0;
+#endif
+			}
+
+			void close() {
+#if defined(TRK_HAS_MMAP)
+				if (m_mapped) {
+					::munmap((void*)m_data, m_size);
+					m_mapped = false;
+				}
+#endif
+				m_buffer.clear();
+				m_data = nullptr;
+				m_size = 0;
+			}
+
+			const uint8_t* data() const { return m_data; }
+			size_t size() const { return m_size; }
+
+		private:
+			const uint8_t* m_data = nullptr;
+			size_t m_size = 0;
+			bool m_mapped = false;
+			std::vector<uint8_t> m_buffer;
+		};
+	}
+
+	/**
+	* Plays back a capture file. A datagram is due when as much time has
+	* passed since open() (divided by the speed) as between the first record
+	* and its own; its arrival time is the due time, so the samples carry the
+	* recorded spacing even if the consumer is late.
+	*/
+	class ReplayReceiveBackend : public ReceiveBackend {
+	public:
+		~ReplayReceiveBackend() override { close(); }
+
+		const char* name() const override { return "replay"; }
+
+		bool open(uint16_t, const TrkTrackingOptions_t& options) override {
+			close();
+
+			TrkCaptureHeader_t header;
+			if (!m_file.open(options.replayFile)
+				|| m_file.size() < CaptureHeaderWireLayout::size
+				|| !CaptureHeaderWireLayout::decode(m_file.data(), CaptureHeaderWireLayout::size, header)
+				|| header.version != TRK_CAPTURE_VERSION) {
+				m_file.close();
+				return false;
+			}
+
+			m_speed = options.replaySpeed > 0.0 ? options.replaySpeed : 0.0;
+			m_loop = options.replayLoop;
+			{
+				std::lock_guard<std::mutex> lock(m_interrupt_mutex);
+				m_interrupted = false;
+			}
+			rewind();
+			return true;
+		}
+
+		void close() override {
+			m_file.close();
+			m_has_record = false;
+		}
+
+		bool wait(std::chrono::microseconds timeout) override {
+			if (!m_has_record) {
+				sleep_for(timeout);
+				return false;
+			}
+			const int64_t wait_ns = due_time_ns() - steady_time_ns();
+			if (wait_ns <= 0) {
+				return true;
+			}
+			if (wait_ns > (int64_t)timeout.count() * 1000) {
+				sleep_for(timeout);
+				return false;
+			}
+			return sleep_for(std::chrono::nanoseconds(wait_ns));
+		}
+
+		void interrupt() override {
+			{
+				std::lock_guard<std::mutex> lock(m_interrupt_mutex);
+				m_interrupted = true;
+			}
+			m_interrupt_condition.notify_all();
+		}
+
+		size_t receive(DatagramBatch& batch) override {
+			batch.clear();
+			size_t count = 0;
+			const int64_t now_ns = steady_time_ns();
+
+			while (count < batch.capacity() && m_has_record) {
+				const int64_t due_ns = due_time_ns();
+				if (due_ns > now_ns) {
+					break;
+				}
+				memcpy(batch.data(count), m_file.data() + m_offset + CaptureRecordWireLayout::size, m_record.length);
+				batch.set(count, (int32_t)m_record.length, m_speed > 0.0 ? due_ns : now_ns);
+				++count;
+
+				m_offset += CaptureRecordWireLayout::size + m_record.length;
+				read_record();
+				if (!m_has_record && m_loop) {
+					rewind();
+				}
+			}
+
+			batch.set_size(count);
+			return count;
+		}
+
+	private:
+		// Returns false if interrupted.
+		template <typename Duration>
+		bool sleep_for(Duration duration) {
+			std::unique_lock<std::mutex> lock(m_interrupt_mutex);
+			return !m_interrupt_condition.wait_for(lock, duration, [this]() { return m_interrupted; });
+		}
+
+		// Starts over at the first record, which is due right away.
+		void rewind() {
+			m_offset = CaptureHeaderWireLayout::size;
+			read_record();
+			m_first_arrival_ns = m_record.arrivalTimeNs;
+			m_start_ns = steady_time_ns();
+		}
+
+		// Decodes the record header at m_offset. A truncated last record, as
+		// left by a crash while recording, ends the capture.
+		void read_record() {
+			m_has_record = false;
+			if (m_file.size() - m_offset < CaptureRecordWireLayout::size) {
+				return;
+			}
+			CaptureRecordWireLayout::decode(m_file.data() + m_offset, CaptureRecordWireLayout::size, m_record);
+			m_has_record = m_record.length <= TRK_MAX_DATAGRAM_SIZE
+				&& m_file.size() - m_offset - CaptureRecordWireLayout::size >= m_record.length;
+		}
+
+		int64_t due_time_ns() const {
+			if (m_speed <= 0.0) {
+				return m_start_ns;
+			}
+			return m_start_ns + (int64_t)((double)(m_record.arrivalTimeNs - m_first_arrival_ns) / m_speed);
+		}
+
+		MappedFile m_file;
+		size_t m_offset = 0;
+		TrkCaptureRecord_t m_record;
+		bool m_has_record = false;
+
+		double m_speed = 1.0;
+		bool m_loop = false;
+		int64_t m_start_ns = 0;
+		int64_t m_first_arrival_ns = 0;
+
+		std::mutex m_interrupt_mutex;
+		std::condition_variable m_interrupt_condition;
+		bool m_interrupted = false;
+	};
+
+	std::unique_ptr<ReceiveBackend> create_replay_receive_backend() {
+		return std::unique_ptr<ReceiveBackend>(new ReplayReceiveBackend());
+	}
+}
@@ -0,0 +1,224 @@
+/* Copyright 2021 TrackMen GmbH <mail@trackmen.de> */
+
+#include "TrackMenSequenceTracker.h"
+
+namespace TrackMen {
+
+	// Distance of b after a, negative if b is older.
+	static int32_t counter_distance(uint32_t a, uint32_t b) {
+		return (int32_t)(b - a);
+	}
+
+	SequenceTracker::SequenceTracker() {
+		reset(m_policy, m_reorder_window);
+	}
+
+	void SequenceTracker::reset(TrkSequencePolicy_t policy, size_t reorder_window) {
+		set_policy(policy, reorder_window);
+
+		m_samples = 0;
+		m_missing = 0;
+		m_duplicates = 0;
+		m_late = 0;
+		m_reordered = 0;
+		m_rejected = 0;
+		m_wraps = 0;
+		m_resyncs = 0;
+	}
+
+	void SequenceTracker::set_policy(TrkSequencePolicy_t policy, size_t reorder_window) {
+		add(m_rejected, m_held_count);
+
+		m_policy = policy;
+		m_reorder_window = reorder_window < MAX_REORDER_WINDOW ? reorder_window : MAX_REORDER_WINDOW;
+
+		m_started = false;
+		m_static_counter = false;
+		m_rejected_in_row = 0;
+
+		// One more than the window: a push may overfill it by one sample.
+		m_held.resize(m_reorder_window + 1);
+		m_held_count = 0;
+		m_released.resize(m_reorder_window + 2);
+		m_released_count = 0;
+	}
+
+	size_t SequenceTracker::push(const TrkCameraSample_t& sample) {
+		const uint32_t counter = (uint32_t)sample.params.counter;
+		m_released_count = 0;
+		add(m_samples);
+
+		if (m_static_counter) {
+			if (counter == m_highest) {
+				release(sample);
+				return m_released_count;
+			}
+			// The sender started counting.
+			m_static_counter = false;
+			m_started = false;
+		}
+
+		const bool repeated = m_started && counter == m_last_counter;
+		m_last_counter = counter;
+		const Arrival arrival = classify(counter);
+
+		bool accept;
+		switch (m_policy) {
+		case TRK_SEQUENCE_COUNT_ONLY:
+			accept = true;
+			break;
+		case TRK_SEQUENCE_REORDER:
+			accept = (arrival == ARRIVAL_FIRST)
+				|| ((arrival == ARRIVAL_IN_ORDER || arrival == ARRIVAL_LATE) && counter_distance(m_next, counter) >= 0);
+			break;
+		case TRK_SEQUENCE_DROP_LATE:
+		default:
+			accept = (arrival == ARRIVAL_FIRST) || (arrival == ARRIVAL_IN_ORDER);
+			break;
+		}
+
+		if (!accept) {
+			// A sender that does not count at all repeats the counter of the
+			// sample before; one that restarted close to where it was gets
+			// rejected a few times in a row. Either way the newest sample
+			// cannot be trusted anymore.
+			if (repeated && counter == m_highest) {
+				m_static_counter = true;
+			}
+			else {
+				add(m_rejected);
+				if (++m_rejected_in_row < RESYNC_AFTER_REJECTS) {
+					return 0;
+				}
+				add(m_resyncs);
+			}
+			release_held();
+			start(counter);
+			m_next = counter + 1;
+			release(sample);
+			return m_released_count;
+		}
+
+		m_rejected_in_row = 0;
+
+		if (m_policy != TRK_SEQUENCE_REORDER) {
+			release(sample);
+			return m_released_count;
+		}
+
+		if (arrival == ARRIVAL_FIRST) {
+			// Whatever was held belongs to the counter sequence before.
+			release_held();
+			m_next = counter;
+		}
+		else if (arrival == ARRIVAL_LATE) {
+			add(m_reordered);
+		}
+		hold(sample);
+
+		// Pass on the consecutive counters, and give up on the oldest gap
+		// when the window is full.
+		for (;;) {
+			const bool front_is_next = m_held_count > 0 && (uint32_t)m_held[0].params.counter == m_next;
+			if (!front_is_next && m_held_count <= m_reorder_window) {
+				break;
+			}
+			release(m_held[0]);
+			m_next = (uint32_t)m_held[0].params.counter + 1;
+			for (size_t i = 1; i < m_held_count; ++i) {
+				m_held[i - 1] = m_held[i];
+			}
+			--m_held_count;
+		}
+		return m_released_count;
+	}
+
+	TrkSequenceStatistics_t SequenceTracker::statistics() const {
+		TrkSequenceStatistics_t statistics;
+		statistics.samples = m_samples.load(std::memory_order_relaxed);
+		statistics.missing = m_missing.load(std::memory_order_relaxed);
+		statistics.duplicates = m_duplicates.load(std::memory_order_relaxed);
+		statistics.late = m_late.load(std::memory_order_relaxed);
+		statistics.reordered = m_reordered.load(std::memory_order_relaxed);
+		statistics.rejected = m_rejected.load(std::memory_order_relaxed);
+		statistics.wraps = m_wraps.load(std::memory_order_relaxed);
+		statistics.resyncs = m_resyncs.load(std::memory_order_relaxed);
+		return statistics;
+	}
+
+	SequenceTracker::Arrival SequenceTracker::classify(uint32_t counter) {
+		if (!m_started) {
+			start(counter);
+			return ARRIVAL_FIRST;
+		}
+
+		const int32_t distance = counter_distance(m_highest, counter);
+		if (distance > 0) {
+			m_history = distance < 64 ? ((m_history << distance) | 1) : 1;
+			add(m_missing, (uint64_t)distance - 1);
+			if (counter < m_highest) {
+				add(m_wraps);
+			}
+			m_highest = counter;
+			return ARRIVAL_IN_ORDER;
+		}
+
+		if (distance == 0) {
+			add(m_duplicates);
+			return ARRIVAL_DUPLICATE;
+		}
+
+		if (distance > -64) {
+			const uint64_t bit = (uint64_t)1 << -distance;
+			if (m_history & bit) {
+				add(m_duplicates);
+				return ARRIVAL_DUPLICATE;
+			}
+			m_history |= bit;
+			add(m_late);
+			if (m_missing.load(std::memory_order_relaxed) > 0) {
+				m_missing.store(m_missing.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+			}
+			return ARRIVAL_LATE;
+		}
+
+		if (distance <= -RESYNC_DISTANCE) {
+			add(m_resyncs);
+			start(counter);
+			return ARRIVAL_FIRST;
+		}
+
+		add(m_late);
+		return ARRIVAL_TOO_OLD;
+	}
+
+	void SequenceTracker::start(uint32_t counter) {
+		m_started = true;
+		m_highest = counter;
+		m_history = 1;
+		m_rejected_in_row = 0;
+	}
+
+	void SequenceTracker::hold(const TrkCameraSample_t& sample) {
+		// Insertion sort by distance from the next expected counter.
+		const int32_t distance = counter_distance(m_next, (uint32_t)sample.params.counter);
+		size_t index = m_held_count;
+		while (index > 0 && counter_distance(m_next, (uint32_t)m_held[index - 1].params.counter) > distance) {
+			m_held[index] = m_held[index - 1];
+			--index;
+		}
+		m_held[index] = sample;
+		++m_held_count;
+	}
+
+	void SequenceTracker::release_held() {
+		for (size_t i = 0; i < m_held_count; ++i) {
+			release(m_held[i]);
+		}
+		m_held_count = 0;
+	}
+
+	void SequenceTracker::release(const TrkCameraSample_t& sample) {
+		m_released[m_released_count++] = sample;
+	}
+}
@@ -0,0 +1,42 @@
+/* Copyright 2021 TrackMen GmbH <mail@trackmen.de> */
+
+#pragma once
+
+#if defined(__linux__)
+
+#include "TrackMenCameraTrackingTypes.h"
+
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+
+namespace TrackMen {
+
+	// Space for the SCM_TIMESTAMPNS control message of one datagram.
+	static const size_t TRK_TIMESTAMP_CONTROL_SIZE = CMSG_SPACE(sizeof(timespec));
+
+	// Enables SO_TIMESTAMPNS if the options ask for kernel timestamps.
+	inline bool enable_socket_timestamps(int socket, const TrkTrackingOptions_t& options) {
+		if (options.timestampSource != TRK_TIMESTAMP_KERNEL) {
+			return false;
+		}
+		int enable = 1;
+		return setsockopt(socket, SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(enable)) == 0;
+	}
+
+	// Finds the receive timestamp (CLOCK_REALTIME) in the control data of a
+	// received message.
+	inline bool read_socket_timestamp_ns(const msghdr& message, int64_t& realtime_ns) {
+		for (const cmsghdr* control = CMSG_FIRSTHDR(&message); control; control = CMSG_NXTHDR((msghdr*)&message, (cmsghdr*)control)) {
+			if (control->cmsg_level == SOL_SOCKET && control->cmsg_type == SCM_TIMESTAMPNS) {
+				timespec ts;
+				memcpy(&ts, CMSG_DATA(control), sizeof(ts));
+				realtime_ns = (int64_t)ts.tv_sec * 1000000000 + (int64_t)ts.tv_nsec;
+				return true;
+			}
+		}
+		return false;
+	}
+}
+
+#endif
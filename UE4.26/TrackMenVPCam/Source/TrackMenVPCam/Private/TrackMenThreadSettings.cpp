@@ -0,0 +1,130 @@
+/* Copyright 2021 TrackMen GmbH <mail@trackmen.de> */
+
+#include "TrackMenThreadSettings.h"
+#include "TrackMenLog.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#if defined(_WIN32) && defined(TRACKMEN_HEADLESS)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(_WIN32)
+// The engine wrapper keeps the Windows macros out of the unity build.
+#include "Windows/AllowWindowsPlatformTypes.h"
+#include "Windows/WindowsHWrapper.h"
+#include "Windows/HideWindowsPlatformTypes.h"
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+namespace TrackMen {
+
+	namespace {
+
+		const char* priority_name(TrkThreadPriority_t priority) {
+			switch (priority) {
+			case TRK_THREAD_PRIORITY_HIGH:
+				return "high";
+			case TRK_THREAD_PRIORITY_TIME_CRITICAL:
+				return "time critical";
+			default:
+				return "default";
+			}
+		}
+
+		bool apply_priority(std::thread& thread, TrkThreadPriority_t priority) {
+#if defined(_WIN32)
+			const int value = priority == TRK_THREAD_PRIORITY_DEFAULT ? THREAD_PRIORITY_NORMAL
+				: priority == TRK_THREAD_PRIORITY_HIGH ? THREAD_PRIORITY_HIGHEST : THREAD_PRIORITY_TIME_CRITICAL;
+			return SetThreadPriority((HANDLE)thread.native_handle(), value) != 0;
+#else
+			if (priority == TRK_THREAD_PRIORITY_DEFAULT) {
+				sched_param param;
+				memset(&param, 0, sizeof(param));
+				return pthread_setschedparam(thread.native_handle(), SCHED_OTHER, &param) == 0;
+			}
+
+			// Round robin at the bottom of the real-time range is enough to
+			// preempt every normal thread; FIFO near the middle stays below
+			// the threaded interrupt handlers (50) that deliver the datagrams.
+			const int policy = priority == TRK_THREAD_PRIORITY_HIGH ? SCHED_RR : SCHED_FIFO;
+			sched_param param;
+			memset(&param, 0, sizeof(param));
+			param.sched_priority = priority == TRK_THREAD_PRIORITY_HIGH ? sched_get_priority_min(policy) : 49;
+			if (param.sched_priority > sched_get_priority_max(policy)) {
+				param.sched_priority = sched_get_priority_max(policy);
+			}
+			return pthread_setschedparam(thread.native_handle(), policy, &param) == 0;
+#endif
+		}
+
+		// A mask of 0 gives the thread the CPUs of the process back.
+		bool apply_affinity(std::thread& thread, uint64_t mask) {
+#if defined(_WIN32)
+			if (mask == 0) {
+				DWORD_PTR process_mask = 0;
+				DWORD_PTR system_mask = 0;
+				if (!GetProcessAffinityMask(GetCurrentProcess(), &process_mask, &system_mask)) {
+					return false;
+				}
+				return SetThreadAffinityMask((HANDLE)thread.native_handle(), process_mask) != 0;
+			}
+			return SetThreadAffinityMask((HANDLE)thread.native_handle(), (DWORD_PTR)mask) != 0;
+#elif defined(__linux__)
+			cpu_set_t cpus;
+			if (mask == 0) {
+				// The main thread keeps the CPUs the process was started with.
+				return sched_getaffinity(getpid(), sizeof(cpus), &cpus) == 0
+					&& pthread_setaffinity_np(thread.native_handle(), sizeof(cpus), &cpus) == 0;
+			}
+			CPU_ZERO(&cpus);
+			for (int cpu = 0; cpu < 64; ++cpu) {
+				if (mask & ((uint64_t)1 << cpu)) {
+					CPU_SET(cpu, &cpus);
+				}
+			}
+			return pthread_setaffinity_np(thread.native_handle(), sizeof(cpus), &cpus) == 0;
+#else
+			// macOS only knows affinity tags, no CPU masks.
+			(void)thread;
+			return mask == 0;
+#endif
+		}
+	}
+
+	bool apply_thread_settings(std::thread& thread, const TrkThreadSettings_t& settings, const char* thread_name) {
+		if (!thread.joinable()) {
+			return true;
+		}
+
+		const bool priority_applied = apply_priority(thread, settings.priority);
+		const bool affinity_applied = apply_affinity(thread, settings.affinityMask);
+		if (!priority_applied) {
+			log_message(TRK_LOG_WARNING, "Cannot set %s priority of the %s thread, it keeps the default priority.",
+				priority_name(settings.priority), thread_name);
+		}
+		if (!affinity_applied) {
+			log_message(TRK_LOG_WARNING, "Cannot restrict the %s thread to CPUs 0x%llx, it runs on any CPU.",
+				thread_name, (unsigned long long)settings.affinityMask);
+		}
+		return priority_applied && affinity_applied;
+	}
+
+	std::string describe_thread_settings(const TrkThreadSettings_t& settings) {
+		std::string description = priority_name(settings.priority);
+		if (settings.affinityMask != 0) {
+			char cpus[32];
+			snprintf(cpus, sizeof(cpus), ", CPUs 0x%llx", (unsigned long long)settings.affinityMask);
+			description += cpus;
+		}
+		return description;
+	}
+}
@@ -0,0 +1,216 @@
+/* Copyright 2021 TrackMen GmbH <mail@trackmen.de> */
+
+#pragma once
+
+#if defined(__linux__)
+
+#include "TrackMenCameraTrackingTypes.h"
+#include "TrackMenLog.h"
+
+#include <arpa/inet.h>
+#include <ifaddrs.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+
+namespace TrackMen {
+
+	/**
+	* poll() on a descriptor that interrupt() can end from another thread,
+	* so a receiver thread blocked in wait() stops right away. An
+	* interruption stays in effect until reset().
+	*/
+	class InterruptibleWait {
+	public:
+		~InterruptibleWait() { close(); }
+
+		bool open() {
+			close();
+			m_wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+			return m_wake_fd >= 0;
+		}
+
+		void close() {
+			if (m_wake_fd >= 0) {
+				::close(m_wake_fd);
+				m_wake_fd = -1;
+			}
+		}
+
+		// True if fd became readable, false on timeout or interruption.
+		bool wait(int fd, std::chrono::microseconds timeout) {
+			pollfd descriptors[2];
+			descriptors[0].fd = fd;
+			descriptors[0].events = POLLIN;
+			descriptors[0].revents = 0;
+			descriptors[1].fd = m_wake_fd;
+			descriptors[1].events = POLLIN;
+			descriptors[1].revents = 0;
+			const int timeout_ms = (int)((timeout.count() + 999) / 1000);
+			if (::poll(descriptors, m_wake_fd >= 0 ? 2 : 1, timeout_ms) <= 0) {
+				return false;
+			}
+			return !(descriptors[1].revents & POLLIN) && (descriptors[0].revents & POLLIN);
+		}
+
+		void interrupt() {
+			const uint64_t one = 1;
+			ssize_t written = ::write(m_wake_fd, &one, sizeof(one));
+			(void)written;
+		}
+
+		void reset() {
+			uint64_t value;
+			ssize_t bytes = ::read(m_wake_fd, &value, sizeof(value));
+			(void)bytes;
+		}
+
+	private:
+		int m_wake_fd = -1;
+	};
+
+	// Index of the interface given by IPv4 address or name, 0 lets the
+	// routing table choose. Returns false if there is no such interface.
+	inline bool find_interface_index(const std::string& interface_name, unsigned& index) {
+		index = 0;
+		if (interface_name.empty()) {
+			return true;
+		}
+
+		in_addr address;
+		if (inet_pton(AF_INET, interface_name.c_str(), &address) != 1) {
+			index = if_nametoindex(interface_name.c_str());
+			return index != 0;
+		}
+
+		ifaddrs* interfaces = nullptr;
+		if (getifaddrs(&interfaces) != 0) {
+			return false;
+		}
+		for (const ifaddrs* entry = interfaces; entry && index == 0; entry = entry->ifa_next) {
+			if (entry->ifa_addr && entry->ifa_addr->sa_family == AF_INET
+				&& ((const sockaddr_in*)entry->ifa_addr)->sin_addr.s_addr == address.s_addr) {
+				index = if_nametoindex(entry->ifa_name);
+			}
+		}
+		freeifaddrs(interfaces);
+		return index != 0;
+	}
+
+	// Joins TrkTrackingOptions_t::multicastGroup, source-specific if
+	// multicastSource is set.
+	inline bool join_multicast_group(int socket, const TrkTrackingOptions_t& options) {
+		unsigned interface_index;
+		if (!find_interface_index(options.multicastInterface, interface_index)) {
+			return false;
+		}
+
+		sockaddr_in group;
+		memset(&group, 0, sizeof(group));
+		group.sin_family = AF_INET;
+		if (inet_pton(AF_INET, options.multicastGroup.c_str(), &group.sin_addr) != 1
+			|| !IN_MULTICAST(ntohl(group.sin_addr.s_addr))) {
+			return false;
+		}
+
+		// Only the joined groups, not every group another socket joined on
+		// the same port.
+		int all = 0;
+		setsockopt(socket, IPPROTO_IP, IP_MULTICAST_ALL, &all, sizeof(all));
+
+		if (options.multicastSource.empty()) {
+			group_req request;
+			memset(&request, 0, sizeof(request));
+			request.gr_interface = interface_index;
+			memcpy(&request.gr_group, &group, sizeof(group));
+			return setsockopt(socket, IPPROTO_IP, MCAST_JOIN_GROUP, &request, sizeof(request)) == 0;
+		}
+
+		sockaddr_in source;
+		memset(&source, 0, sizeof(source));
+		source.sin_family = AF_INET;
+		if (inet_pton(AF_INET, options.multicastSource.c_str(), &source.sin_addr) != 1) {
+			return false;
+		}
+		group_source_req request;
+		memset(&request, 0, sizeof(request));
+		request.gsr_interface = interface_index;
+		memcpy(&request.gsr_group, &group, sizeof(group));
+		memcpy(&request.gsr_source, &source, sizeof(source));
+		return setsockopt(socket, IPPROTO_IP, MCAST_JOIN_SOURCE_GROUP, &request, sizeof(request)) == 0;
+	}
+
+	// Applies TrkTrackingOptions_t::receiveBufferSize and busyPollMicroseconds.
+	// Neither is fatal: the socket works with the defaults, only worse under
+	// load, so failures are logged and ignored.
+	inline void apply_socket_tuning(int socket, uint16_t port, const TrkTrackingOptions_t& options) {
+		if (options.receiveBufferSize > 0) {
+			// SO_RCVBUF is capped at net.core.rmem_max, SO_RCVBUFFORCE is not
+			// but needs CAP_NET_ADMIN. The kernel reports twice the size to
+			// account for its bookkeeping.
+			const int size = options.receiveBufferSize;
+			if (setsockopt(socket, SOL_SOCKET, SO_RCVBUFFORCE, &size, sizeof(size)) != 0) {
+				setsockopt(socket, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+			}
+			int effective = 0;
+			socklen_t length = sizeof(effective);
+			getsockopt(socket, SOL_SOCKET, SO_RCVBUF, &effective, &length);
+			if (effective / 2 < size) {
+				log_message(TRK_LOG_WARNING, "UDP port %d got a receive buffer of %d bytes instead of %d, raise net.core.rmem_max.",
+					port, effective / 2, size);
+			}
+		}
+
+		if (options.busyPollMicroseconds > 0) {
+			// Values above net.core.busy_read need CAP_NET_ADMIN.
+			const int microseconds = options.busyPollMicroseconds;
+			if (setsockopt(socket, SOL_SOCKET, SO_BUSY_POLL, &microseconds, sizeof(microseconds)) != 0) {
+				log_message(TRK_LOG_WARNING, "Cannot busy poll UDP port %d for %d us, raise net.core.busy_read.", port, microseconds);
+			}
+		}
+	}
+
+	// Non-blocking UDP socket bound to the port, reusable so that several
+	// receivers on one host can share a multicast stream. With a multicast
+	// group the socket is bound to the group address and joins it, else to
+	// TrkTrackingOptions_t::bindAddress if set. Returns -1 on failure.
+	inline int open_udp_socket(uint16_t port, const TrkTrackingOptions_t& options) {
+		const int udp_socket = ::socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+		if (udp_socket < 0) {
+			return -1;
+		}
+
+		int reuse = 1;
+		setsockopt(udp_socket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+		apply_socket_tuning(udp_socket, port, options);
+
+		sockaddr_in address;
+		memset(&address, 0, sizeof(address));
+		address.sin_family = AF_INET;
+		address.sin_addr.s_addr = htonl(INADDR_ANY);
+		address.sin_port = htons(port);
+		if (!options.multicastGroup.empty()) {
+			inet_pton(AF_INET, options.multicastGroup.c_str(), &address.sin_addr);
+		}
+		else if (!options.bindAddress.empty()
+			&& inet_pton(AF_INET, options.bindAddress.c_str(), &address.sin_addr) != 1) {
+			::close(udp_socket);
+			return -1;
+		}
+
+		if (::bind(udp_socket, (const sockaddr*)&address, sizeof(address)) != 0
+			|| (!options.multicastGroup.empty() && !join_multicast_group(udp_socket, options))) {
+			::close(udp_socket);
+			return -1;
+		}
+		return udp_socket;
+	}
+}
+
+#endif
@@ -0,0 +1,39 @@
+/* Copyright 2021 TrackMen GmbH <mail@trackmen.de> */
+
+#pragma once
+
+#include "TrackMenCameraTrackingTypes.h"
+
+namespace TrackMen {
+
+	/**
+	* Camera frame in Unreal conventions without Unreal types: left-handed,
+	* Z up, centimeters, rotation in degrees. LiveLinkCameraSource copies it
+	* into FTrackMenCameraFrameData.
+	*/
+	struct TrkCameraFrame_t {
+		double position[3] = { 0.0, 0.0, 0.0 }; /* X, Y, Z */
+		double pitch = 0.0;
+		double yaw = 0.0;
+		double roll = 0.0;
+
+		double focalLength = 0.0;   /* mm */
+		double focusDistance = 0.0; /* cm */
+		double aperture = 0.0;
+
+		double lensDistortion[2] = { 0.0, 0.0 }; /* k1, k2 */
+		double centerShift[2] = { 0.0, 0.0 };    /* mm */
+		double chipSize[2] = { 0.0, 0.0 };       /* mm */
+	};
+
+	/**
+	* Rotation of the 4x4 tracker matrix with the semantics of FMatrix::Rotator():
+	* pitch and yaw from the X axis, roll from the Y and Z axes.
+	*/
+	void matrix_to_rotator(const double m[4][4], double& pitch, double& yaw, double& roll);
+
+	/**
+	* Converts tracker parameters and constants to an Unreal camera frame.
+	*/
+	void convert_camera_frame(const TrkCameraParams_t& params, const TrkCameraConstants_t& constants, TrkCameraFrame_t& frame);
+}
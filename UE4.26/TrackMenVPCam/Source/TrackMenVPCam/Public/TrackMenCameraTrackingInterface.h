@@ -2,82 +2,47 @@
 
 #pragma once
 
-#include <deque>
+#include "TrackMenCameraTrackingTypes.h"
+#include "TrackMenCaptureRecorder.h"
+#include "TrackMenDataSignal.h"
+#include "TrackMenDuplicateFilter.h"
+#include "TrackMenMailbox.h"
+#include "TrackMenReceiveBackend.h"
+#include "TrackMenReceiverService.h"
+#include "TrackMenRingBuffer.h"
+#include "TrackMenSequenceTracker.h"
+#include "TrackMenSourceStatistics.h"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
 #include <mutex>
 #include <thread>
+#include <unordered_map>
 #include <stdint.h>
 
-class FSocket;
-
 namespace TrackMen {
 
-	// TODO: use ring buffer for better performance
-	template <typename T>
-	using DequeType = std::deque<T>;
-
-	enum TrkErrorType_t {
-		TRK_ERROR_NO_ERROR,
-		TRK_ERROR_CANNOT_CREATE_HANDLE_FOR_PORT,
-		TRK_ERROR_NO_HANDLE_ON_THIS_PORT,
-		NUM_ERRORS
-	};
-
-	union TrkTransform_t  {
-		double m[4][4]; /* m [j] [i] is matrix element */
-						/* in row i, column j */
-		struct {
-			double x;
-			double y;
-			double z;
-			double pan;
-			double tilt;
-			double roll;
-		} e; /* "Euler" angles */
-
-	};
-
-	struct TrkCameraParams_t {
-		unsigned id = 0;/* == 0 if not explicitly specified */
-
-		unsigned format = 0; /* bit mask of format options */
-
-		TrkTransform_t t; /* coordinate transformation */
-		double fov = 20.0;     /* field of view or image distance */
-		double centerX = 0.0; /* center shift */
-		double centerY = 0.0;
-
-		double k1 = 0.0; /* distorsion coefficients */
-		double k2 = 0.0;
-
-		double focdist = 100000.0; /* depth of field simulation */
-		double aperture = 1.0;
-
-		unsigned long counter = 0;
-
-	};
-
-	struct TrkCameraConstants_t {
-		unsigned id = 0; /* == 0 if not explicitly specified */
-
-		int imageWidth = 1920;
-		int imageHeight = 1080;
-		int blankLeft = 0;
-		int blankRight = 0;
-		int blankTop = 0;
-		int blankBottom = 0;
-
-		double chipWidth = 9.6;
-		double chipHeight = 5.4;
-		double fakeChipWidth = 9.6;
-		double fakeChipHeight = 5.4;
-
-	};
-
 	/**
 	* Tracking interface for UDP camera data
+	*
+	* Engine independent; messages go through log_message().
+	*
+	* Datagrams are received either on a thread of this interface or, in
+	* TRK_RECEIVER_SHARED mode, on the process-wide ReceiverService thread.
+	* With TrkTrackingOptions_t::backupPort set, a second receive path gets
+	* the same stream and the first copy of every sample is passed on.
 	*/
 	class CameraTrackingInterface {
 	public:
+		// Camera ids told apart in TrkTrackingOptions_t::demultiplexCameras
+		// mode. Samples of further cameras on the port are dropped.
+		static const size_t MAX_CAMERAS_PER_PORT = 16;
+
+		// The port and the backup port.
+		static const size_t MAX_RECEIVE_PATHS = 2;
+
 		CameraTrackingInterface();
 		virtual ~CameraTrackingInterface() { stop_camera_tracking(); }
 
@@ -85,28 +50,152 @@ namespace TrackMen {
 		bool got_parameters();
 		bool got_constants();
 
-		void start_camera_tracking(uint16_t port);
+		void start_camera_tracking(uint16_t port, const TrkTrackingOptions_t& options = TrkTrackingOptions_t());
 		void stop_camera_tracking();
+
+		// Applies the options that can change while the source receives,
+		// without reopening its sockets: the receiver thread settings, the
+		// queue depth, the queue mode, the overflow policy, the sequence
+		// policy and the capture file. The others only take effect with the
+		// next start_camera_tracking(). A resized queue keeps the newest queued
+		// items, and so does a queue that turns into a mailbox. Nothing may
+		// be popped meanwhile, except by the data callback, which runs under
+		// the same lock; got_parameters(), got_constants() and
+		// get_queue_statistics() may be called.
+		void update_options(const TrkTrackingOptions_t& options);
 		TrkCameraParams_t get_camera_parameters();
 		TrkCameraConstants_t get_camera_constants();
 
-	private:
-		void close_socket();
-		void receiver_thread_func();
-		void parse_game_engine_format_parameters(uint8* buffer);
-		void parse_public_format_parameters(uint8* buffer, int32 len);
+		// Pops up to max_samples queued samples, oldest first. Returns the
+		// number of samples written to samples. In demultiplexing mode the
+		// cameras share the queue, params.id tells them apart.
+		size_t get_camera_samples(TrkCameraSample_t* samples, size_t max_samples);
+		TrkQueueStatistics_t get_queue_statistics() const;
+		TrkSequenceStatistics_t get_sequence_statistics() const;
 
-		uint16_t m_port = 0;
+		// Throughput and latency counters of this source. The receiver counts
+		// datagrams and parsed samples, the consumer adds the pushed samples.
+		SourceStatistics& statistics() { return m_statistics; }
+		const SourceStatistics& statistics() const { return m_statistics; }
+
+		// Blocks the consumer until the receiver queued new data or the timeout
+		// expired. In TRK_WAKEUP_POLL mode this is a plain sleep.
+		bool wait_for_data(std::chrono::microseconds timeout);
+
+		// Makes a wait_for_data() that is blocked, or the next one, return
+		// right away, so a consumer thread can be stopped without waiting
+		// for its timeout. May be called from any thread.
+		void interrupt_wait();
+
+		// Called on the receiver thread after new data was queued, so the
+		// consumer can drain the queue without a thread of its own. Set before
+		// start_camera_tracking(); the callback must not stop the tracking.
+		void set_data_callback(std::function<void()> callback);
 
-		std::thread m_receiver_worker;
-		bool m_keep_thread_running = false;
-		bool m_is_thread_running = false;
-		FSocket* m_socket;
+		// True if the datagrams are received by the ReceiverService.
+		bool uses_shared_receiver() const;
 
-		DequeType<TrkCameraParams_t> m_params_container;
-		DequeType<TrkCameraConstants_t> m_constants_container;
-		std::mutex m_params_mutex;
-		std::mutex m_constants_mutex;
+		// Number of receive paths, 2 with a backup port. Path 0 is the port
+		// passed to start_camera_tracking(), path 1 the backup port.
+		size_t receive_path_count() const { return m_path_count; }
+		TrkPathStatistics_t get_path_statistics(size_t path) const;
+
+	private:
+		/**
+		* One socket of the source, read by a thread of its own or by the
+		* ReceiverService.
+		*/
+		struct ReceivePath : ReceiverService::Client {
+			CameraTrackingInterface* owner = nullptr;
+			size_t index = 0;
+			uint16_t port = 0;
+			std::unique_ptr<ReceiveBackend> backend;
+			std::unique_ptr<DatagramBatch> batch;
+			std::thread worker;
+			bool shared = false;
+			DataSignal stop_signal; /* ends the sleeps of the worker in TRK_WAKEUP_POLL mode */
+
+			// Written by the receiver of the source, read by any thread.
+			std::atomic<uint64_t> datagrams{ 0 };
+			std::atomic<uint64_t> firstArrivals{ 0 };
+			std::atomic<uint64_t> duplicates{ 0 };
+			std::atomic<int64_t> leadNs{ 0 };
+			std::atomic<int64_t> lastArrivalNs{ 0 };
+
+			void on_readable() override;
+		};
+
+		bool open_receive_path(ReceivePath& path, uint16_t port, const TrkTrackingOptions_t& options);
+		void stop_receive_path(ReceivePath& path);
+		void update_receiver_threads(const TrkThreadSettings_t& settings);
+		void start_capture();
+		void stop_capture();
+		void signal_data();
+		void receiver_thread_func(ReceivePath& path);
+		void receive_pending_datagrams(ReceivePath& path);
+		void handle_datagram(uint8_t* buffer, int32_t bytes_read);
+		void parse_game_engine_format_parameters(uint8_t* buffer);
+		void parse_public_format_parameters(uint8_t* buffer, int32_t len);
+		void enqueue_parameters(const TrkCameraParams_t& params);
+		bool camera_slot_for(unsigned camera_id, size_t& slot);
+		bool first_arrival(size_t slot, uint32_t counter);
+		void enqueue_sample(const TrkCameraSample_t& sample);
+		void enqueue_constants(const TrkCameraConstants_t& constants);
+
+		uint16_t m_port = 0;
+		TrkTrackingOptions_t m_options;
+
+		ReceivePath m_paths[MAX_RECEIVE_PATHS];
+		size_t m_path_count = 1;
+		std::atomic<bool> m_keep_thread_running{ false };
+		std::function<void()> m_data_callback;
+
+		// Serializes the parsing of the paths, which may run on two threads,
+		// and update_options(). The flag makes a receiver that waits for room
+		// in the queue give up the lock to an update.
+		std::mutex m_receive_mutex;
+		std::atomic<bool> m_updating_options{ false };
+
+		// Written by the receiver thread, read by the consumer of this interface.
+		SpscRingBuffer<TrkCameraSample_t> m_params_container;
+		SpscRingBuffer<TrkCameraConstants_t> m_constants_container;
+		DataSignal m_data_signal;
+		DataSignal m_interrupt_signal; /* ends the fixed sleeps of the consumer in TRK_WAKEUP_POLL mode */
+
+		// Used instead of the queues in TRK_QUEUE_LATEST_ONLY mode.
+		LatestValueMailbox<TrkCameraSample_t> m_params_mailbox;
+		LatestValueMailbox<TrkCameraConstants_t> m_constants_mailbox;
+
+		// The queue mode in use. update_options() changes it under the
+		// receive lock, the consumer and the statistics read it without.
+		std::atomic<TrkQueueMode_t> m_queue_mode{ TRK_QUEUE_FIFO };
+		bool latest_only() const { return m_queue_mode.load(std::memory_order_acquire) == TRK_QUEUE_LATEST_ONLY; }
+
+		// Arrival time and receive path of the datagram that is currently parsed.
+		int64_t m_arrival_time_ns = 0;
+		size_t m_arrival_path = 0;
+
+		// Records the raw datagrams if TrkTrackingOptions_t::captureFile is set.
+		CaptureRecorder m_recorder;
+
+		// Tracker counter checks, applied before the samples are queued. In
+		// demultiplexing mode every camera has its own, the receiver thread
+		// assigns them on first sight of an id. They are all preallocated, so
+		// get_sequence_statistics() can read them from any thread.
+		SequenceTracker m_sequence_trackers[MAX_CAMERAS_PER_PORT];
+		std::unordered_map<unsigned, size_t> m_camera_slots;
+
+		// Merge of the receive paths, per camera like the trackers.
+		DuplicateFilter m_duplicate_filters[MAX_CAMERAS_PER_PORT];
+		bool m_camera_limit_logged = false;
+
+		// Queue statistics, written by the receiver thread only.
+		std::atomic<uint64_t> m_queued_samples{ 0 };
+		std::atomic<uint64_t> m_dropped_samples{ 0 };
+		std::atomic<uint64_t> m_blocked_pushes{ 0 };
+		std::atomic<uint64_t> m_superseded_samples{ 0 };
+		std::atomic<size_t> m_max_queue_depth{ 0 };
+		SourceStatistics m_statistics;
 
 		TrkErrorType_t m_last_error = TRK_ERROR_NO_ERROR;
 	};
@@ -0,0 +1,54 @@
+/* Copyright 2021 TrackMen GmbH <mail@trackmen.de> */
+
+#pragma once
+
+// File format of raw datagram captures.
+//
+// A capture is a file header followed by records, each a record header and
+// the datagram bytes, without padding in between. Records are in arrival
+// order. All values are little-endian.
+
+#include "TrackMenWireFormat.h"
+
+#include <stdint.h>
+
+namespace TrackMen {
+
+	static const uint32_t TRK_CAPTURE_MAGIC = 0x50414354; /* "TCAP" */
+	static const uint32_t TRK_CAPTURE_VERSION = 1;
+
+	struct TrkCaptureHeader_t {
+		uint32_t version = TRK_CAPTURE_VERSION;
+		int64_t startSteadyNs = 0;   /* steady clock of the recording host when the capture started */
+		int64_t startRealtimeNs = 0; /* wall clock at the same instant, nanoseconds since 1970 */
+	};
+
+	struct TrkCaptureRecord_t {
+		int64_t arrivalTimeNs = 0; /* steady clock, see TrkCameraSample_t */
+		uint32_t length = 0;       /* datagram bytes following the record header */
+		uint16_t port = 0;         /* UDP port the datagram was received on */
+	};
+
+	namespace WireAccess {
+		TRK_WIRE_ACCESS(CaptureVersion, m.version);
+		TRK_WIRE_ACCESS(CaptureStartSteady, m.startSteadyNs);
+		TRK_WIRE_ACCESS(CaptureStartRealtime, m.startRealtimeNs);
+		TRK_WIRE_ACCESS(RecordArrivalTime, m.arrivalTimeNs);
+		TRK_WIRE_ACCESS(RecordLength, m.length);
+		TRK_WIRE_ACCESS(RecordPort, m.port);
+	}
+
+	typedef WireLayout<24,
+		WireConstant<uint32_t, 0, TRK_CAPTURE_MAGIC>,
+		WireField<uint32_t, 4, WireAccess::CaptureVersion>,
+		WireField<int64_t, 8, WireAccess::CaptureStartSteady>,
+		WireField<int64_t, 16, WireAccess::CaptureStartRealtime>
+	> CaptureHeaderWireLayout;
+
+	// 2 unused bytes at the end.
+	typedef WireLayout<16,
+		WireField<int64_t, 0, WireAccess::RecordArrivalTime>,
+		WireField<uint32_t, 8, WireAccess::RecordLength>,
+		WireField<uint16_t, 12, WireAccess::RecordPort>
+	> CaptureRecordWireLayout;
+}
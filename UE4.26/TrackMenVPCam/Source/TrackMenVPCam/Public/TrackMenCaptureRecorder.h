@@ -0,0 +1,85 @@
+/* Copyright 2021 TrackMen GmbH <mail@trackmen.de> */
+
+#pragma once
+
+#include "TrackMenCaptureFormat.h"
+#include "TrackMenDataSignal.h"
+
+#include <atomic>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace TrackMen {
+
+	/**
+	* Appends raw datagrams to a capture file, see TrackMenCaptureFormat.h.
+	*
+	* record() copies the datagram into one of two preallocated pages and
+	* never blocks: a full page is handed to a writer thread and recording
+	* continues in the other one. If the writer still holds the other page,
+	* the datagram is dropped and counted. A page is also handed over when a
+	* datagram arrives FLUSH_INTERVAL_NS after the first one in the page, so
+	* a crash loses little data at low rates.
+	*
+	* record() must be called from one thread at a time, open() and close()
+	* while no record() is running.
+	*/
+	class CaptureRecorder {
+	public:
+		static const size_t PAGE_BYTES = 1 << 20;
+		static const int64_t FLUSH_INTERVAL_NS = 250000000;
+
+		CaptureRecorder();
+		~CaptureRecorder();
+
+		// Truncates the file and writes the capture header.
+		bool open(const std::string& path);
+
+		// Writes what is left and closes the file.
+		void close();
+
+		bool is_open() const { return m_open; }
+
+		void record(uint16_t port, int64_t arrival_time_ns, const uint8_t* data, size_t length);
+
+		uint64_t recorded_datagrams() const { return m_recorded.load(std::memory_order_relaxed); }
+		uint64_t dropped_datagrams() const { return m_dropped.load(std::memory_order_relaxed); }
+		bool write_failed() const { return m_write_failed.load(std::memory_order_relaxed); }
+
+	private:
+		CaptureRecorder(const CaptureRecorder&) = delete;
+		CaptureRecorder& operator=(const CaptureRecorder&) = delete;
+
+		struct Page {
+			std::vector<uint8_t> data;
+			size_t size = 0;
+			int64_t first_arrival_ns = 0;
+
+			// Set by the recorder when the page is handed to the writer,
+			// cleared by the writer when the page was written.
+			std::atomic<bool> full{ false };
+		};
+
+		void hand_over();
+		void writer_thread_func();
+		void write_full_pages();
+
+		std::ofstream m_file;
+		bool m_open = false;
+		std::thread m_writer;
+		std::atomic<bool> m_keep_writing{ false };
+		DataSignal m_page_signal;
+
+		Page m_pages[2];
+		size_t m_current = 0; /* page record() writes to */
+		size_t m_next_write = 0; /* page the writer expects next */
+
+		std::atomic<uint64_t> m_recorded{ 0 };
+		std::atomic<uint64_t> m_dropped{ 0 };
+		std::atomic<bool> m_write_failed{ false };
+	};
+}
@@ -0,0 +1,55 @@
+/* Copyright 2021 TrackMen GmbH <mail@trackmen.de> */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+namespace TrackMen {
+
+	/**
+	* Wakes a consumer thread when new samples were queued.
+	*
+	* notify() only touches the mutex when a consumer is actually blocked in
+	* wait_for(), so the producer stays lock-free while the consumer is busy.
+	* Notifications are sticky: a notify() without a waiting consumer makes the
+	* next wait_for() return immediately.
+	*/
+	class DataSignal {
+	public:
+		void notify() {
+			m_pending.store(true, std::memory_order_seq_cst);
+			if (m_waiters.load(std::memory_order_seq_cst) > 0) {
+				// Taking the lock orders us after a consumer that checked the
+				// predicate but did not block yet.
+				{ std::lock_guard<std::mutex> lock(m_mutex); }
+				m_condition.notify_one();
+			}
+		}
+
+		// Returns true if notified, false on timeout.
+		bool wait_for(std::chrono::microseconds timeout) {
+			if (m_pending.exchange(false, std::memory_order_seq_cst)) {
+				return true;
+			}
+			m_waiters.fetch_add(1, std::memory_order_seq_cst);
+			bool notified;
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				notified = m_condition.wait_for(lock, timeout, [this]() {
+					return m_pending.exchange(false, std::memory_order_seq_cst);
+				});
+			}
+			m_waiters.fetch_sub(1, std::memory_order_seq_cst);
+			return notified;
+		}
+
+	private:
+		std::atomic<bool> m_pending{ false };
+		std::atomic<int> m_waiters{ 0 };
+		std::mutex m_mutex;
+		std::condition_variable m_condition;
+	};
+}
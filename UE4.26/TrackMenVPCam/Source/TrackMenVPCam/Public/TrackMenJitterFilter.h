@@ -0,0 +1,62 @@
+/* Copyright 2021 TrackMen GmbH <mail@trackmen.de> */
+
+#pragma once
+
+#include "TrackMenCameraConversion.h"
+#include "TrackMenCameraTrackingTypes.h"
+#include "TrackMenPoseChannels.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace TrackMen {
+
+	/**
+	* Speed adaptive low pass (One Euro filter) against the encoder jitter of
+	* one camera, per TrkPoseChannel_t.
+	*
+	* Every channel runs a first order low pass whose cutoff rises with the
+	* filtered speed of the channel: a still camera is smoothed at
+	* minCutoffHz, a moving one follows with little lag. The state is kept as
+	* one array of all channels per quantity, so an update is a single pass of
+	* straight-line arithmetic over the channels that the compiler vectorizes.
+	* No allocation after construction.
+	*
+	* Time steps come from a SampleClock; a cut (see channel_max_speed()) or
+	* a gap in the data starts the filter over at the measurement.
+	*
+	* Not thread safe, LiveLinkCameraSource keeps one per camera.
+	*/
+	class JitterFilter {
+	public:
+		static const size_t CHANNELS = TRK_POSE_CHANNELS;
+
+		JitterFilter() { configure(TrkJitterFilterSettings_t()); }
+
+		// Sets the cutoffs and starts over.
+		void configure(const TrkJitterFilterSettings_t& settings);
+		void reset();
+
+		// Replaces pose and lens of frame, measured at the sample with the
+		// given tracker counter and arrival time, by their filtered values.
+		// Leaves frame as it is if the filter is disabled.
+		void filter(TrkCameraFrame_t& frame, uint32_t counter, int64_t arrival_ns);
+
+	private:
+		void start(const double* measured);
+
+		bool m_enabled = false;
+		bool m_started = false;
+		SampleClock m_clock;
+
+		// Per channel settings, 2 pi times the cutoffs in Hz.
+		double m_min_cutoff[CHANNELS];
+		double m_beta[CHANNELS];
+		double m_pass[CHANNELS]; /* 1 for channels that are not filtered */
+		double m_derivative_cutoff = 0.0;
+
+		// Per channel state, angles unwrapped.
+		double m_value[CHANNELS];
+		double m_speed[CHANNELS];
+	};
+}
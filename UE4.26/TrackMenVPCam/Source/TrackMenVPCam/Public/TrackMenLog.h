@@ -0,0 +1,28 @@
+/* Copyright 2021 TrackMen GmbH <mail@trackmen.de> */
+
+#pragma once
+
+// Logging of the engine-independent tracking core. The plugin module routes
+// the messages to LogTrackMenPlugin, headless builds print them to stderr.
+
+namespace TrackMen {
+
+	enum TrkLogLevel_t {
+		TRK_LOG_ERROR,
+		TRK_LOG_WARNING,
+		TRK_LOG_DISPLAY
+	};
+
+	typedef void (*TrkLogHandler_t)(TrkLogLevel_t level, const char* message);
+
+	// Replaces the handler for all following messages. nullptr restores the
+	// stderr default. The handler may be called from any thread.
+	void set_log_handler(TrkLogHandler_t handler);
+
+	// printf-style, the message is UTF-8.
+	void log_message(TrkLogLevel_t level, const char* format, ...)
+#if defined(__GNUC__) || defined(__clang__)
+		__attribute__((format(printf, 2, 3)))
+#endif
+		;
+}
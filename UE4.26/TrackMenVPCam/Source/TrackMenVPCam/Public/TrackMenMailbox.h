@@ -0,0 +1,118 @@
+/* Copyright 2021 TrackMen GmbH <mail@trackmen.de> */
+
+#pragma once
+
+#include <atomic>
+#include <string.h>
+#include <thread>
+#include <type_traits>
+#include <stdint.h>
+
+namespace TrackMen {
+
+	/**
+	* Single-slot mailbox that only keeps the most recent value.
+	*
+	* One writer publishes, one reader takes the newest value without locking.
+	* The slot is protected by a sequence lock: the writer makes the sequence
+	* odd while it copies, the reader retries if the sequence was odd or changed
+	* during its copy. The payload is stored in atomic words so the optimistic
+	* read is free of data races.
+	*/
+	template <typename T>
+	class LatestValueMailbox {
+		static_assert(std::is_trivially_copyable<T>::value, "LatestValueMailbox requires trivially copyable values");
+
+	public:
+		LatestValueMailbox() {
+			reset();
+		}
+
+		LatestValueMailbox(const LatestValueMailbox&) = delete;
+		LatestValueMailbox& operator=(const LatestValueMailbox&) = delete;
+
+		// Neither writer nor reader may be active.
+		void reset() {
+			for (size_t i = 0; i < WORD_COUNT; ++i) {
+				m_words[i].store(0, std::memory_order_relaxed);
+			}
+			m_sequence.store(0, std::memory_order_relaxed);
+			m_taken_sequence.store(0, std::memory_order_relaxed);
+		}
+
+		// Writer side. Returns true if the previous value was never taken.
+
+		bool publish(const T& value) {
+			uint64_t words[WORD_COUNT] = {};
+			memcpy(words, &value, sizeof(T));
+
+			const uint64_t sequence = m_sequence.load(std::memory_order_relaxed);
+			const bool superseded = (sequence != 0)
+				&& (m_taken_sequence.load(std::memory_order_acquire) != sequence);
+
+			m_sequence.store(sequence + 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+			for (size_t i = 0; i < WORD_COUNT; ++i) {
+				m_words[i].store(words[i], std::memory_order_relaxed);
+			}
+			m_sequence.store(sequence + 2, std::memory_order_release);
+			return superseded;
+		}
+
+		// Reader side
+
+		bool has_unread() const {
+			// An odd sequence means a write is in progress, the previous value
+			// is still the newest complete one.
+			const uint64_t published = m_sequence.load(std::memory_order_acquire) & ~uint64_t(1);
+			return published != 0 && published != m_taken_sequence.load(std::memory_order_relaxed);
+		}
+
+		// Copies the newest value if it was not taken before.
+		bool take(T& value) {
+			uint64_t sequence;
+			if (!read(value, sequence) || sequence == m_taken_sequence.load(std::memory_order_relaxed)) {
+				return false;
+			}
+			m_taken_sequence.store(sequence, std::memory_order_release);
+			return true;
+		}
+
+		// Copies the newest value, taken or not. Returns false if nothing was
+		// published yet.
+		bool peek(T& value) const {
+			uint64_t sequence;
+			return read(value, sequence);
+		}
+
+	private:
+		static constexpr size_t WORD_COUNT = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+		bool read(T& value, uint64_t& sequence) const {
+			uint64_t words[WORD_COUNT];
+			for (;;) {
+				sequence = m_sequence.load(std::memory_order_acquire);
+				if (sequence == 0) {
+					return false;
+				}
+				if (sequence & 1) {
+					// The writer is in the middle of a copy.
+					std::this_thread::yield();
+					continue;
+				}
+				for (size_t i = 0; i < WORD_COUNT; ++i) {
+					words[i] = m_words[i].load(std::memory_order_relaxed);
+				}
+				std::atomic_thread_fence(std::memory_order_acquire);
+				if (m_sequence.load(std::memory_order_relaxed) == sequence) {
+					memcpy(&value, words, sizeof(T));
+					return true;
+				}
+			}
+		}
+
+		std::atomic<uint64_t> m_sequence{ 0 };
+		std::atomic<uint64_t> m_taken_sequence{ 0 };
+		std::atomic<uint64_t> m_words[WORD_COUNT];
+	};
+}
@@ -0,0 +1,208 @@
+/* Copyright 2021 TrackMen GmbH <mail@trackmen.de> */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string.h>
+#include <type_traits>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace TrackMen {
+
+	/**
+	* Fixed-capacity, lock-free single-producer/single-consumer ring buffer.
+	*
+	* push() may only be called from one thread (the network receiver) and
+	* pop()/empty() only from one other thread (the LiveLink push thread).
+	* Storage is allocated once in the constructor or in reset(); the buffer
+	* never grows, a push into a full buffer fails instead.
+	*
+	* When the buffer is full the producer may also evict queued items with
+	* discard_oldest()/discard_all() and then reuse their slots. The consumer
+	* therefore advances the read index with a compare-and-swap and throws away
+	* a copy if the producer evicted that slot while it was being read. Like in
+	* LatestValueMailbox the slots are stored in atomic words, so that a copy
+	* racing with the producer is well defined, only discarded; this is why T
+	* has to be trivially copyable.
+	*/
+	template <typename T>
+	class SpscRingBuffer {
+		static_assert(std::is_trivially_copyable<T>::value, "SpscRingBuffer requires trivially copyable items");
+
+	public:
+		explicit SpscRingBuffer(size_t capacity) {
+			reset(capacity);
+		}
+
+		SpscRingBuffer(const SpscRingBuffer&) = delete;
+		SpscRingBuffer& operator=(const SpscRingBuffer&) = delete;
+
+		// Drops all items and reallocates if the capacity changed. Neither
+		// producer nor consumer may be active.
+		void reset(size_t capacity) {
+			if (capacity < 1) {
+				capacity = 1;
+			}
+			const size_t storage = round_up_to_power_of_two(capacity);
+			if (!m_slots || storage != m_mask + 1) {
+				m_slots.reset(new std::atomic<uint64_t>[storage * WORD_COUNT]);
+			}
+			m_capacity = capacity;
+			m_mask = storage - 1;
+			m_read_index.store(0, std::memory_order_relaxed);
+			m_cached_write_index = 0;
+			m_write_index.store(0, std::memory_order_relaxed);
+			m_cached_read_index = 0;
+		}
+
+		// Producer side
+
+		bool push(const T& item) {
+			const size_t write_index = m_write_index.load(std::memory_order_relaxed);
+			if (write_index - m_cached_read_index >= m_capacity) {
+				// Looks full, refresh our view of the consumer.
+				m_cached_read_index = m_read_index.load(std::memory_order_acquire);
+				if (write_index - m_cached_read_index >= m_capacity) {
+					return false;
+				}
+			}
+			store_slot(write_index, item);
+			m_write_index.store(write_index + 1, std::memory_order_release);
+			return true;
+		}
+
+		// Evicts the oldest queued item. Returns the number of evicted items.
+		size_t discard_oldest() {
+			const size_t write_index = m_write_index.load(std::memory_order_relaxed);
+			size_t read_index = m_read_index.load(std::memory_order_acquire);
+			while (read_index != write_index) {
+				if (m_read_index.compare_exchange_weak(read_index, read_index + 1,
+					std::memory_order_acq_rel, std::memory_order_acquire)) {
+					m_cached_read_index = read_index + 1;
+					return 1;
+				}
+			}
+			return 0;
+		}
+
+		// Evicts everything that is queued. Returns the number of evicted items.
+		size_t discard_all() {
+			const size_t write_index = m_write_index.load(std::memory_order_relaxed);
+			size_t read_index = m_read_index.load(std::memory_order_acquire);
+			while (read_index != write_index) {
+				if (m_read_index.compare_exchange_weak(read_index, write_index,
+					std::memory_order_acq_rel, std::memory_order_acquire)) {
+					m_cached_read_index = write_index;
+					return write_index - read_index;
+				}
+			}
+			return 0;
+		}
+
+		// Consumer side
+
+		bool pop(T& item) {
+			size_t read_index = m_read_index.load(std::memory_order_acquire);
+			for (;;) {
+				// Evictions may move the read index past our cached write index.
+				if (read_index >= m_cached_write_index) {
+					m_cached_write_index = m_write_index.load(std::memory_order_acquire);
+					if (read_index >= m_cached_write_index) {
+						return false;
+					}
+				}
+				uint64_t words[WORD_COUNT];
+				load_slot(read_index, words);
+				if (m_read_index.compare_exchange_weak(read_index, read_index + 1,
+					std::memory_order_acq_rel, std::memory_order_acquire)) {
+					memcpy(&item, words, sizeof(T));
+					return true;
+				}
+				// The producer evicted this item while we copied it; read_index
+				// now holds the new position.
+			}
+		}
+
+		// Pops up to max_items into items. Returns the number of popped items.
+		size_t pop_all(T* items, size_t max_items) {
+			size_t count = 0;
+			while (count < max_items && pop(items[count])) {
+				++count;
+			}
+			return count;
+		}
+
+		bool empty() {
+			const size_t read_index = m_read_index.load(std::memory_order_acquire);
+			if (read_index < m_cached_write_index) {
+				return false;
+			}
+			m_cached_write_index = m_write_index.load(std::memory_order_acquire);
+			return read_index >= m_cached_write_index;
+		}
+
+		// Either side, approximate while the other side is active.
+
+		size_t size() const {
+			const size_t read_index = m_read_index.load(std::memory_order_acquire);
+			const size_t write_index = m_write_index.load(std::memory_order_acquire);
+			return write_index - read_index;
+		}
+
+		size_t capacity() const {
+			return m_capacity;
+		}
+
+	private:
+		static constexpr size_t CACHE_LINE_SIZE = 64;
+		static constexpr size_t WORD_COUNT = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+		// The producer only writes a slot it owns: unused, or evicted by its
+		// own successful compare-and-swap, which orders the write after the
+		// loads of a consumer that read the slot before.
+		void store_slot(size_t index, const T& item) {
+			uint64_t words[WORD_COUNT] = {};
+			memcpy(words, &item, sizeof(T));
+			std::atomic<uint64_t>* slot = &m_slots[(index & m_mask) * WORD_COUNT];
+			for (size_t i = 0; i < WORD_COUNT; ++i) {
+				slot[i].store(words[i], std::memory_order_relaxed);
+			}
+		}
+
+		void load_slot(size_t index, uint64_t* words) const {
+			const std::atomic<uint64_t>* slot = &m_slots[(index & m_mask) * WORD_COUNT];
+			for (size_t i = 0; i < WORD_COUNT; ++i) {
+				words[i] = slot[i].load(std::memory_order_relaxed);
+			}
+		}
+
+		static size_t round_up_to_power_of_two(size_t value) {
+			size_t result = 1;
+			while (result < value) {
+				result <<= 1;
+			}
+			return result;
+		}
+
+		// Only changed by reset().
+		size_t m_capacity = 0;
+		size_t m_mask = 0;
+		std::unique_ptr<std::atomic<uint64_t>[]> m_slots; /* WORD_COUNT words per slot */
+
+		// Explicit padding keeps producer and consumer indices on separate
+		// cache lines independent of the alignment of the owning object.
+		char m_pad0[CACHE_LINE_SIZE];
+
+		// Advanced by the consumer (and by the producer when evicting).
+		std::atomic<size_t> m_read_index{ 0 };
+		size_t m_cached_write_index = 0;
+		char m_pad1[CACHE_LINE_SIZE];
+
+		// Written by the producer.
+		std::atomic<size_t> m_write_index{ 0 };
+		size_t m_cached_read_index = 0;
+		char m_pad2[CACHE_LINE_SIZE];
+	};
+}
@@ -0,0 +1,109 @@
+/* Copyright 2021 TrackMen GmbH <mail@trackmen.de> */
+
+#pragma once
+
+#include "TrackMenCameraTrackingTypes.h"
+
+#include <atomic>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace TrackMen {
+
+	/**
+	* Checks the tracker counter of the samples of one source.
+	*
+	* The counter is compared modulo 2^32, so it may wrap. Gaps, duplicates
+	* and late samples are detected within the last 64 counters; a sample
+	* that is far older than the newest one (a restarted tracker) starts the
+	* check over. Depending on the policy, out-of-sequence samples are passed
+	* on, dropped or held back to restore the counter order.
+	*
+	* push() and released() are called by the receiver thread only,
+	* statistics() may be called from any thread.
+	*/
+	class SequenceTracker {
+	public:
+		SequenceTracker();
+
+		// Clears the state and the statistics. Must not run concurrently with
+		// push().
+		void reset(TrkSequencePolicy_t policy, size_t reorder_window);
+
+		// Changes the policy, keeping the statistics. Held samples are
+		// dropped and the next sample starts the check over. Must not run
+		// concurrently with push().
+		void set_policy(TrkSequencePolicy_t policy, size_t reorder_window);
+
+		// Checks the sample and returns how many samples can be passed on now,
+		// in counter order. They stay valid until the next push().
+		size_t push(const TrkCameraSample_t& sample);
+		const TrkCameraSample_t& released(size_t index) const { return m_released[index]; }
+
+		// Number of samples held back for reordering.
+		size_t held() const { return m_held_count; }
+
+		TrkSequenceStatistics_t statistics() const;
+
+		// Jumps back by more than this restart the check right away.
+		static const int32_t RESYNC_DISTANCE = 1024;
+
+		// After this many rejected samples in a row the check starts over, so
+		// a tracker restart with a small jump back cannot block a source. A
+		// counter that repeats the one before is taken as a sender that does
+		// not count right away.
+		static const uint32_t RESYNC_AFTER_REJECTS = 8;
+
+		static const size_t MAX_REORDER_WINDOW = 32;
+
+	private:
+		enum Arrival {
+			ARRIVAL_FIRST,     /* first sample or after a resync */
+			ARRIVAL_IN_ORDER,  /* newer than every sample before */
+			ARRIVAL_LATE,      /* fills a gap */
+			ARRIVAL_DUPLICATE,
+			ARRIVAL_TOO_OLD    /* older than the history, duplicate or late */
+		};
+
+		Arrival classify(uint32_t counter);
+		void start(uint32_t counter);
+		void hold(const TrkCameraSample_t& sample);
+		void release_held();
+		void release(const TrkCameraSample_t& sample);
+
+		static void add(std::atomic<uint64_t>& counter, uint64_t value = 1) {
+			counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+		}
+
+		TrkSequencePolicy_t m_policy = TRK_SEQUENCE_COUNT_ONLY;
+		size_t m_reorder_window = 0;
+
+		bool m_started = false;
+		uint32_t m_highest = 0;
+		uint64_t m_history = 0; /* bit i: counter m_highest - i was seen */
+
+		// Senders that never advance the counter are passed through.
+		bool m_static_counter = false;
+		uint32_t m_last_counter = 0;
+		uint32_t m_rejected_in_row = 0;
+
+		// TRK_SEQUENCE_REORDER: next counter to pass on and the samples held
+		// back, sorted by counter.
+		uint32_t m_next = 0;
+		std::vector<TrkCameraSample_t> m_held;
+		size_t m_held_count = 0;
+
+		std::vector<TrkCameraSample_t> m_released;
+		size_t m_released_count = 0;
+
+		std::atomic<uint64_t> m_samples{ 0 };
+		std::atomic<uint64_t> m_missing{ 0 };
+		std::atomic<uint64_t> m_duplicates{ 0 };
+		std::atomic<uint64_t> m_late{ 0 };
+		std::atomic<uint64_t> m_reordered{ 0 };
+		std::atomic<uint64_t> m_rejected{ 0 };
+		std::atomic<uint64_t> m_wraps{ 0 };
+		std::atomic<uint64_t> m_resyncs{ 0 };
+	};
+}
@@ -0,0 +1,213 @@
+/* Copyright 2021 TrackMen GmbH <mail@trackmen.de> */
+
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace TrackMen {
+
+	/**
+	* Latency histogram with logarithmic buckets, each power of two split into
+	* 16 linear sub-buckets (HDR histogram layout). Values between 0 and about
+	* 18 minutes in nanoseconds are recorded with a relative error below 6.25%.
+	*
+	* record() is lock-free and does not allocate. Readers copy the counts
+	* with snapshot() and may run on any thread.
+	*/
+	class LatencyHistogram {
+	public:
+		static const unsigned SUB_BUCKET_BITS = 4;
+		static const uint64_t SUB_BUCKETS = (uint64_t)1 << SUB_BUCKET_BITS;
+		static const unsigned MAX_VALUE_BITS = 40;
+		static const size_t BUCKET_COUNT = (size_t)SUB_BUCKETS * (MAX_VALUE_BITS - SUB_BUCKET_BITS + 1);
+
+		LatencyHistogram() { reset(); }
+
+		void reset() {
+			for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+				m_counts[i].store(0, std::memory_order_relaxed);
+			}
+		}
+
+		// Negative values are recorded as 0, values beyond the range in the
+		// last bucket.
+		void record(int64_t value) {
+			m_counts[bucket_index(value > 0 ? (uint64_t)value : 0)].fetch_add(1, std::memory_order_relaxed);
+		}
+
+		// Writes BUCKET_COUNT counts.
+		void snapshot(uint64_t* counts) const {
+			for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+				counts[i] = m_counts[i].load(std::memory_order_relaxed);
+			}
+		}
+
+		static size_t bucket_index(uint64_t value) {
+			if (value < SUB_BUCKETS) {
+				return (size_t)value;
+			}
+			if (value >> MAX_VALUE_BITS) {
+				return BUCKET_COUNT - 1;
+			}
+			const unsigned exponent = highest_bit(value) - SUB_BUCKET_BITS;
+			return (size_t)(SUB_BUCKETS * (exponent + 1) + ((value >> exponent) - SUB_BUCKETS));
+		}
+
+		// Center of the values that fall into bucket index.
+		static double bucket_value(size_t index) {
+			if (index < SUB_BUCKETS) {
+				return (double)index;
+			}
+			const unsigned exponent = (unsigned)(index / SUB_BUCKETS) - 1;
+			const uint64_t lowest = (SUB_BUCKETS + index % SUB_BUCKETS) << exponent;
+			return (double)lowest + (double)(((uint64_t)1 << exponent) - 1) * 0.5;
+		}
+
+		// Value below which the given fraction of the counted values lies,
+		// 0 if counts is empty.
+		static double percentile(const uint64_t* counts, double fraction) {
+			uint64_t total = 0;
+			for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+				total += counts[i];
+			}
+			if (total == 0) {
+				return 0.0;
+			}
+			const double rank = fraction * (double)total;
+			uint64_t seen = 0;
+			for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+				seen += counts[i];
+				if (counts[i] > 0 && (double)seen >= rank) {
+					return bucket_value(i);
+				}
+			}
+			return bucket_value(BUCKET_COUNT - 1);
+		}
+
+	private:
+		static unsigned highest_bit(uint64_t value) {
+			unsigned bit = 0;
+			if (value >> 32) { value >>= 32; bit += 32; }
+			if (value >> 16) { value >>= 16; bit += 16; }
+			if (value >> 8) { value >>= 8; bit += 8; }
+			if (value >> 4) { value >>= 4; bit += 4; }
+			if (value >> 2) { value >>= 2; bit += 2; }
+			if (value >> 1) { bit += 1; }
+			return bit;
+		}
+
+		std::atomic<uint64_t> m_counts[BUCKET_COUNT];
+	};
+
+	/**
+	* Throughput and latency of one source over the last reporting interval.
+	*/
+	struct TrkSourceStatistics_t {
+		double intervalSeconds = 0.0;
+		double datagramsPerSecond = 0.0; /* received datagrams */
+		double parsedPerSecond = 0.0;    /* camera samples parsed from them */
+		double pushedPerSecond = 0.0;    /* frames pushed to LiveLink */
+		double latencyP50Ms = 0.0;       /* arrival to push */
+		double latencyP99Ms = 0.0;
+	};
+
+	/**
+	* Lock-free counters of one source, written by the receive and push
+	* threads, read by the status display.
+	*/
+	class SourceStatistics {
+	public:
+		void reset() {
+			m_datagrams.store(0, std::memory_order_relaxed);
+			m_parsed.store(0, std::memory_order_relaxed);
+			m_pushed.store(0, std::memory_order_relaxed);
+			m_latency.reset();
+		}
+
+		void add_datagrams(uint64_t count) { m_datagrams.fetch_add(count, std::memory_order_relaxed); }
+		void add_parsed() { m_parsed.fetch_add(1, std::memory_order_relaxed); }
+		void add_pushed(int64_t latency_ns) {
+			m_pushed.fetch_add(1, std::memory_order_relaxed);
+			m_latency.record(latency_ns);
+		}
+
+		uint64_t datagrams() const { return m_datagrams.load(std::memory_order_relaxed); }
+		uint64_t parsed() const { return m_parsed.load(std::memory_order_relaxed); }
+		uint64_t pushed() const { return m_pushed.load(std::memory_order_relaxed); }
+		const LatencyHistogram& latency() const { return m_latency; }
+
+	private:
+		std::atomic<uint64_t> m_datagrams{ 0 };
+		std::atomic<uint64_t> m_parsed{ 0 };
+		std::atomic<uint64_t> m_pushed{ 0 };
+		LatencyHistogram m_latency;
+	};
+
+	/**
+	* Turns the running counters of a SourceStatistics into rates and
+	* percentiles per interval. Used by a single reader thread; allocates only
+	* on construction.
+	*/
+	class SourceStatisticsSampler {
+	public:
+		SourceStatisticsSampler()
+			: m_previous_counts(LatencyHistogram::BUCKET_COUNT, 0)
+			, m_counts(LatencyHistogram::BUCKET_COUNT, 0) {
+		}
+
+		// Starts the first interval at now_ns.
+		void restart(const SourceStatistics& statistics, int64_t now_ns) {
+			m_previous_time_ns = now_ns;
+			m_previous_datagrams = statistics.datagrams();
+			m_previous_parsed = statistics.parsed();
+			m_previous_pushed = statistics.pushed();
+			statistics.latency().snapshot(m_previous_counts.data());
+		}
+
+		// Statistics since the previous call, which starts the next interval.
+		TrkSourceStatistics_t sample(const SourceStatistics& statistics, int64_t now_ns) {
+			TrkSourceStatistics_t result;
+			const uint64_t datagrams = statistics.datagrams();
+			const uint64_t parsed = statistics.parsed();
+			const uint64_t pushed = statistics.pushed();
+			statistics.latency().snapshot(m_counts.data());
+
+			// Counters that went backwards were reset in between.
+			result.intervalSeconds = (double)(now_ns - m_previous_time_ns) * 1e-9;
+			if (result.intervalSeconds > 0.0) {
+				result.datagramsPerSecond = (double)delta(datagrams, m_previous_datagrams) / result.intervalSeconds;
+				result.parsedPerSecond = (double)delta(parsed, m_previous_parsed) / result.intervalSeconds;
+				result.pushedPerSecond = (double)delta(pushed, m_previous_pushed) / result.intervalSeconds;
+			}
+
+			for (size_t i = 0; i < LatencyHistogram::BUCKET_COUNT; ++i) {
+				const uint64_t count = m_counts[i];
+				m_counts[i] = delta(count, m_previous_counts[i]);
+				m_previous_counts[i] = count;
+			}
+			result.latencyP50Ms = LatencyHistogram::percentile(m_counts.data(), 0.50) * 1e-6;
+			result.latencyP99Ms = LatencyHistogram::percentile(m_counts.data(), 0.99) * 1e-6;
+
+			m_previous_time_ns = now_ns;
+			m_previous_datagrams = datagrams;
+			m_previous_parsed = parsed;
+			m_previous_pushed = pushed;
+			return result;
+		}
+
+	private:
+		static uint64_t delta(uint64_t current, uint64_t previous) {
+			return current >= previous ? current - previous : current;
+		}
+
+		int64_t m_previous_time_ns = 0;
+		uint64_t m_previous_datagrams = 0;
+		uint64_t m_previous_parsed = 0;
+		uint64_t m_previous_pushed = 0;
+		std::vector<uint64_t> m_previous_counts;
+		std::vector<uint64_t> m_counts;
+	};
+}
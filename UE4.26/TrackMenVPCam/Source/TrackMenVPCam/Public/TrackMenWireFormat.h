@@ -0,0 +1,358 @@
+/* Copyright 2021 TrackMen GmbH <mail@trackmen.de> */
+
+#pragma once
+
+// Binary wire formats of the tracking datagrams.
+//
+// Every packet layout is described once as a list of fields with their wire
+// type and byte offset. Decoder and encoder are generated from that list, so
+// the test data generators write exactly what the receive path reads. All
+// values are little-endian on the wire and are loaded byte-wise, independent
+// of the alignment of the datagram buffer and of the host byte order.
+
+#include "TrackMenCameraTrackingTypes.h"
+
+#include <type_traits>
+#include <string.h>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace TrackMen {
+
+	// Little-endian loads and stores
+
+	template <typename T>
+	struct WireCodec;
+
+	template <>
+	struct WireCodec<uint32_t> {
+		static uint32_t load(const uint8_t* data) {
+			return (uint32_t)data[0]
+				| ((uint32_t)data[1] << 8)
+				| ((uint32_t)data[2] << 16)
+				| ((uint32_t)data[3] << 24);
+		}
+		static void store(uint8_t* data, uint32_t value) {
+			data[0] = (uint8_t)value;
+			data[1] = (uint8_t)(value >> 8);
+			data[2] = (uint8_t)(value >> 16);
+			data[3] = (uint8_t)(value >> 24);
+		}
+	};
+
+	template <>
+	struct WireCodec<uint16_t> {
+		static uint16_t load(const uint8_t* data) {
+			return (uint16_t)(data[0] | (data[1] << 8));
+		}
+		static void store(uint8_t* data, uint16_t value) {
+			data[0] = (uint8_t)value;
+			data[1] = (uint8_t)(value >> 8);
+		}
+	};
+
+	template <>
+	struct WireCodec<int32_t> {
+		static int32_t load(const uint8_t* data) {
+			return (int32_t)WireCodec<uint32_t>::load(data);
+		}
+		static void store(uint8_t* data, int32_t value) {
+			WireCodec<uint32_t>::store(data, (uint32_t)value);
+		}
+	};
+
+	template <>
+	struct WireCodec<uint64_t> {
+		static uint64_t load(const uint8_t* data) {
+			return (uint64_t)WireCodec<uint32_t>::load(data)
+				| ((uint64_t)WireCodec<uint32_t>::load(data + 4) << 32);
+		}
+		static void store(uint8_t* data, uint64_t value) {
+			WireCodec<uint32_t>::store(data, (uint32_t)value);
+			WireCodec<uint32_t>::store(data + 4, (uint32_t)(value >> 32));
+		}
+	};
+
+	template <>
+	struct WireCodec<int64_t> {
+		static int64_t load(const uint8_t* data) {
+			return (int64_t)WireCodec<uint64_t>::load(data);
+		}
+		static void store(uint8_t* data, int64_t value) {
+			WireCodec<uint64_t>::store(data, (uint64_t)value);
+		}
+	};
+
+	// IEEE 754 binary64, transferred as its bit pattern.
+	template <>
+	struct WireCodec<double> {
+		static_assert(sizeof(double) == sizeof(uint64_t), "double must be IEEE 754 binary64");
+
+		static double load(const uint8_t* data) {
+			const uint64_t bits = WireCodec<uint64_t>::load(data);
+			double value;
+			memcpy(&value, &bits, sizeof(value));
+			return value;
+		}
+		static void store(uint8_t* data, double value) {
+			uint64_t bits;
+			memcpy(&bits, &value, sizeof(bits));
+			WireCodec<uint64_t>::store(data, bits);
+		}
+	};
+
+	template <typename T>
+	T load_le(const uint8_t* data) {
+		return WireCodec<T>::load(data);
+	}
+
+	template <typename T>
+	void store_le(uint8_t* data, T value) {
+		WireCodec<T>::store(data, value);
+	}
+
+	// Field descriptors
+
+	/**
+	* A value of type WireT at Offset that maps to the member selected by
+	* Access::get() of the decoded message.
+	*/
+	template <typename WireT, size_t Offset, typename Access>
+	struct WireField {
+		static constexpr size_t offset = Offset;
+		static constexpr size_t size = sizeof(WireT);
+
+		template <typename Message>
+		static bool decode(const uint8_t* data, Message& message) {
+			typedef typename std::remove_reference<decltype(Access::get(message))>::type Member;
+			Access::get(message) = (Member)load_le<WireT>(data + Offset);
+			return true;
+		}
+
+		template <typename Message>
+		static void encode(const Message& message, uint8_t* data) {
+			store_le<WireT>(data + Offset, (WireT)Access::get(message));
+		}
+	};
+
+	// C++14 needs the definitions of static constexpr members that are bound
+	// to a reference, e.g. by std::min.
+	template <typename WireT, size_t Offset, typename Access>
+	constexpr size_t WireField<WireT, Offset, Access>::offset;
+	template <typename WireT, size_t Offset, typename Access>
+	constexpr size_t WireField<WireT, Offset, Access>::size;
+
+	/**
+	* A fixed value at Offset, e.g. a magic number. Decoding fails if the
+	* datagram holds a different value.
+	*/
+	template <typename WireT, size_t Offset, WireT Value>
+	struct WireConstant {
+		static constexpr size_t offset = Offset;
+		static constexpr size_t size = sizeof(WireT);
+
+		template <typename Message>
+		static bool decode(const uint8_t* data, Message&) {
+			return load_le<WireT>(data + Offset) == Value;
+		}
+
+		template <typename Message>
+		static void encode(const Message&, uint8_t* data) {
+			store_le<WireT>(data + Offset, Value);
+		}
+	};
+
+	template <typename WireT, size_t Offset, WireT Value>
+	constexpr size_t WireConstant<WireT, Offset, Value>::offset;
+	template <typename WireT, size_t Offset, WireT Value>
+	constexpr size_t WireConstant<WireT, Offset, Value>::size;
+
+	// True if the fields do not overlap, are in ascending order and end
+	// within Size bytes.
+	template <size_t Size, size_t End>
+	constexpr bool wire_fields_fit() {
+		return End <= Size;
+	}
+
+	template <size_t Size, size_t End, typename Field, typename... Rest>
+	constexpr bool wire_fields_fit() {
+		return Field::offset >= End && wire_fields_fit<Size, Field::offset + Field::size, Rest...>();
+	}
+
+	/**
+	* A packet of Size bytes made of Fields, listed in ascending offset order.
+	* Bytes not covered by a field are ignored when decoding and written as
+	* zero when encoding.
+	*/
+	template <size_t Size, typename... Fields>
+	struct WireLayout {
+		static constexpr size_t size = Size;
+
+		static_assert(wire_fields_fit<Size, 0, Fields...>(), "wire fields overlap or exceed the packet size");
+
+		// Returns false if length is not the packet size or a constant field
+		// does not match.
+		template <typename Message>
+		static bool decode(const uint8_t* data, size_t length, Message& message) {
+			if (length != Size) {
+				return false;
+			}
+			bool valid = true;
+			const bool results[] = { (valid = Fields::decode(data, message) && valid)... };
+			(void)results;
+			return valid;
+		}
+
+		// Writes exactly size bytes.
+		template <typename Message>
+		static void encode(const Message& message, uint8_t* data) {
+			memset(data, 0, Size);
+			const int results[] = { (Fields::encode(message, data), 0)... };
+			(void)results;
+		}
+	};
+
+	template <size_t Size, typename... Fields>
+	constexpr size_t WireLayout<Size, Fields...>::size;
+
+	// Packet layouts
+
+	/**
+	* Camera parameters and chip size of one GameEngineOpen datagram.
+	*/
+	struct TrkGameEngineMessage_t {
+		TrkCameraParams_t params;
+		TrkCameraConstants_t constants;
+	};
+
+	// Declares an accessor type that selects where a wire field is stored in
+	// the decoded message m.
+#define TRK_WIRE_ACCESS(Name, Expression) \
+	struct Name { \
+		template <typename Message> \
+		static auto& get(Message& m) { return Expression; } \
+	}
+
+	namespace WireAccess {
+
+		TRK_WIRE_ACCESS(Id, m.id);
+		TRK_WIRE_ACCESS(Format, m.format);
+		TRK_WIRE_ACCESS(Fov, m.fov);
+		TRK_WIRE_ACCESS(CenterX, m.centerX);
+		TRK_WIRE_ACCESS(CenterY, m.centerY);
+		TRK_WIRE_ACCESS(K1, m.k1);
+		TRK_WIRE_ACCESS(K2, m.k2);
+		TRK_WIRE_ACCESS(Focdist, m.focdist);
+		TRK_WIRE_ACCESS(Aperture, m.aperture);
+		TRK_WIRE_ACCESS(Counter, m.counter);
+
+		template <int J, int I>
+		struct Matrix {
+			template <typename Message>
+			static auto& get(Message& m) { return m.t.m[J][I]; }
+		};
+
+		TRK_WIRE_ACCESS(ImageWidth, m.imageWidth);
+		TRK_WIRE_ACCESS(ImageHeight, m.imageHeight);
+		TRK_WIRE_ACCESS(BlankLeft, m.blankLeft);
+		TRK_WIRE_ACCESS(BlankRight, m.blankRight);
+		TRK_WIRE_ACCESS(BlankTop, m.blankTop);
+		TRK_WIRE_ACCESS(BlankBottom, m.blankBottom);
+		TRK_WIRE_ACCESS(ChipWidth, m.chipWidth);
+		TRK_WIRE_ACCESS(ChipHeight, m.chipHeight);
+		TRK_WIRE_ACCESS(FakeChipWidth, m.fakeChipWidth);
+		TRK_WIRE_ACCESS(FakeChipHeight, m.fakeChipHeight);
+
+		TRK_WIRE_ACCESS(GameEngineCounter, m.params.counter);
+		TRK_WIRE_ACCESS(GameEngineX, m.params.t.e.x);
+		TRK_WIRE_ACCESS(GameEngineY, m.params.t.e.y);
+		TRK_WIRE_ACCESS(GameEngineZ, m.params.t.e.z);
+		TRK_WIRE_ACCESS(GameEnginePan, m.params.t.e.pan);
+		TRK_WIRE_ACCESS(GameEngineTilt, m.params.t.e.tilt);
+		TRK_WIRE_ACCESS(GameEngineRoll, m.params.t.e.roll);
+		TRK_WIRE_ACCESS(GameEngineFov, m.params.fov);
+		TRK_WIRE_ACCESS(GameEngineCenterX, m.params.centerX);
+		TRK_WIRE_ACCESS(GameEngineCenterY, m.params.centerY);
+		TRK_WIRE_ACCESS(GameEngineK1, m.params.k1);
+		TRK_WIRE_ACCESS(GameEngineK2, m.params.k2);
+		TRK_WIRE_ACCESS(GameEngineFocdist, m.params.focdist);
+		TRK_WIRE_ACCESS(GameEngineChipWidth, m.constants.chipWidth);
+		TRK_WIRE_ACCESS(GameEngineChipHeight, m.constants.chipHeight);
+	}
+
+	static const uint32_t TRK_GAME_ENGINE_MAGIC = 0x544d4531;
+
+	// GameEngineOpen: magic, 4 unused bytes, counter, 14 doubles.
+	typedef WireLayout<124,
+		WireConstant<uint32_t, 0, TRK_GAME_ENGINE_MAGIC>,
+		WireField<uint32_t, 8, WireAccess::GameEngineCounter>,
+		WireField<double, 12, WireAccess::GameEngineX>,
+		WireField<double, 20, WireAccess::GameEngineY>,
+		WireField<double, 28, WireAccess::GameEngineZ>,
+		WireField<double, 36, WireAccess::GameEnginePan>,
+		WireField<double, 44, WireAccess::GameEngineTilt>,
+		WireField<double, 52, WireAccess::GameEngineRoll>,
+		WireField<double, 60, WireAccess::GameEngineFov>,
+		WireField<double, 68, WireAccess::GameEngineCenterX>,
+		WireField<double, 76, WireAccess::GameEngineCenterY>,
+		WireField<double, 84, WireAccess::GameEngineK1>,
+		WireField<double, 92, WireAccess::GameEngineK2>,
+		WireField<double, 100, WireAccess::GameEngineFocdist>,
+		WireField<double, 108, WireAccess::GameEngineChipWidth>,
+		WireField<double, 116, WireAccess::GameEngineChipHeight>
+	> GameEngineWireLayout;
+
+	// Body of a binary DMC01 'P' datagram. This is the in-memory layout of
+	// TrkCameraParams_t on the x86-64 trackers, whose unsigned long counter
+	// is 32 bits wide followed by 4 bytes of padding. The transform is
+	// transferred as the full 4x4 matrix, Euler values overlay its first six
+	// elements.
+	typedef WireLayout<200,
+		WireField<uint32_t, 0, WireAccess::Id>,
+		WireField<uint32_t, 4, WireAccess::Format>,
+		WireField<double, 8, WireAccess::Matrix<0, 0>>,
+		WireField<double, 16, WireAccess::Matrix<0, 1>>,
+		WireField<double, 24, WireAccess::Matrix<0, 2>>,
+		WireField<double, 32, WireAccess::Matrix<0, 3>>,
+		WireField<double, 40, WireAccess::Matrix<1, 0>>,
+		WireField<double, 48, WireAccess::Matrix<1, 1>>,
+		WireField<double, 56, WireAccess::Matrix<1, 2>>,
+		WireField<double, 64, WireAccess::Matrix<1, 3>>,
+		WireField<double, 72, WireAccess::Matrix<2, 0>>,
+		WireField<double, 80, WireAccess::Matrix<2, 1>>,
+		WireField<double, 88, WireAccess::Matrix<2, 2>>,
+		WireField<double, 96, WireAccess::Matrix<2, 3>>,
+		WireField<double, 104, WireAccess::Matrix<3, 0>>,
+		WireField<double, 112, WireAccess::Matrix<3, 1>>,
+		WireField<double, 120, WireAccess::Matrix<3, 2>>,
+		WireField<double, 128, WireAccess::Matrix<3, 3>>,
+		WireField<double, 136, WireAccess::Fov>,
+		WireField<double, 144, WireAccess::CenterX>,
+		WireField<double, 152, WireAccess::CenterY>,
+		WireField<double, 160, WireAccess::K1>,
+		WireField<double, 168, WireAccess::K2>,
+		WireField<double, 176, WireAccess::Focdist>,
+		WireField<double, 184, WireAccess::Aperture>,
+		WireField<uint32_t, 192, WireAccess::Counter>
+	> BinaryCameraParamsWireLayout;
+
+	// Body of a binary DMC01 'C' datagram, 4 bytes of padding before the
+	// doubles.
+	typedef WireLayout<64,
+		WireField<uint32_t, 0, WireAccess::Id>,
+		WireField<int32_t, 4, WireAccess::ImageWidth>,
+		WireField<int32_t, 8, WireAccess::ImageHeight>,
+		WireField<int32_t, 12, WireAccess::BlankLeft>,
+		WireField<int32_t, 16, WireAccess::BlankRight>,
+		WireField<int32_t, 20, WireAccess::BlankTop>,
+		WireField<int32_t, 24, WireAccess::BlankBottom>,
+		WireField<double, 32, WireAccess::ChipWidth>,
+		WireField<double, 40, WireAccess::ChipHeight>,
+		WireField<double, 48, WireAccess::FakeChipWidth>,
+		WireField<double, 56, WireAccess::FakeChipHeight>
+	> BinaryCameraConstantsWireLayout;
+
+	static_assert(GameEngineWireLayout::size == 124, "GameEngineOpen datagrams are 124 bytes");
+	static_assert(BinaryCameraParamsWireLayout::size == 200, "binary camera parameters are 200 bytes");
+	static_assert(BinaryCameraConstantsWireLayout::size == 64, "binary camera constants are 64 bytes");
+}
@@ -0,0 +1,224 @@
+/* Copyright 2021 TrackMen GmbH <mail@trackmen.de> */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "LiveLinkSourceSettings.h"
+#include "TrackMenCameraTrackingTypes.h"
+#include "UTrackMenLiveLinkSourceSettings.generated.h"
+
+// The enums below have the order of their TrackMen::Trk..._t counterparts.
+
+UENUM()
+enum class ETrackMenQueueMode : uint8
+{
+	Fifo UMETA(DisplayName = "FIFO"),
+	LatestOnly
+};
+
+UENUM()
+enum class ETrackMenOverflowPolicy : uint8
+{
+	DropOldest,
+	KeepLatest,
+	Block
+};
+
+UENUM()
+enum class ETrackMenSequencePolicy : uint8
+{
+	CountOnly,
+	DropLate,
+	Reorder
+};
+
+UENUM()
+enum class ETrackMenReceiveBackend : uint8
+{
+	Auto,
+	FSocket,
+	Recvmmsg,
+	IoUring UMETA(DisplayName = "io_uring")
+};
+
+UENUM()
+enum class ETrackMenThreadPriority : uint8
+{
+	Default,
+	High,
+	TimeCritical
+};
+
+UENUM()
+enum class ETrackMenPredictionModel : uint8
+{
+	None,
+	ConstantVelocity,
+	ConstantAcceleration,
+	Kalman
+};
+
+UENUM()
+enum class ETrackMenDelayUnit : uint8
+{
+	Microseconds,
+	Frames,
+	Fields
+};
+
+/** Speed adaptive smoothing of one channel of pose or lens. */
+USTRUCT()
+struct FTrackMenSmoothingChannel
+{
+	GENERATED_BODY()
+
+	/** Cutoff of a resting camera in Hz, lower smooths more; 0 = channel not filtered. */
+	UPROPERTY(EditAnywhere, Category = "TrackMen Smoothing", meta = (ClampMin = "0"))
+	float Cutoff = 1.0f;
+
+	/** Rise of the cutoff in Hz per unit/s of the channel, higher lags less when moving. */
+	UPROPERTY(EditAnywhere, Category = "TrackMen Smoothing", meta = (ClampMin = "0"))
+	float Beta = 1.0f;
+
+	FTrackMenSmoothingChannel() = default;
+	FTrackMenSmoothingChannel(float InCutoff, float InBeta) : Cutoff(InCutoff), Beta(InBeta) {}
+};
+
+/**
+* Source settings of a TrackMen camera source, shown in the LiveLink panel
+* and saved with LiveLink presets.
+*
+* LiveLinkCameraSource applies changes in OnSettingsChanged() while the
+* source keeps receiving; only port, backend, receive buffer and busy
+* polling reopen the socket. Every change is mirrored to the connection
+* string, so a preset recreates its sources with the tuned settings right
+* away.
+*/
+UCLASS()
+class TRACKMENVPCAM_API UTrackMenLiveLinkSourceSettings : public ULiveLinkSourceSettings
+{
+	GENERATED_BODY()
+
+public:
+	/** UDP port the tracking data is received on. Reopens the socket and renames the subject. */
+	UPROPERTY(EditAnywhere, Category = "TrackMen Receive", meta = (ClampMin = "1", ClampMax = "65535"))
+	int32 Port = 0;
+
+	/** Samples queued between the receiver and LiveLink. A smaller queue keeps the newest queued samples. */
+	UPROPERTY(EditAnywhere, Category = "TrackMen Receive", meta = (ClampMin = "1", ClampMax = "4096"))
+	int32 QueueDepth = 64;
+
+	/** FIFO hands every sample to LiveLink; LatestOnly keeps only the newest one, for live compositing. Demultiplexed sources always queue. */
+	UPROPERTY(EditAnywhere, Category = "TrackMen Receive")
+	ETrackMenQueueMode QueueMode = ETrackMenQueueMode::Fifo;
+
+	/** What happens to a sample that finds the queue full. */
+	UPROPERTY(EditAnywhere, Category = "TrackMen Receive")
+	ETrackMenOverflowPolicy OverflowPolicy = ETrackMenOverflowPolicy::DropOldest;
+
+	/** What happens to samples whose tracker counter is out of sequence: passed on and counted, dropped, or put back into order. */
+	UPROPERTY(EditAnywhere, Category = "TrackMen Receive")
+	ETrackMenSequencePolicy SequencePolicy = ETrackMenSequencePolicy::CountOnly;
+
+	/** Samples held back at most to put them back into order with Reorder, each adds a tracker period of latency. */
+	UPROPERTY(EditAnywhere, Category = "TrackMen Receive", meta = (ClampMin = "1", ClampMax = "32"))
+	int32 ReorderWindow = 2;
+
+	/** How datagrams are read from the socket. Reopens the socket; unused while a capture is replayed. */
+	UPROPERTY(EditAnywhere, Category = "TrackMen Receive")
+	ETrackMenReceiveBackend ReceiveBackend = ETrackMenReceiveBackend::Auto;
+
+	/** Socket receive buffer in bytes, 0 = system default. Reopens the socket. */
+	UPROPERTY(EditAnywhere, Category = "TrackMen Receive", meta = (ClampMin = "0"))
+	int32 ReceiveBuffer = 0;
+
+	/** Busy polling of the network device in microseconds, Linux only, 0 = off. Reopens the socket. */
+	UPROPERTY(EditAnywhere, Category = "TrackMen Receive", meta = (ClampMin = "0"))
+	int32 BusyPoll = 0;
+
+	/** Priority of the thread that receives and pushes the data. Anything but the default gives the source a thread of its own. */
+	UPROPERTY(EditAnywhere, Category = "TrackMen Receive")
+	ETrackMenThreadPriority ReceiverPriority = ETrackMenThreadPriority::Default;
+
+	/** CPUs the receiver thread may run on as a bit mask, e.g. 0x4; empty = any CPU. */
+	UPROPERTY(EditAnywhere, Category = "TrackMen Receive")
+	FString ReceiverCpus;
+
+	/** Priority of the push thread of the legacy polling mode. */
+	UPROPERTY(EditAnywhere, Category = "TrackMen Receive")
+	ETrackMenThreadPriority PushPriority = ETrackMenThreadPriority::Default;
+
+	/** CPUs the push thread of the legacy polling mode may run on; empty = any CPU. */
+	UPROPERTY(EditAnywhere, Category = "TrackMen Receive")
+	FString PushCpus;
+
+	/** Records the received datagrams to this file for a later Replay="<file>"; empty = no recording. A new file starts a new recording. */
+	UPROPERTY(EditAnywhere, Category = "TrackMen Receive")
+	FString CaptureFile;
+
+	/** Extrapolation of pose and lens to make up for the tracking latency. */
+	UPROPERTY(EditAnywhere, Category = "TrackMen Prediction")
+	ETrackMenPredictionModel PredictionModel = ETrackMenPredictionModel::None;
+
+	/** How far ahead of the arrival of a sample it is predicted, in milliseconds. */
+	UPROPERTY(EditAnywhere, Category = "TrackMen Prediction", meta = (ClampMin = "0", ClampMax = "500"))
+	float LeadTime = 0.0f;
+
+	/** Scales the camera accelerations the Kalman filter expects, lower smooths more. */
+	UPROPERTY(EditAnywhere, Category = "TrackMen Prediction", meta = (ClampMin = "0.01", ClampMax = "100"))
+	float KalmanAgility = 1.0f;
+
+	/** Smooths the encoder jitter of pose and lens, more at rest than in motion. Each channel below is tuned on its own. */
+	UPROPERTY(EditAnywhere, Category = "TrackMen Smoothing")
+	bool bSmoothing = false;
+
+	/** Position along X, beta in Hz per cm/s. */
+	UPROPERTY(EditAnywhere, Category = "TrackMen Smoothing")
+	FTrackMenSmoothingChannel SmoothX = FTrackMenSmoothingChannel(1.0f, 0.5f);
+
+	/** Position along Y, beta in Hz per cm/s. */
+	UPROPERTY(EditAnywhere, Category = "TrackMen Smoothing")
+	FTrackMenSmoothingChannel SmoothY = FTrackMenSmoothingChannel(1.0f, 0.5f);
+
+	/** Height, beta in Hz per cm/s. */
+	UPROPERTY(EditAnywhere, Category = "TrackMen Smoothing")
+	FTrackMenSmoothingChannel SmoothZ = FTrackMenSmoothingChannel(1.0f, 0.5f);
+
+	/** Pan, beta in Hz per degree/s. */
+	UPROPERTY(EditAnywhere, Category = "TrackMen Smoothing")
+	FTrackMenSmoothingChannel SmoothPan = FTrackMenSmoothingChannel(1.0f, 1.0f);
+
+	/** Tilt, beta in Hz per degree/s. */
+	UPROPERTY(EditAnywhere, Category = "TrackMen Smoothing")
+	FTrackMenSmoothingChannel SmoothTilt = FTrackMenSmoothingChannel(1.0f, 1.0f);
+
+	/** Roll, beta in Hz per degree/s. A handheld camera may want a calmer roll than pan. */
+	UPROPERTY(EditAnywhere, Category = "TrackMen Smoothing")
+	FTrackMenSmoothingChannel SmoothRoll = FTrackMenSmoothingChannel(1.0f, 1.0f);
+
+	/** Focal length, beta in Hz per mm/s. */
+	UPROPERTY(EditAnywhere, Category = "TrackMen Smoothing")
+	FTrackMenSmoothingChannel SmoothZoom = FTrackMenSmoothingChannel(1.0f, 2.0f);
+
+	/** Focus distance, beta in Hz per cm/s. */
+	UPROPERTY(EditAnywhere, Category = "TrackMen Smoothing")
+	FTrackMenSmoothingChannel SmoothFocus = FTrackMenSmoothingChannel(1.0f, 0.2f);
+
+	/** Holds the tracking back to match video that arrives later. */
+	UPROPERTY(EditAnywhere, Category = "TrackMen Delay", meta = (ClampMin = "0"))
+	float Delay = 0.0f;
+
+	UPROPERTY(EditAnywhere, Category = "TrackMen Delay")
+	ETrackMenDelayUnit DelayUnit = ETrackMenDelayUnit::Microseconds;
+
+	/** Samples kept per camera for the delay, limits the delay to this many tracker periods. A change starts the delay over. */
+	UPROPERTY(EditAnywhere, Category = "TrackMen Delay", meta = (ClampMin = "2", ClampMax = "65536"))
+	int32 DelayCapacity = 512;
+
+	// Copies the settings of a running source into the properties.
+	void FromTrackingOptions(uint16 InPort, const TrackMen::TrkTrackingOptions_t& Options, const TrackMen::TrkDelaySettings_t& InDelay);
+
+	// Overwrites the options the properties stand for, the rest of Options
+	// (multicast, backup path, replay, ...) stays as it is.
+	void ToTrackingOptions(uint16& OutPort, TrackMen::TrkTrackingOptions_t& Options, TrackMen::TrkDelaySettings_t& OutDelay) const;
+};
@@ -2,6 +2,7 @@
 
 #pragma once
 
+#include "Styling/SlateTypes.h"
 #include "Widgets/Text/STextBlock.h"
 #include "Widgets/SCompoundWidget.h"
 #include "Widgets/DeclarativeSyntaxSupport.h"
@@ -24,11 +25,19 @@ public:
 	FReply OnAddNewSourceClicked() const;
 
 	int Port = TRACKMEN_CAMERA_DEFAULT_PORT;
+	FString MulticastGroup; /* empty for unicast */
+	int BackupPort = 0; /* second port of the same stream, 0 for none */
+	bool Demultiplex = false; /* one subject per camera id */
 
 private:
 	TOptional<int> GetPort() const;
 
 	void OnPortChanged(const int InExampleInput);
+	void OnMulticastGroupChanged(const FText& InText);
+	TOptional<int> GetBackupPort() const;
+	void OnBackupPortChanged(const int InValue);
+	ECheckBoxState GetDemultiplexState() const;
+	void OnDemultiplexChanged(ECheckBoxState InState);
 
 	FOnAddNewSource onAddNewSource;
 };
\ No newline at end of file
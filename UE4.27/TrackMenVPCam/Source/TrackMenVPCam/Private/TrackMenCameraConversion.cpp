@@ -0,0 +1,80 @@
+/* Copyright 2021 TrackMen GmbH <mail@trackmen.de> */
+
+#include "TrackMenCameraConversion.h"
+
+#include <math.h>
+
+namespace TrackMen {
+
+	namespace {
+
+		static const double TRK_PI = 3.14159265358979323846;
+		static const double RAD_TO_DEG = 180.0 / TRK_PI;
+
+		static const unsigned trkCameraEuler = 0x0001;
+		static const unsigned trkFieldOfView = 0x0010;
+		static const unsigned trkVertical = 0x0020;
+	}
+
+	void matrix_to_rotator(const double m[4][4], double& pitch, double& yaw, double& roll) {
+		// Rows are the scaled X, Y and Z axes, as in FMatrix::GetScaledAxis().
+		const double* x_axis = m[0];
+		const double* y_axis = m[1];
+		const double* z_axis = m[2];
+
+		pitch = atan2(x_axis[2], sqrt(x_axis[0] * x_axis[0] + x_axis[1] * x_axis[1])) * RAD_TO_DEG;
+		yaw = atan2(x_axis[1], x_axis[0]) * RAD_TO_DEG;
+
+		// Y axis of the rotation matrix of (pitch, yaw, 0).
+		const double yaw_rad = yaw / RAD_TO_DEG;
+		const double sy_x = -sin(yaw_rad);
+		const double sy_y = cos(yaw_rad);
+		roll = atan2(z_axis[0] * sy_x + z_axis[1] * sy_y, y_axis[0] * sy_x + y_axis[1] * sy_y) * RAD_TO_DEG;
+	}
+
+	void convert_camera_frame(const TrkCameraParams_t& params, const TrkCameraConstants_t& constants, TrkCameraFrame_t& frame) {
+		// TODO: check format and convert data if necessary
+
+		double position[3];
+		double pan, tilt, roll;
+		if (!(params.format & trkCameraEuler)) {
+			// FMatrix::TransformPosition() of the origin is the translation row.
+			position[0] = params.t.m[3][0];
+			position[1] = params.t.m[3][1];
+			position[2] = params.t.m[3][2];
+			matrix_to_rotator(params.t.m, tilt, pan, roll);
+		}
+		else {
+			position[0] = params.t.e.x;
+			position[1] = params.t.e.y;
+			position[2] = params.t.e.z;
+			pan = params.t.e.pan;
+			tilt = params.t.e.tilt;
+			roll = params.t.e.roll;
+		}
+
+		// Public format, view direction Y, meters to centimeters.
+		frame.position[0] = -100.0 * position[0];
+		frame.position[1] = 100.0 * position[1];
+		frame.position[2] = 100.0 * position[2];
+		frame.yaw = -pan + 90.0;
+		frame.pitch = tilt;
+		frame.roll = roll;
+
+		if (params.format & trkFieldOfView) {
+			const double chip = (params.format & trkVertical) ? constants.chipHeight : constants.chipWidth;
+			frame.focalLength = 0.5 * chip / tan(TRK_PI * 0.5 * params.fov / 180.0);
+		}
+		else {
+			frame.focalLength = params.fov;
+		}
+		frame.lensDistortion[0] = params.k1;
+		frame.lensDistortion[1] = params.k2;
+		frame.centerShift[0] = params.centerX;
+		frame.centerShift[1] = params.centerY;
+		frame.focusDistance = params.focdist * 100.0;
+		frame.chipSize[0] = constants.chipWidth;
+		frame.chipSize[1] = constants.chipHeight;
+		frame.aperture = params.aperture;
+	}
+}
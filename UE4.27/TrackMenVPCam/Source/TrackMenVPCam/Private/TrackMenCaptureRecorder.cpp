@@ -0,0 +1,140 @@
+/* Copyright 2021 TrackMen GmbH <mail@trackmen.de> */
+
+#include "TrackMenCaptureRecorder.h"
+
+#include <chrono>
+#include <string.h>
+
+namespace TrackMen {
+
+	CaptureRecorder::CaptureRecorder() {
+		for (Page& page : m_pages) {
+			page.data.resize(PAGE_BYTES);
+		}
+	}
+
+	CaptureRecorder::~CaptureRecorder() {
+		close();
+	}
+
+	bool CaptureRecorder::open(const std::string& path) {
+		close();
+
+		m_file.open(path.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+		if (!m_file) {
+			return false;
+		}
+
+		TrkCaptureHeader_t header;
+		header.startSteadyNs = steady_time_ns();
+		header.startRealtimeNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::system_clock::now().time_since_epoch()).count();
+		uint8_t encoded[CaptureHeaderWireLayout::size];
+		CaptureHeaderWireLayout::encode(header, encoded);
+		if (!m_file.write((const char*)encoded, sizeof(encoded)).flush()) {
+			m_file.close();
+			return false;
+		}
+
+		for (Page& page : m_pages) {
+			page.size = 0;
+			page.full.store(false, std::memory_order_relaxed);
+		}
+		m_current = 0;
+		m_next_write = 0;
+		m_recorded = 0;
+		m_dropped = 0;
+		m_write_failed = false;
+
+		m_keep_writing = true;
+		m_writer = std::thread(&CaptureRecorder::writer_thread_func, this);
+		m_open = true;
+		return true;
+	}
+
+	void CaptureRecorder::close() {
+		if (!m_open) {
+			return;
+		}
+		m_open = false;
+
+		hand_over();
+		m_keep_writing = false;
+		m_page_signal.notify();
+		if (m_writer.joinable()) {
+			m_writer.join();
+		}
+		m_file.close();
+	}
+
+	void CaptureRecorder::record(uint16_t port, int64_t arrival_time_ns, const uint8_t* data, size_t length) {
+		const size_t record_size = CaptureRecordWireLayout::size + length;
+		if (!m_open || record_size > PAGE_BYTES) {
+			return;
+		}
+
+		if (m_pages[m_current].size + record_size > PAGE_BYTES) {
+			hand_over();
+		}
+		Page& page = m_pages[m_current];
+		if (page.full.load(std::memory_order_acquire)) {
+			// The writer did not catch up, never wait for the disk.
+			m_dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		TrkCaptureRecord_t record;
+		record.arrivalTimeNs = arrival_time_ns;
+		record.length = (uint32_t)length;
+		record.port = port;
+		uint8_t* destination = page.data.data() + page.size;
+		CaptureRecordWireLayout::encode(record, destination);
+		memcpy(destination + CaptureRecordWireLayout::size, data, length);
+
+		if (page.size == 0) {
+			page.first_arrival_ns = arrival_time_ns;
+		}
+		page.size += record_size;
+		m_recorded.fetch_add(1, std::memory_order_relaxed);
+
+		if (arrival_time_ns - page.first_arrival_ns >= FLUSH_INTERVAL_NS) {
+			hand_over();
+		}
+	}
+
+	void CaptureRecorder::hand_over() {
+		Page& page = m_pages[m_current];
+		if (page.size == 0 || page.full.load(std::memory_order_relaxed)) {
+			return;
+		}
+		page.full.store(true, std::memory_order_release);
+		m_page_signal.notify();
+		m_current ^= 1;
+	}
+
+	void CaptureRecorder::writer_thread_func() {
+		for (;;) {
+			// Pages handed over before close() are written before we leave.
+			const bool stop = !m_keep_writing.load();
+			write_full_pages();
+			if (stop) {
+				break;
+			}
+			m_page_signal.wait_for(std::chrono::milliseconds(100));
+		}
+	}
+
+	void CaptureRecorder::write_full_pages() {
+		// Pages are handed over alternately, so they are written in order.
+		while (m_pages[m_next_write].full.load(std::memory_order_acquire)) {
+			Page& page = m_pages[m_next_write];
+			if (!m_write_failed.load(std::memory_order_relaxed)
+				&& !m_file.write((const char*)page.data.data(), (std::streamsize)page.size).flush()) {
+				m_write_failed.store(true, std::memory_order_relaxed);
+			}
+			page.size = 0;
+			page.full.store(false, std::memory_order_release);
+			m_next_write ^= 1;
+		}
+	}
+}
@@ -0,0 +1,85 @@
+/* Copyright 2021 TrackMen GmbH <mail@trackmen.de> */
+
+#include "TrackMenDelayLine.h"
+#include "TrackMenPoseChannels.h"
+
+namespace TrackMen {
+
+	DelayLine::DelayLine(size_t capacity)
+		: m_entries(capacity > 2 ? capacity : 2) {
+	}
+
+	void DelayLine::reset() {
+		m_pushed = 0;
+		m_oldest = 0;
+		m_cursor = 0;
+	}
+
+	void DelayLine::push(const TrkCameraFrame_t& frame, uint32_t counter, int64_t time_ns) {
+		// Arrival times may run back a little, e.g. for samples that the
+		// sequence check released in counter order.
+		if (m_pushed > m_oldest) {
+			const int64_t newest_ns = entry(m_pushed - 1).time_ns;
+			if (time_ns < newest_ns - MAX_BACKWARDS_NS) {
+				reset();
+			}
+			else if (time_ns < newest_ns) {
+				time_ns = newest_ns;
+			}
+		}
+		Entry& added = m_entries[(size_t)(m_pushed % m_entries.size())];
+		added.time_ns = time_ns;
+		added.counter = counter;
+		added.frame = frame;
+		++m_pushed;
+		if (m_pushed - m_oldest > m_entries.size()) {
+			++m_oldest;
+		}
+	}
+
+	bool DelayLine::sample_at(int64_t time_ns, TrkCameraFrame_t& frame, uint32_t& counter) {
+		if (m_pushed == m_oldest) {
+			return false;
+		}
+
+		const uint64_t newest = m_pushed - 1;
+		if (m_cursor < m_oldest) {
+			m_cursor = m_oldest;
+		}
+		else if (m_cursor > newest) {
+			m_cursor = newest;
+		}
+		while (m_cursor < newest && entry(m_cursor + 1).time_ns <= time_ns) {
+			++m_cursor;
+		}
+		while (m_cursor > m_oldest && entry(m_cursor).time_ns > time_ns) {
+			--m_cursor;
+		}
+
+		const Entry& before = entry(m_cursor);
+		frame = before.frame;
+		counter = before.counter;
+		if (time_ns < before.time_ns) {
+			// Before the oldest frame: expected while the line fills up.
+			return size() < capacity();
+		}
+		if (m_cursor == newest) {
+			return true;
+		}
+
+		const Entry& after = entry(m_cursor + 1);
+		const double w = (double)(time_ns - before.time_ns) / (double)(after.time_ns - before.time_ns);
+		double a[TRK_POSE_CHANNELS];
+		double b[TRK_POSE_CHANNELS];
+		frame_to_channels(before.frame, a);
+		frame_to_channels(after.frame, b);
+		for (size_t c = 0; c < TRK_POSE_CHANNELS; ++c) {
+			if (is_angle_channel(c)) {
+				b[c] = unwrap_angle(b[c], a[c]);
+			}
+			a[c] += w * (b[c] - a[c]);
+		}
+		channels_to_frame(a, frame);
+		return true;
+	}
+}
@@ -0,0 +1,115 @@
+/* Copyright 2021 TrackMen GmbH <mail@trackmen.de> */
+
+#include "TrackMenDuplicateFilter.h"
+#include "TrackMenSequenceTracker.h"
+
+#include <string.h>
+
+namespace TrackMen {
+
+	void DuplicateFilter::reset() {
+		m_started = false;
+		m_highest = 0;
+		m_history = 0;
+		m_rejected_in_row = 0;
+		m_last_first_arrival_ns = 0;
+		m_last_first_path = 0;
+		memset(m_path_states, 0, sizeof(m_path_states));
+		m_period_ns = 0;
+		memset(m_first_path, 0, sizeof(m_first_path));
+		memset(m_first_arrival_ns, 0, sizeof(m_first_arrival_ns));
+	}
+
+	bool DuplicateFilter::first_arrival(uint32_t counter, size_t path, int64_t arrival_ns, size_t& first_path, int64_t& first_arrival_ns) {
+		bool repeated = false;
+		if (path < MAX_PATHS) {
+			PathState& state = m_path_states[path];
+			repeated = state.seen && state.counter == counter;
+			if (state.seen && arrival_ns > state.arrival_ns) {
+				const int64_t interval = arrival_ns - state.arrival_ns;
+				m_period_ns = (m_period_ns == 0) ? interval : m_period_ns + (interval - m_period_ns) / 8;
+			}
+			state.seen = true;
+			state.counter = counter;
+			state.arrival_ns = arrival_ns;
+		}
+		if (repeated) {
+			return first_arrival_by_time(counter, path, arrival_ns, first_path, first_arrival_ns);
+		}
+
+		if (!m_started) {
+			start(counter);
+			remember(counter, path, arrival_ns);
+			return true;
+		}
+
+		const int32_t distance = (int32_t)(counter - m_highest);
+		if (distance > 0) {
+			m_history = (distance < (int32_t)WINDOW) ? (m_history << distance) | 1 : 1;
+			m_highest = counter;
+			m_rejected_in_row = 0;
+			remember(counter, path, arrival_ns);
+			return true;
+		}
+
+		const uint32_t age = (uint32_t)-distance;
+		if (age < WINDOW) {
+			const uint64_t bit = (uint64_t)1 << age;
+			if (!(m_history & bit)) {
+				// Late, but the first copy.
+				m_history |= bit;
+				m_rejected_in_row = 0;
+				remember(counter, path, arrival_ns);
+				return true;
+			}
+			first_path = m_first_path[counter % WINDOW];
+			first_arrival_ns = m_first_arrival_ns[counter % WINDOW];
+		}
+		else if (-distance > SequenceTracker::RESYNC_DISTANCE) {
+			start(counter);
+			remember(counter, path, arrival_ns);
+			return true;
+		}
+		else {
+			// Too old to tell, whichever path it came on is far behind.
+			first_path = path;
+			first_arrival_ns = arrival_ns;
+		}
+
+		// New counters keep coming on some path as long as the tracker runs,
+		// only old ones means it restarted close by.
+		if (++m_rejected_in_row >= SequenceTracker::RESYNC_AFTER_REJECTS
+			&& arrival_ns - m_last_first_arrival_ns >= RESYNC_AFTER_NS) {
+			start(counter);
+			remember(counter, path, arrival_ns);
+			return true;
+		}
+		return false;
+	}
+
+	bool DuplicateFilter::first_arrival_by_time(uint32_t counter, size_t path, int64_t arrival_ns, size_t& first_path, int64_t& first_arrival_ns) {
+		if (m_started && m_period_ns > 0 && arrival_ns - m_last_first_arrival_ns < m_period_ns / 2) {
+			first_path = m_last_first_path;
+			first_arrival_ns = m_last_first_arrival_ns;
+			return false;
+		}
+		// Counters seen so far say nothing about the next ones.
+		start(counter);
+		remember(counter, path, arrival_ns);
+		return true;
+	}
+
+	void DuplicateFilter::start(uint32_t counter) {
+		m_started = true;
+		m_highest = counter;
+		m_history = 1;
+		m_rejected_in_row = 0;
+	}
+
+	void DuplicateFilter::remember(uint32_t counter, size_t path, int64_t arrival_ns) {
+		m_first_path[counter % WINDOW] = (uint8_t)path;
+		m_first_arrival_ns[counter % WINDOW] = arrival_ns;
+		m_last_first_arrival_ns = arrival_ns;
+		m_last_first_path = path;
+	}
+}
@@ -0,0 +1,135 @@
+/* Copyright 2021 TrackMen GmbH <mail@trackmen.de> */
+
+#include "TrackMenReceiveBackend.h"
+
+#include "Common/UdpSocketBuilder.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+
+#include <atomic>
+
+namespace TrackMen {
+
+	/**
+	* Receives datagrams through the engine socket subsystem, one Recv call
+	* per datagram. Works on every platform the engine supports.
+	*/
+	class FSocketReceiveBackend : public ReceiveBackend {
+	public:
+		~FSocketReceiveBackend() override { close(); }
+
+		const char* name() const override { return "FSocket"; }
+
+		bool open(uint16_t port, const TrkTrackingOptions_t& options) override {
+			close();
+			m_interrupted.store(false);
+			m_port = port;
+			m_bind_address = FIPv4Address::Any;
+
+			FUdpSocketBuilder builder = FUdpSocketBuilder(FString("CameraTrackingInterface ") + FString::FromInt(port))
+				.AsNonBlocking()
+				.AsReusable()
+				.BoundToPort(port);
+
+			if (!options.multicastGroup.empty()) {
+				// The socket subsystem knows neither source-specific multicast
+				// nor interfaces by name.
+				FIPv4Address group;
+				FIPv4Address multicast_interface = FIPv4Address::Any;
+				if (!options.multicastSource.empty()
+					|| !FIPv4Address::Parse(UTF8_TO_TCHAR(options.multicastGroup.c_str()), group)
+					|| !group.IsMulticastAddress()
+					|| (!options.multicastInterface.empty()
+						&& !FIPv4Address::Parse(UTF8_TO_TCHAR(options.multicastInterface.c_str()), multicast_interface))) {
+					return false;
+				}
+				// Stays bound to any address, Windows cannot bind to a group.
+				builder.JoinedToGroup(group, multicast_interface);
+			}
+			else if (!options.bindAddress.empty()) {
+				FIPv4Address bind_address;
+				if (!FIPv4Address::Parse(UTF8_TO_TCHAR(options.bindAddress.c_str()), bind_address)) {
+					return false;
+				}
+				builder.BoundToAddress(bind_address);
+				m_bind_address = bind_address;
+			}
+
+			if (options.receiveBufferSize > 0) {
+				builder.WithReceiveBufferSize(options.receiveBufferSize);
+			}
+
+			// Busy polling has no equivalent in the socket subsystem.
+			m_socket = builder.Build();
+
+			return m_socket != nullptr;
+		}
+
+		void close() override {
+			if (m_socket)
+			{
+				m_socket->Close();
+				ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(m_socket);
+				m_socket = nullptr;
+			}
+		}
+
+		bool wait(std::chrono::microseconds timeout) override {
+			if (m_interrupted.load()) {
+				return false;
+			}
+			const bool readable = m_socket->Wait(ESocketWaitConditions::WaitForRead, FTimespan::FromMicroseconds((double)timeout.count()));
+			return readable && !m_interrupted.load();
+		}
+
+		// The socket subsystem cannot interrupt Wait(), so an empty datagram
+		// to the port on loopback, or on the bound address, wakes it. Another
+		// reusable socket on the port may get it instead; the wait timeout
+		// still ends that wait. The flag makes every later wait() return
+		// right away, also one that starts after the datagram was received.
+		void interrupt() override {
+			m_interrupted.store(true);
+			ISocketSubsystem* subsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+			FSocket* sender = subsystem->CreateSocket(NAME_DGram, TEXT("CameraTrackingInterface wake-up"), FNetworkProtocolTypes::IPv4);
+			if (sender == nullptr) {
+				return;
+			}
+			TSharedRef<FInternetAddr> address = subsystem->CreateInternetAddr(FNetworkProtocolTypes::IPv4);
+			if (m_bind_address == FIPv4Address::Any) {
+				address->SetLoopbackAddress();
+			}
+			else {
+				address->SetIp(m_bind_address.Value);
+			}
+			address->SetPort(m_port);
+			uint8 empty = 0;
+			int32 bytes_sent = 0;
+			sender->SendTo(&empty, 0, bytes_sent, *address);
+			subsystem->DestroySocket(sender);
+		}
+
+		size_t receive(DatagramBatch& batch) override {
+			batch.clear();
+			size_t count = 0;
+			int32 bytes_read = 0;
+			while (count < batch.capacity()
+				&& m_socket->Recv(batch.data(count), (int32)TRK_MAX_DATAGRAM_SIZE, bytes_read)
+				&& bytes_read > 0) {
+				batch.set(count, bytes_read, steady_time_ns());
+				++count;
+			}
+			batch.set_size(count);
+			return count;
+		}
+
+	private:
+		FSocket* m_socket = nullptr;
+		uint16_t m_port = 0;
+		FIPv4Address m_bind_address;
+		std::atomic<bool> m_interrupted{ false };
+	};
+
+	std::unique_ptr<ReceiveBackend> create_fsocket_receive_backend() {
+		return std::unique_ptr<ReceiveBackend>(new FSocketReceiveBackend());
+	}
+}
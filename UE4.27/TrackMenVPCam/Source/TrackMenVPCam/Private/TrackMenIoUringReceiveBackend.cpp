@@ -0,0 +1,399 @@
+/* Copyright 2021 TrackMen GmbH <mail@trackmen.de> */
+
+#include "TrackMenReceiveBackend.h"
+
+// The io_uring backend talks to the kernel directly instead of depending on
+// liburing. It needs kernel headers that know about provided buffer rings
+// and multishot receive (Linux 6.0); older toolchain sysroots build the
+// nullptr factory instead.
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#if defined(IORING_RECV_MULTISHOT) && defined(__NR_io_uring_setup)
+#define TRK_HAS_IO_URING 1
+#endif
+#endif
+#endif
+
+#if defined(TRK_HAS_IO_URING)
+
+#include "TrackMenSocketTimestamps.h"
+#include "TrackMenUdpSocket.h"
+
+#include <errno.h>
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace TrackMen {
+
+	namespace {
+
+		int io_uring_setup(unsigned entries, io_uring_params* params) {
+			return (int)::syscall(__NR_io_uring_setup, entries, params);
+		}
+
+		int io_uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags, const void* arg, size_t arg_size) {
+			return (int)::syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, arg, arg_size);
+		}
+
+		int io_uring_register(int fd, unsigned opcode, const void* arg, unsigned nr_args) {
+			return (int)::syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+		}
+
+		unsigned load_acquire(const unsigned* value) {
+			return __atomic_load_n(value, __ATOMIC_ACQUIRE);
+		}
+
+		void store_release(unsigned* value, unsigned new_value) {
+			__atomic_store_n(value, new_value, __ATOMIC_RELEASE);
+		}
+	}
+
+	/**
+	* Receives with one multishot RECVMSG request per socket.
+	*
+	* The kernel keeps the request armed and places every datagram into a
+	* buffer taken from a provided buffer ring, so steady-state reception only
+	* reads completion queue entries from shared memory. A system call is made
+	* only to sleep in wait() or to re-arm the request after the kernel ended
+	* it (for example because all buffers were in use). The kernel receive
+	* timestamp is delivered as control data in front of each payload.
+	*/
+	class IoUringReceiveBackend : public ReceiveBackend {
+	public:
+		~IoUringReceiveBackend() override { close(); }
+
+		const char* name() const override { return "io_uring"; }
+
+		bool open(uint16_t port, const TrkTrackingOptions_t& options) override {
+			close();
+
+			size_t buffer_count = 64;
+			while (buffer_count < 2 * options.receiveBatchSize && buffer_count < 32768) {
+				buffer_count <<= 1;
+			}
+			m_buffer_count = (unsigned)buffer_count;
+
+			m_socket = open_udp_socket(port, options);
+			if (m_socket < 0 || !m_wait.open()) {
+				close();
+				return false;
+			}
+			m_kernel_timestamps = enable_socket_timestamps(m_socket, options);
+
+			if ( !setup_ring() || !setup_buffers() || !arm()) {
+				close();
+				return false;
+			}
+
+			// Kernels without multishot RECVMSG reject the request right away.
+			const io_uring_cqe* cqe = peek_cqe();
+			if (cqe && cqe->res == -EINVAL) {
+				close();
+				return false;
+			}
+			return true;
+		}
+
+		void close() override {
+			if (m_ring_fd >= 0) {
+				::close(m_ring_fd);
+				m_ring_fd = -1;
+			}
+			if (m_socket >= 0) {
+				::close(m_socket);
+				m_socket = -1;
+			}
+			unmap(m_sq_ring, m_sq_ring_size);
+			if (m_cq_ring != m_sq_ring) {
+				unmap(m_cq_ring, m_cq_ring_size);
+			}
+			m_cq_ring = nullptr;
+			unmap(m_sqes, m_sqes_size);
+			unmap(m_buffer_ring, m_buffer_ring_size);
+			unmap(m_buffers, m_buffers_size);
+			m_armed = false;
+			m_kernel_timestamps = false;
+			m_wait.close();
+		}
+
+		// The ring is readable while completions are pending.
+		int native_handle() const override {
+			return m_ring_fd;
+		}
+
+		bool kernel_timestamps() const override {
+			return m_kernel_timestamps;
+		}
+
+		bool wait(std::chrono::microseconds timeout) override {
+			if (!m_armed && !arm()) {
+				return false;
+			}
+			if (peek_cqe()) {
+				return true;
+			}
+
+			// The ring is readable while completions are pending, polling it
+			// together with the interrupt event lets stop() end the wait.
+			m_wait.wait(m_ring_fd, timeout);
+			return peek_cqe() != nullptr;
+		}
+
+		void interrupt() override {
+			m_wait.interrupt();
+		}
+
+		size_t receive(DatagramBatch& batch) override {
+			batch.clear();
+			size_t count = 0;
+			unsigned returned_buffers = 0;
+			const RealtimeToSteadyClock clock;
+
+			const io_uring_cqe* cqe;
+			while (count < batch.capacity() && (cqe = peek_cqe()) != nullptr) {
+				if (!(cqe->flags & IORING_CQE_F_MORE)) {
+					// The kernel ended the multishot request, it has to be
+					// submitted again once the buffers are back in the ring.
+					m_armed = false;
+				}
+
+				if (cqe->flags & IORING_CQE_F_BUFFER) {
+					const unsigned buffer_id = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+					uint8_t* buffer = m_buffers + (size_t)buffer_id * m_buffer_size;
+
+					if (cqe->res > 0) {
+						// The name and control areas have the sizes requested in
+						// m_message, out holds how much of them was used.
+						const io_uring_recvmsg_out* out = (const io_uring_recvmsg_out*)buffer;
+						uint8_t* control = buffer + sizeof(io_uring_recvmsg_out) + m_message.msg_namelen;
+						const uint8_t* payload = control + m_message.msg_controllen;
+						const size_t length = out->payloadlen < TRK_MAX_DATAGRAM_SIZE ? out->payloadlen : TRK_MAX_DATAGRAM_SIZE;
+						memcpy(batch.data(count), payload, length);
+
+						int64_t arrival_time_ns = clock.steady_now_ns();
+						if (m_kernel_timestamps) {
+							msghdr received;
+							memset(&received, 0, sizeof(received));
+							received.msg_control = control;
+							received.msg_controllen = out->controllen;
+							int64_t realtime_ns;
+							if (read_socket_timestamp_ns(received, realtime_ns)) {
+								arrival_time_ns = clock.to_steady_ns(realtime_ns);
+							}
+						}
+						batch.set(count, (int32_t)length, arrival_time_ns);
+						++count;
+					}
+
+					add_buffer(buffer_id, returned_buffers++);
+				}
+
+				advance_cq();
+			}
+
+			if (returned_buffers > 0) {
+				store_buffer_tail((uint16_t)(m_buffer_tail + returned_buffers));
+			}
+			if (!m_armed) {
+				arm();
+			}
+
+			batch.set_size(count);
+			return count;
+		}
+
+	private:
+		static const uint16_t BUFFER_GROUP = 0;
+
+		bool setup_ring() {
+			io_uring_params params;
+			memset(&params, 0, sizeof(params));
+			params.flags = IORING_SETUP_CQSIZE;
+			params.cq_entries = 2 * m_buffer_count;
+
+			// Fails with ENOSYS on old kernels and EPERM where io_uring is
+			// disabled by policy.
+			m_ring_fd = io_uring_setup(4, &params);
+			if (m_ring_fd < 0) {
+				m_ring_fd = -1;
+				return false;
+			}
+			if (!(params.features & IORING_FEAT_EXT_ARG)) {
+				return false;
+			}
+
+			m_sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+			m_cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+			if (params.features & IORING_FEAT_SINGLE_MMAP) {
+				m_sq_ring_size = m_cq_ring_size = (m_sq_ring_size > m_cq_ring_size) ? m_sq_ring_size : m_cq_ring_size;
+			}
+
+			m_sq_ring = map(m_sq_ring_size, m_ring_fd, IORING_OFF_SQ_RING);
+			if (!m_sq_ring) {
+				return false;
+			}
+			m_cq_ring = (params.features & IORING_FEAT_SINGLE_MMAP) ? m_sq_ring : map(m_cq_ring_size, m_ring_fd, IORING_OFF_CQ_RING);
+			m_sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+			m_sqes = (io_uring_sqe*)map(m_sqes_size, m_ring_fd, IORING_OFF_SQES);
+			if (!m_cq_ring || !m_sqes) {
+				return false;
+			}
+
+			m_sq_tail = (unsigned*)(m_sq_ring + params.sq_off.tail);
+			m_sq_mask = *(unsigned*)(m_sq_ring + params.sq_off.ring_mask);
+			m_sq_array = (unsigned*)(m_sq_ring + params.sq_off.array);
+			m_cq_head = (unsigned*)(m_cq_ring + params.cq_off.head);
+			m_cq_tail = (unsigned*)(m_cq_ring + params.cq_off.tail);
+			m_cq_mask = *(unsigned*)(m_cq_ring + params.cq_off.ring_mask);
+			m_cqes = (io_uring_cqe*)(m_cq_ring + params.cq_off.cqes);
+			return true;
+		}
+
+		bool setup_buffers() {
+			// Every buffer holds the recvmsg header, the control data and the
+			// payload.
+			m_buffer_size = sizeof(io_uring_recvmsg_out) + TRK_TIMESTAMP_CONTROL_SIZE + TRK_MAX_DATAGRAM_SIZE;
+			m_buffers_size = (size_t)m_buffer_count * m_buffer_size;
+			m_buffers = map(m_buffers_size, -1, 0);
+			m_buffer_ring_size = (size_t)m_buffer_count * sizeof(io_uring_buf);
+			m_buffer_ring = (io_uring_buf_ring*)map(m_buffer_ring_size, -1, 0);
+			if (!m_buffers || !m_buffer_ring) {
+				return false;
+			}
+
+			io_uring_buf_reg registration;
+			memset(&registration, 0, sizeof(registration));
+			registration.ring_addr = (uint64_t)(uintptr_t)m_buffer_ring;
+			registration.ring_entries = m_buffer_count;
+			registration.bgid = BUFFER_GROUP;
+			if (io_uring_register(m_ring_fd, IORING_REGISTER_PBUF_RING, &registration, 1) != 0) {
+				// Linux < 5.19
+				return false;
+			}
+
+			m_buffer_tail = 0;
+			for (unsigned i = 0; i < m_buffer_count; ++i) {
+				add_buffer(i, i);
+			}
+			store_buffer_tail((uint16_t)m_buffer_count);
+			return true;
+		}
+
+		// Submits the multishot receive request.
+		bool arm() {
+			const unsigned tail = *m_sq_tail;
+			io_uring_sqe* sqe = &m_sqes[tail & m_sq_mask];
+			memset(sqe, 0, sizeof(*sqe));
+			sqe->opcode = IORING_OP_RECVMSG;
+			sqe->fd = m_socket;
+			sqe->addr = (uint64_t)(uintptr_t)&m_message;
+			sqe->len = 1;
+			sqe->flags = IOSQE_BUFFER_SELECT;
+			sqe->ioprio = IORING_RECV_MULTISHOT;
+			sqe->buf_group = BUFFER_GROUP;
+
+			memset(&m_message, 0, sizeof(m_message));
+			m_message.msg_controllen = m_kernel_timestamps ? TRK_TIMESTAMP_CONTROL_SIZE : 0;
+
+			m_sq_array[tail & m_sq_mask] = tail & m_sq_mask;
+			store_release(m_sq_tail, tail + 1);
+
+			m_armed = io_uring_enter(m_ring_fd, 1, 0, 0, nullptr, 0) == 1;
+			return m_armed;
+		}
+
+		const io_uring_cqe* peek_cqe() const {
+			const unsigned head = *m_cq_head;
+			if (head == load_acquire(m_cq_tail)) {
+				return nullptr;
+			}
+			return &m_cqes[head & m_cq_mask];
+		}
+
+		void advance_cq() {
+			store_release(m_cq_head, *m_cq_head + 1);
+		}
+
+		// Writes a buffer into the ring at tail + offset. The kernel sees it
+		// after the next store_buffer_tail().
+		void add_buffer(unsigned buffer_id, unsigned offset) {
+			// Not m_buffer_ring->bufs: in C++ the flexible array member of the
+			// kernel header is preceded by an empty struct and lands at offset 8.
+			io_uring_buf* entry = (io_uring_buf*)m_buffer_ring + ((m_buffer_tail + offset) & (m_buffer_count - 1));
+			entry->addr = (uint64_t)(uintptr_t)(m_buffers + (size_t)buffer_id * m_buffer_size);
+			entry->len = (uint32_t)m_buffer_size;
+			entry->bid = (uint16_t)buffer_id;
+		}
+
+		void store_buffer_tail(uint16_t tail) {
+			m_buffer_tail = tail;
+			__atomic_store_n(&m_buffer_ring->tail, tail, __ATOMIC_RELEASE);
+		}
+
+		static uint8_t* map(size_t size, int fd, off_t offset) {
+			// Populated up front: the kernel pins the buffer ring pages when it
+			// is registered and would not see later copy-on-write faults.
+			const int flags = MAP_POPULATE | (fd >= 0 ? MAP_SHARED : (MAP_PRIVATE | MAP_ANONYMOUS));
+			void* memory = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, fd, offset);
+			return memory == MAP_FAILED ? nullptr : (uint8_t*)memory;
+		}
+
+		template <typename T>
+		static void unmap(T*& memory, size_t size) {
+			if (memory) {
+				::munmap(memory, size);
+				memory = nullptr;
+			}
+		}
+
+		int m_socket = -1;
+		int m_ring_fd = -1;
+		bool m_armed = false;
+		bool m_kernel_timestamps = false;
+		InterruptibleWait m_wait;
+		msghdr m_message;
+
+		uint8_t* m_sq_ring = nullptr;
+		size_t m_sq_ring_size = 0;
+		unsigned* m_sq_tail = nullptr;
+		unsigned* m_sq_array = nullptr;
+		unsigned m_sq_mask = 0;
+		io_uring_sqe* m_sqes = nullptr;
+		size_t m_sqes_size = 0;
+
+		uint8_t* m_cq_ring = nullptr;
+		size_t m_cq_ring_size = 0;
+		unsigned* m_cq_head = nullptr;
+		unsigned* m_cq_tail = nullptr;
+		unsigned m_cq_mask = 0;
+		io_uring_cqe* m_cqes = nullptr;
+
+		io_uring_buf_ring* m_buffer_ring = nullptr;
+		size_t m_buffer_ring_size = 0;
+		uint8_t* m_buffers = nullptr;
+		size_t m_buffers_size = 0;
+		size_t m_buffer_size = 0;
+		unsigned m_buffer_count = 0;
+		uint16_t m_buffer_tail = 0;
+	};
+
+	std::unique_ptr<ReceiveBackend> create_io_uring_receive_backend() {
+		return std::unique_ptr<ReceiveBackend>(new IoUringReceiveBackend());
+	}
+}
+
+#else
+
+namespace TrackMen {
+
+	std::unique_ptr<ReceiveBackend> create_io_uring_receive_backend() {
+		return nullptr;
+	}
+}
+
+#endif
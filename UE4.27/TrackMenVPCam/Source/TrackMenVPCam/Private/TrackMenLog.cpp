@@ -0,0 +1,33 @@
+/* Copyright 2021 TrackMen GmbH <mail@trackmen.de> */
+
+#include "TrackMenLog.h"
+
+#include <atomic>
+#include <stdarg.h>
+#include <stdio.h>
+
+namespace TrackMen {
+
+	namespace {
+
+		void log_to_stderr(TrkLogLevel_t level, const char* message) {
+			static const char* prefixes[] = { "Error: ", "Warning: ", "" };
+			fprintf(stderr, "TrackMen: %s%s\n", prefixes[level], message);
+		}
+
+		std::atomic<TrkLogHandler_t> log_handler{ &log_to_stderr };
+	}
+
+	void set_log_handler(TrkLogHandler_t handler) {
+		log_handler.store(handler ? handler : &log_to_stderr);
+	}
+
+	void log_message(TrkLogLevel_t level, const char* format, ...) {
+		char message[1024];
+		va_list arguments;
+		va_start(arguments, format);
+		vsnprintf(message, sizeof(message), format, arguments);
+		va_end(arguments);
+		log_handler.load()(level, message);
+	}
+}
@@ -0,0 +1,148 @@
+/* Copyright 2021 TrackMen GmbH <mail@trackmen.de> */
+
+#include "TrackMenPosePredictor.h"
+
+#include <cmath>
+
+namespace TrackMen {
+
+	namespace {
+
+		struct ChannelModel {
+			double measurementNoise; /* standard deviation of a tracker measurement */
+			double acceleration;     /* typical camera acceleration per second squared */
+		};
+
+		// Position in cm, angles in degrees, focal length in mm, focus in cm.
+		const ChannelModel CHANNEL_MODELS[PosePredictor::CHANNELS] = {
+			{ 0.05, 300.0 },
+			{ 0.05, 300.0 },
+			{ 0.05, 300.0 },
+			{ 0.01, 200.0 },
+			{ 0.01, 200.0 },
+			{ 0.01, 200.0 },
+			{ 0.01, 50.0 },
+			{ 1.0, 500.0 }
+		};
+	}
+
+	void PosePredictor::configure(const TrkPredictionSettings_t& settings) {
+		m_settings = settings;
+		reset();
+	}
+
+	void PosePredictor::reset() {
+		m_samples = 0;
+		m_clock.reset();
+	}
+
+	void PosePredictor::update(const TrkCameraFrame_t& frame, uint32_t counter, int64_t arrival_ns) {
+		double measured[CHANNELS];
+		frame_to_channels(frame, measured);
+
+		const double dt = m_clock.advance(counter, arrival_ns);
+		if (m_samples == 0 || dt < 0.0) {
+			start(measured);
+			return;
+		}
+		if (dt <= 1e-6) {
+			return;
+		}
+
+		for (size_t c = 0; c < CHANNELS; ++c) {
+			if (is_angle_channel(c)) {
+				measured[c] = unwrap_angle(measured[c], m_value[c]);
+			}
+			const double max_speed = channel_max_speed(c);
+			if (max_speed > 0.0 && std::fabs(measured[c] - m_value[c]) > max_speed * dt) {
+				start(measured);
+				return;
+			}
+		}
+
+		if (m_settings.model == TRK_PREDICTION_KALMAN) {
+			update_kalman(measured, dt);
+		}
+		else {
+			for (size_t c = 0; c < CHANNELS; ++c) {
+				const double velocity = (measured[c] - m_value[c]) / dt;
+				m_acceleration[c] = (m_samples >= 2) ? (velocity - m_velocity[c]) / (0.5 * (dt + m_dt)) : 0.0;
+				m_velocity[c] = velocity;
+				m_value[c] = measured[c];
+			}
+		}
+		m_dt = dt;
+		if (m_samples < 3) {
+			++m_samples;
+		}
+	}
+
+	void PosePredictor::update_kalman(const double* measured, double dt) {
+		const double agility = m_settings.kalmanAgility > 0.0 ? m_settings.kalmanAgility : 1.0;
+		const double dt2 = dt * dt;
+
+		for (size_t c = 0; c < CHANNELS; ++c) {
+			const ChannelModel& model = CHANNEL_MODELS[c];
+			const double acceleration = model.acceleration * agility;
+			const double q = acceleration * acceleration;
+			const double r = model.measurementNoise * model.measurementNoise;
+
+			// Predict with white noise acceleration.
+			double value = m_value[c] + m_velocity[c] * dt;
+			double p00 = m_p00[c] + dt * (2.0 * m_p01[c] + dt * m_p11[c]) + q * dt2 * dt2 * 0.25;
+			double p01 = m_p01[c] + dt * m_p11[c] + q * dt2 * dt * 0.5;
+			double p11 = m_p11[c] + q * dt2;
+
+			// Correct with the measurement.
+			const double innovation = measured[c] - value;
+			const double s = p00 + r;
+			const double k0 = p00 / s;
+			const double k1 = p01 / s;
+			value += k0 * innovation;
+			m_velocity[c] += k1 * innovation;
+			m_value[c] = value;
+			m_p11[c] = p11 - k1 * p01;
+			m_p01[c] = (1.0 - k0) * p01;
+			m_p00[c] = (1.0 - k0) * p00;
+		}
+	}
+
+	void PosePredictor::start(const double* measured) {
+		m_samples = 1;
+		m_dt = 0.0;
+		for (size_t c = 0; c < CHANNELS; ++c) {
+			const ChannelModel& model = CHANNEL_MODELS[c];
+			m_value[c] = measured[c];
+			m_velocity[c] = 0.0;
+			m_acceleration[c] = 0.0;
+			// The velocity is unknown, anything a camera does within a second.
+			m_p00[c] = model.measurementNoise * model.measurementNoise;
+			m_p01[c] = 0.0;
+			m_p11[c] = model.acceleration * model.acceleration;
+		}
+	}
+
+	void PosePredictor::extrapolate(TrkCameraFrame_t& frame, int64_t horizon_ns) const {
+		const TrkPredictionModel_t model = m_settings.model;
+		if (model == TRK_PREDICTION_NONE || m_samples == 0
+			|| (model != TRK_PREDICTION_KALMAN && m_samples < 2)) {
+			return;
+		}
+
+		const double h = (double)horizon_ns * 1e-9;
+		const bool accelerate = (model == TRK_PREDICTION_CONSTANT_ACCELERATION) && (m_samples >= 3);
+		double predicted[CHANNELS];
+		for (size_t c = 0; c < CHANNELS; ++c) {
+			if (accelerate) {
+				// The velocity was measured half a sample ago.
+				const double velocity = m_velocity[c] + 0.5 * m_acceleration[c] * m_dt;
+				predicted[c] = m_value[c] + velocity * h + 0.5 * m_acceleration[c] * h * h;
+			}
+			else {
+				predicted[c] = m_value[c] + m_velocity[c] * h;
+			}
+		}
+
+		channels_to_frame(predicted, frame);
+	}
+}
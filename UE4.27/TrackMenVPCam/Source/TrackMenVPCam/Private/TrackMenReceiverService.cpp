@@ -0,0 +1,216 @@
+/* Copyright 2021 TrackMen GmbH <mail@trackmen.de> */
+
+#include "TrackMenReceiverService.h"
+
+#if defined(__linux__)
+
+#include <atomic>
+#include <thread>
+#include <unordered_map>
+
+#include <errno.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace TrackMen {
+
+	struct ReceiverService::Impl {
+		// Epoll data of the eventfd that interrupts the thread on shutdown.
+		static const uint64_t WAKE_ID = 0;
+
+		int epoll_fd = -1;
+		int wake_fd = -1;
+		std::thread thread;
+		std::atomic<bool> keep_running{ false };
+
+		// Held while the thread dispatches, so remove() can wait for a running
+		// on_readable(). Events carry an id instead of the client pointer: an
+		// event that was returned by epoll_wait() before its client was
+		// removed is simply not found anymore.
+		std::mutex dispatch_mutex;
+		struct Registration {
+			uint64_t id;
+			int handle;
+		};
+		std::unordered_map<uint64_t, Client*> clients;
+		std::unordered_map<Client*, Registration> registrations;
+		uint64_t next_id = WAKE_ID + 1;
+
+		Impl() {
+			epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+			wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+			if (epoll_fd >= 0 && wake_fd >= 0) {
+				epoll_event event = {};
+				event.events = EPOLLIN;
+				event.data.u64 = WAKE_ID;
+				epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_fd, &event);
+			}
+		}
+
+		~Impl() {
+			stop();
+			if (wake_fd >= 0) {
+				::close(wake_fd);
+			}
+			if (epoll_fd >= 0) {
+				::close(epoll_fd);
+			}
+		}
+
+		bool valid() const {
+			return epoll_fd >= 0 && wake_fd >= 0;
+		}
+
+		void start() {
+			if (!thread.joinable()) {
+				keep_running = true;
+				thread = std::thread(&Impl::run, this);
+			}
+		}
+
+		void stop() {
+			if (thread.joinable()) {
+				keep_running = false;
+				const uint64_t one = 1;
+				ssize_t written = ::write(wake_fd, &one, sizeof(one));
+				(void)written;
+				thread.join();
+			}
+		}
+
+		void run() {
+			static const int MAX_EVENTS = 64;
+			epoll_event events[MAX_EVENTS];
+
+			while (keep_running) {
+				const int count = epoll_wait(epoll_fd, events, MAX_EVENTS, -1);
+				if (count < 0) {
+					if (errno == EINTR) {
+						continue;
+					}
+					break;
+				}
+
+				std::lock_guard<std::mutex> lock(dispatch_mutex);
+				for (int i = 0; i < count; ++i) {
+					const uint64_t id = events[i].data.u64;
+					if (id == WAKE_ID) {
+						uint64_t value;
+						ssize_t bytes = ::read(wake_fd, &value, sizeof(value));
+						(void)bytes;
+						continue;
+					}
+					auto client = clients.find(id);
+					if (client != clients.end()) {
+						client->second->on_readable();
+					}
+				}
+			}
+		}
+	};
+
+	bool ReceiverService::is_supported() {
+		return true;
+	}
+
+	ReceiverService::ReceiverService()
+		: m_impl(new Impl()) {
+	}
+
+	ReceiverService::~ReceiverService() {
+	}
+
+	ReceiverService& ReceiverService::get() {
+		static ReceiverService service;
+		return service;
+	}
+
+	bool ReceiverService::add(int handle, Client* client) {
+		std::lock_guard<std::mutex> registration(m_registration_mutex);
+		if (!m_impl->valid() || handle < 0 || m_impl->registrations.count(client)) {
+			return false;
+		}
+
+		const uint64_t id = m_impl->next_id++;
+		{
+			std::lock_guard<std::mutex> lock(m_impl->dispatch_mutex);
+			m_impl->clients[id] = client;
+			m_impl->registrations[client] = { id, handle };
+		}
+
+		// Level-triggered: a client that leaves data unread is called again.
+		epoll_event event = {};
+		event.events = EPOLLIN;
+		event.data.u64 = id;
+		if (epoll_ctl(m_impl->epoll_fd, EPOLL_CTL_ADD, handle, &event) != 0) {
+			std::lock_guard<std::mutex> lock(m_impl->dispatch_mutex);
+			m_impl->clients.erase(id);
+			m_impl->registrations.erase(client);
+			return false;
+		}
+
+		m_impl->start();
+		return true;
+	}
+
+	void ReceiverService::remove(Client* client) {
+		std::lock_guard<std::mutex> registration(m_registration_mutex);
+		auto registration_it = m_impl->registrations.find(client);
+		if (registration_it == m_impl->registrations.end()) {
+			return;
+		}
+
+		epoll_ctl(m_impl->epoll_fd, EPOLL_CTL_DEL, registration_it->second.handle, nullptr);
+		{
+			std::lock_guard<std::mutex> lock(m_impl->dispatch_mutex);
+			m_impl->clients.erase(registration_it->second.id);
+			m_impl->registrations.erase(registration_it);
+		}
+
+		if (m_impl->registrations.empty()) {
+			m_impl->stop();
+		}
+	}
+
+	size_t ReceiverService::client_count() {
+		std::lock_guard<std::mutex> registration(m_registration_mutex);
+		return m_impl->registrations.size();
+	}
+}
+
+#else
+
+namespace TrackMen {
+
+	struct ReceiverService::Impl {
+	};
+
+	bool ReceiverService::is_supported() {
+		return false;
+	}
+
+	ReceiverService::ReceiverService() {
+	}
+
+	ReceiverService::~ReceiverService() {
+	}
+
+	ReceiverService& ReceiverService::get() {
+		static ReceiverService service;
+		return service;
+	}
+
+	bool ReceiverService::add(int handle, Client* client) {
+		return false;
+	}
+
+	void ReceiverService::remove(Client* client) {
+	}
+
+	size_t ReceiverService::client_count() {
+		return 0;
+	}
+}
+
+#endif
@@ -0,0 +1,132 @@
+/* Copyright 2021 TrackMen GmbH <mail@trackmen.de> */
+
+#include "TrackMenReceiveBackend.h"
+
+#if defined(__linux__)
+
+#include "TrackMenSocketTimestamps.h"
+#include "TrackMenUdpSocket.h"
+
+#include <errno.h>
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace TrackMen {
+
+	/**
+	* Receives up to a whole batch of datagrams with a single recvmmsg() call.
+	* Every datagram carries its own kernel receive timestamp.
+	*/
+	class RecvmmsgReceiveBackend : public ReceiveBackend {
+	public:
+		~RecvmmsgReceiveBackend() override { close(); }
+
+		const char* name() const override { return "recvmmsg"; }
+
+		bool open(uint16_t port, const TrkTrackingOptions_t& options) override {
+			close();
+
+			m_socket = open_udp_socket(port, options);
+			if (m_socket < 0 || !m_wait.open()) {
+				close();
+				return false;
+			}
+
+			m_kernel_timestamps = enable_socket_timestamps(m_socket, options);
+
+			const size_t batch_size = options.receiveBatchSize > 0 ? options.receiveBatchSize : 1;
+			m_messages.assign(batch_size, mmsghdr());
+			m_iovecs.assign(batch_size, iovec());
+			m_control.assign(m_kernel_timestamps ? batch_size * TRK_TIMESTAMP_CONTROL_SIZE : 0, 0);
+			return true;
+		}
+
+		void close() override {
+			if (m_socket >= 0) {
+				::close(m_socket);
+				m_socket = -1;
+			}
+			m_wait.close();
+		}
+
+		int native_handle() const override {
+			return m_socket;
+		}
+
+		bool kernel_timestamps() const override {
+			return m_kernel_timestamps;
+		}
+
+		bool wait(std::chrono::microseconds timeout) override {
+			return m_wait.wait(m_socket, timeout);
+		}
+
+		void interrupt() override {
+			m_wait.interrupt();
+		}
+
+		size_t receive(DatagramBatch& batch) override {
+			batch.clear();
+			const size_t count = batch.capacity() < m_messages.size() ? batch.capacity() : m_messages.size();
+
+			// The message headers point into the preallocated batch buffers.
+			for (size_t i = 0; i < count; ++i) {
+				m_iovecs[i].iov_base = batch.data(i);
+				m_iovecs[i].iov_len = TRK_MAX_DATAGRAM_SIZE;
+				memset(&m_messages[i].msg_hdr, 0, sizeof(m_messages[i].msg_hdr));
+				m_messages[i].msg_hdr.msg_iov = &m_iovecs[i];
+				m_messages[i].msg_hdr.msg_iovlen = 1;
+				if (m_kernel_timestamps) {
+					m_messages[i].msg_hdr.msg_control = &m_control[i * TRK_TIMESTAMP_CONTROL_SIZE];
+					m_messages[i].msg_hdr.msg_controllen = TRK_TIMESTAMP_CONTROL_SIZE;
+				}
+				m_messages[i].msg_len = 0;
+			}
+
+			int received;
+			do {
+				received = ::recvmmsg(m_socket, m_messages.data(), (unsigned)count, MSG_DONTWAIT, nullptr);
+			} while (received < 0 && errno == EINTR);
+
+			if (received <= 0) {
+				return 0;
+			}
+
+			const RealtimeToSteadyClock clock;
+			for (size_t i = 0; i < (size_t)received; ++i) {
+				int64_t realtime_ns;
+				const int64_t arrival_time_ns = (m_kernel_timestamps && read_socket_timestamp_ns(m_messages[i].msg_hdr, realtime_ns))
+					? clock.to_steady_ns(realtime_ns)
+					: clock.steady_now_ns();
+				batch.set(i, (int32_t)m_messages[i].msg_len, arrival_time_ns);
+			}
+			batch.set_size((size_t)received);
+			return (size_t)received;
+		}
+
+	private:
+		int m_socket = -1;
+		std::vector<mmsghdr> m_messages;
+		std::vector<iovec> m_iovecs;
+		std::vector<uint8_t> m_control;
+		bool m_kernel_timestamps = false;
+		InterruptibleWait m_wait;
+	};
+
+	std::unique_ptr<ReceiveBackend> create_recvmmsg_receive_backend() {
+		return std::unique_ptr<ReceiveBackend>(new RecvmmsgReceiveBackend());
+	}
+}
+
+#else
+
+namespace TrackMen {
+
+	std::unique_ptr<ReceiveBackend> create_recvmmsg_receive_backend() {
+		return nullptr;
+	}
+}
+
+#endif
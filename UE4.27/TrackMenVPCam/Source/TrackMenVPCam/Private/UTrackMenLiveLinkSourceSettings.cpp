@@ -0,0 +1,92 @@
+/* Copyright 2021 TrackMen GmbH <mail@trackmen.de> */
+
+#include "UTrackMenLiveLinkSourceSettings.h"
+
+using namespace TrackMen;
+
+static FString CpusToString(uint64 Mask)
+{
+	return Mask == 0 ? FString() : FString::Printf(TEXT("0x%llx"), (unsigned long long)Mask);
+}
+
+static uint64 CpusFromString(const FString& Cpus)
+{
+	// Decimal or 0x hex, like the connection string.
+	return Cpus.IsEmpty() ? 0 : FCString::Strtoui64(*Cpus.TrimStartAndEnd(), nullptr, 0);
+}
+
+void UTrackMenLiveLinkSourceSettings::FromTrackingOptions(uint16 InPort, const TrkTrackingOptions_t& Options, const TrkDelaySettings_t& InDelay)
+{
+	Port = InPort;
+	QueueDepth = (int32)Options.queueDepth;
+	QueueMode = (ETrackMenQueueMode)Options.queueMode;
+	OverflowPolicy = (ETrackMenOverflowPolicy)Options.overflowPolicy;
+	SequencePolicy = (ETrackMenSequencePolicy)Options.sequencePolicy;
+	ReorderWindow = (int32)Options.reorderWindow;
+	if (Options.receiveBackend != TRK_BACKEND_REPLAY) {
+		ReceiveBackend = (ETrackMenReceiveBackend)Options.receiveBackend;
+	}
+	ReceiveBuffer = Options.receiveBufferSize;
+	BusyPoll = Options.busyPollMicroseconds;
+	ReceiverPriority = (ETrackMenThreadPriority)Options.receiverThread.priority;
+	ReceiverCpus = CpusToString(Options.receiverThread.affinityMask);
+	PushPriority = (ETrackMenThreadPriority)Options.pushThread.priority;
+	PushCpus = CpusToString(Options.pushThread.affinityMask);
+	CaptureFile = UTF8_TO_TCHAR(Options.captureFile.c_str());
+	DelayCapacity = (int32)Options.delay.capacity;
+
+	PredictionModel = (ETrackMenPredictionModel)Options.prediction.model;
+	LeadTime = (float)Options.prediction.leadTimeMs;
+	KalmanAgility = (float)Options.prediction.kalmanAgility;
+
+	// In the order of TrkPoseChannel_t.
+	FTrackMenSmoothingChannel* smoothing[TRK_POSE_CHANNELS] = {
+		&SmoothX, &SmoothY, &SmoothZ, &SmoothTilt, &SmoothPan, &SmoothRoll, &SmoothZoom, &SmoothFocus
+	};
+	bSmoothing = Options.jitterFilter.enabled;
+	for (int32 channel = 0; channel < TRK_POSE_CHANNELS; ++channel) {
+		smoothing[channel]->Cutoff = (float)Options.jitterFilter.channels[channel].minCutoffHz;
+		smoothing[channel]->Beta = (float)Options.jitterFilter.channels[channel].beta;
+	}
+
+	Delay = (float)InDelay.amount;
+	DelayUnit = (ETrackMenDelayUnit)InDelay.unit;
+}
+
+void UTrackMenLiveLinkSourceSettings::ToTrackingOptions(uint16& OutPort, TrkTrackingOptions_t& Options, TrkDelaySettings_t& OutDelay) const
+{
+	OutPort = (uint16)FMath::Clamp(Port, 1, 65535);
+	Options.queueDepth = (size_t)FMath::Clamp(QueueDepth, 1, 4096);
+	Options.queueMode = (TrkQueueMode_t)QueueMode;
+	Options.overflowPolicy = (TrkOverflowPolicy_t)OverflowPolicy;
+	Options.sequencePolicy = (TrkSequencePolicy_t)SequencePolicy;
+	Options.reorderWindow = (size_t)FMath::Clamp(ReorderWindow, 1, 32);
+	if (Options.receiveBackend != TRK_BACKEND_REPLAY) {
+		Options.receiveBackend = (TrkReceiveBackend_t)ReceiveBackend;
+	}
+	Options.receiveBufferSize = FMath::Max(0, ReceiveBuffer);
+	Options.busyPollMicroseconds = FMath::Max(0, BusyPoll);
+	Options.receiverThread.priority = (TrkThreadPriority_t)ReceiverPriority;
+	Options.receiverThread.affinityMask = CpusFromString(ReceiverCpus);
+	Options.pushThread.priority = (TrkThreadPriority_t)PushPriority;
+	Options.pushThread.affinityMask = CpusFromString(PushCpus);
+	Options.captureFile = TCHAR_TO_UTF8(*CaptureFile.TrimStartAndEnd());
+	Options.delay.capacity = (size_t)FMath::Clamp(DelayCapacity, 2, 65536);
+
+	Options.prediction.model = (TrkPredictionModel_t)PredictionModel;
+	Options.prediction.leadTimeMs = FMath::Max(0.0f, LeadTime);
+	Options.prediction.kalmanAgility = KalmanAgility > 0.0f ? KalmanAgility : 1.0f;
+
+	const FTrackMenSmoothingChannel* smoothing[TRK_POSE_CHANNELS] = {
+		&SmoothX, &SmoothY, &SmoothZ, &SmoothTilt, &SmoothPan, &SmoothRoll, &SmoothZoom, &SmoothFocus
+	};
+	Options.jitterFilter.enabled = bSmoothing;
+	for (int32 channel = 0; channel < TRK_POSE_CHANNELS; ++channel) {
+		Options.jitterFilter.channels[channel].minCutoffHz = FMath::Max(0.0f, smoothing[channel]->Cutoff);
+		Options.jitterFilter.channels[channel].beta = FMath::Max(0.0f, smoothing[channel]->Beta);
+	}
+
+	Options.delay.amount = FMath::Max(0.0f, Delay);
+	Options.delay.unit = (TrkDelayUnit_t)DelayUnit;
+	OutDelay = Options.delay;
+}
@@ -6,6 +6,11 @@
 #include "ILiveLinkSource.h"
 #include "LiveLinkClient.h"
 #include "TrackMenCameraTrackingInterface.h"
+#include "TrackMenDelayLine.h"
+#include "TrackMenJitterFilter.h"
+#include "TrackMenPosePredictor.h"
+#include "UTrackMenLiveLinkSourceSettings.h"
+#include <atomic>
 #include <thread>
 #include <mutex>
 
@@ -21,8 +26,9 @@ namespace TrackMen {
 	*/
 	class TRACKMENVPCAM_API LiveLinkCameraSource : public ILiveLinkSource {
 	public:
-		LiveLinkCameraSource(const FText& InSourceType, const FText& InSourceMachineName, uint16_t port);
-		virtual ~LiveLinkCameraSource() {}
+		LiveLinkCameraSource(const FText& InSourceType, const FText& InSourceMachineName, uint16_t port,
+			const TrkTrackingOptions_t& options = TrkTrackingOptions_t());
+		virtual ~LiveLinkCameraSource() { StopTrackingThreads(); }
 
 		// ILiveLinkSource Interface
 		void InitializeSettings(ULiveLinkSourceSettings* Settings) override;
@@ -33,35 +39,97 @@ namespace TrackMen {
 		FText GetSourceType() const override;
 		FText GetSourceMachineName() const override;
 		FText GetSourceStatus() const override;
-		TSubclassOf<ULiveLinkSourceSettings> GetSettingsClass() const override { return ULiveLinkSourceSettings::StaticClass(); }
+		TSubclassOf<ULiveLinkSourceSettings> GetSettingsClass() const override { return UTrackMenLiveLinkSourceSettings::StaticClass(); }
+
+		// Changes the delay of the tracking while the source runs. Game
+		// thread; the capacity of the delay lines stays as created.
+		void SetDelay(const TrkDelaySettings_t& delay);
 
 	private:
 		void CreateMySubject();
 
 		FText sourceType;
 		FText sourceMachineName;
-		FText sourceStatus;
 		FName subjectName;
-		ILiveLinkClient* client;
+		ILiveLinkClient* client = nullptr;
 		FGuid sourceGUID;
 
 		// Tracking infrastructure methods
 		void StartTrackingThreads();
+		void StopTrackingThreads();
 		void TrackingThreadMain();
 		TrkErrorType_t CheckTrackingInterfaceErrors();
-		void PushFrameToSubject(const FTrackMenCameraFrameData &frame);
-		void PushStaticToSubjectIfChipSizeChanged(const FVector2D &old_chip_size, const FTrackMenCameraFrameData &frame);
-		void PushStaticToSubject(const FTrackMenCameraStaticData& static_data);
+		void ResetSampleProcessing();
+		void ProcessPendingSamples();
+		struct FCameraSubject;
+		FCameraSubject& FindOrAddCameraSubject(uint32 cameraId);
+		void PushFrameToSubject(const FName& cameraSubjectName, const FTrackMenCameraFrameData &frame);
+		void PushStaticToSubjectIfChipSizeChanged(FCameraSubject& subject, const FTrackMenCameraFrameData &frame);
+		void PushStaticToSubject(const FName& cameraSubjectName, const FTrackMenCameraStaticData& static_data);
+		void UpdateDelay();
+		FString BuildConnectionString() const;
+		void ApplySettings(const UTrackMenLiveLinkSourceSettings& settings);
+		void UpdateReceivePath(const TrkTrackingOptions_t& options);
+		void RemoveMySubjects();
+		void UpdateSourceMachineName();
+		void ApplyProcessingSettings(uint32 generation);
 
 		// Tracking infrastructure members
-		bool keepTrackingThreadRunning = false;
-		bool isTrackingThreadRunning = false;
+		std::atomic<bool> keepTrackingThreadRunning{ false };
 		std::thread trackingThread;
 		uint16_t udpPort = 0;
+		TrkTrackingOptions_t trackingOptions;
 		CameraTrackingInterface trackingInterface;
 		FLiveLinkSubjectPreset subjectPreset;
 		FFrameRate frameRate;
-		bool sentStaticOnce = false;
+
+		// Delay of the pushed frames, set on the game thread and read by
+		// whichever thread pushes. Frames and fields depend on frameRate.
+		TrkDelaySettings_t delaySettings;
+		std::atomic<int64> delayNs{ 0 };
+
+		// Processing of the pushed frames. The game thread sets the pending
+		// settings and counts up the generation, the pushing thread takes
+		// them over before its next batch.
+		struct FProcessingSettings {
+			TrkJitterFilterSettings_t jitterFilter;
+			TrkPredictionSettings_t prediction;
+			size_t delayCapacity = 0;
+			int32 batchSize = 1;
+		};
+		static FProcessingSettings ProcessingSettingsFor(const TrkTrackingOptions_t& options);
+		std::mutex processingMutex;
+		FProcessingSettings pendingProcessing;
+		std::atomic<uint32> processingGeneration{ 0 };
+		uint32 appliedProcessingGeneration = 0;
+		FProcessingSettings activeProcessing;
+
+		// One LiveLink subject per camera. Keyed by the camera id if the
+		// source demultiplexes, otherwise the port has a single camera under
+		// key 0 and the subject of subjectPreset.
+		struct FCameraSubject {
+			FName subjectName;
+			TrkCameraConstants_t constants;
+			FVector2D chipSize;
+			bool sentStatic = false;
+			JitterFilter jitterFilter;
+			PosePredictor predictor;
+			DelayLine delayLine;
+			bool delayExceeded = false;
+		};
+
+		// Sample processing state, owned by whichever thread drains the queue.
+		// Cameras are added on first sight of their id.
+		TArray<TrkCameraSample_t> samples;
+		TMap<uint32, FCameraSubject> cameraSubjects;
+		std::atomic<int32> cameraCount{ 0 };
+
+		// Status column text, rebuilt from the statistics about once a second
+		// by GetSourceStatus().
+		mutable FText sourceStatus;
+		mutable int64 sourceStatusTimeNs = 0;
+		mutable SourceStatisticsSampler statisticsSampler;
+		mutable uint64 pathFirstArrivals[CameraTrackingInterface::MAX_RECEIVE_PATHS] = {};
 	};
 
 }
\ No newline at end of file
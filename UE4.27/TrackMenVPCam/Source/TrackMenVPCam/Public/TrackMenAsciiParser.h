@@ -0,0 +1,28 @@
+/* Copyright 2021 TrackMen GmbH <mail@trackmen.de> */
+
+#pragma once
+
+#include "TrackMenCameraTrackingTypes.h"
+
+#include <stddef.h>
+
+namespace TrackMen {
+
+	// Parsers for the body of ASCII "DMC01" datagrams (everything after the
+	// 8 byte header). They work on the datagram bytes directly and do not
+	// allocate.
+	//
+	// The accepted syntax and the parsed values are those of the previous
+	// std::istream based parser in the "C" locale: fields are separated by
+	// white space, a number ends at the first character that cannot continue
+	// it, and any field that cannot be read rejects the whole datagram.
+	// On failure the output may be partially written.
+
+	// Optional "I<id>", the format bit mask in hex, 6 Euler values or a 3x4
+	// matrix, then fov, centerX, centerY, k1, k2, focdist, aperture, counter.
+	bool parse_ascii_camera_params(const char* text, size_t length, TrkCameraParams_t& params);
+
+	// imageWidth, imageHeight, blankLeft, blankRight, blankTop, blankBottom,
+	// chipWidth, chipHeight, fakeChipWidth, fakeChipHeight.
+	bool parse_ascii_camera_constants(const char* text, size_t length, TrkCameraConstants_t& constants);
+}
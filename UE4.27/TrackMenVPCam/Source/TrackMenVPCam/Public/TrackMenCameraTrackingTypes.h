@@ -0,0 +1,313 @@
+/* Copyright 2021 TrackMen GmbH <mail@trackmen.de> */
+
+#pragma once
+
+// Plain tracking data types. This header must not depend on engine headers
+// so that the receive path can be built and benchmarked outside the editor.
+
+#include <chrono>
+#include <string>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace TrackMen {
+
+	// Time base of all arrival timestamps in the receive path.
+	inline int64_t steady_time_ns() {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	enum TrkErrorType_t {
+		TRK_ERROR_NO_ERROR,
+		TRK_ERROR_CANNOT_CREATE_HANDLE_FOR_PORT,
+		TRK_ERROR_NO_HANDLE_ON_THIS_PORT,
+		NUM_ERRORS
+	};
+
+	union TrkTransform_t  {
+		double m[4][4]; /* m [j] [i] is matrix element */
+						/* in row i, column j */
+		struct {
+			double x;
+			double y;
+			double z;
+			double pan;
+			double tilt;
+			double roll;
+		} e; /* "Euler" angles */
+
+	};
+
+	struct TrkCameraParams_t {
+		unsigned id = 0;/* == 0 if not explicitly specified */
+
+		unsigned format = 0; /* bit mask of format options */
+
+		TrkTransform_t t; /* coordinate transformation */
+		double fov = 20.0;     /* field of view or image distance */
+		double centerX = 0.0; /* center shift */
+		double centerY = 0.0;
+
+		double k1 = 0.0; /* distorsion coefficients */
+		double k2 = 0.0;
+
+		double focdist = 100000.0; /* depth of field simulation */
+		double aperture = 1.0;
+
+		unsigned long counter = 0;
+
+	};
+
+	struct TrkCameraConstants_t {
+		unsigned id = 0; /* == 0 if not explicitly specified */
+
+		int imageWidth = 1920;
+		int imageHeight = 1080;
+		int blankLeft = 0;
+		int blankRight = 0;
+		int blankTop = 0;
+		int blankBottom = 0;
+
+		double chipWidth = 9.6;
+		double chipHeight = 5.4;
+		double fakeChipWidth = 9.6;
+		double fakeChipHeight = 5.4;
+
+	};
+
+	/**
+	* Camera parameters together with their arrival time on this host.
+	*/
+	struct TrkCameraSample_t {
+		TrkCameraParams_t params;
+		int64_t arrivalTimeNs = 0; /* std::chrono::steady_clock, nanoseconds */
+	};
+
+	enum TrkWakeupMode_t {
+		TRK_WAKEUP_EVENT, /* block on socket readiness and signal the consumer */
+		TRK_WAKEUP_POLL   /* legacy fixed-interval sleep loops */
+	};
+
+	/* What the receiver does when the sample queue is full */
+	enum TrkOverflowPolicy_t {
+		TRK_OVERFLOW_DROP_OLDEST, /* evict the oldest queued sample */
+		TRK_OVERFLOW_KEEP_LATEST, /* evict everything queued, keep the new sample */
+		TRK_OVERFLOW_BLOCK        /* wait for the consumer, the socket buffers meanwhile */
+	};
+
+	/* How samples are handed from the receiver to the consumer */
+	enum TrkQueueMode_t {
+		TRK_QUEUE_FIFO,       /* every sample is queued, see TrkOverflowPolicy_t */
+		TRK_QUEUE_LATEST_ONLY /* only the newest sample is kept, for live compositing */
+	};
+
+	/* Which thread receives the datagrams */
+	enum TrkReceiverThreading_t {
+		TRK_RECEIVER_SHARED,   /* one process-wide thread for all ports, Linux only */
+		TRK_RECEIVER_DEDICATED /* one thread per CameraTrackingInterface */
+	};
+
+	/* How datagrams are read from the socket */
+	enum TrkReceiveBackend_t {
+		TRK_BACKEND_AUTO,     /* best available backend for the platform */
+		TRK_BACKEND_FSOCKET,  /* engine sockets, one call per datagram */
+		TRK_BACKEND_RECVMMSG, /* Linux only, one call per batch of datagrams */
+		TRK_BACKEND_IO_URING, /* Linux >= 6.0 only, no call per datagram */
+		TRK_BACKEND_REPLAY    /* datagrams of TrkTrackingOptions_t::replayFile instead of the network */
+	};
+
+	/* Where the arrival time of a datagram comes from */
+	enum TrkTimestampSource_t {
+		TRK_TIMESTAMP_KERNEL,   /* network stack receive time (SO_TIMESTAMPNS) if the backend supports it */
+		TRK_TIMESTAMP_USERSPACE /* time the receiver thread read the datagram */
+	};
+
+	/* What happens to samples whose tracker counter is out of sequence */
+	enum TrkSequencePolicy_t {
+		TRK_SEQUENCE_COUNT_ONLY, /* every sample is passed on, anomalies are only counted */
+		TRK_SEQUENCE_DROP_LATE,  /* duplicates and samples older than the newest one are dropped */
+		TRK_SEQUENCE_REORDER     /* up to reorderWindow samples are held back to restore counter order */
+	};
+
+	/* Scheduling priority of a tracking thread */
+	enum TrkThreadPriority_t {
+		TRK_THREAD_PRIORITY_DEFAULT,      /* as created by the process */
+		TRK_THREAD_PRIORITY_HIGH,         /* lowest real-time priority (SCHED_RR), THREAD_PRIORITY_HIGHEST on Windows */
+		TRK_THREAD_PRIORITY_TIME_CRITICAL /* SCHED_FIFO below the kernel interrupt threads, THREAD_PRIORITY_TIME_CRITICAL on Windows */
+	};
+
+	/* How the pose is extrapolated to make up for the tracking latency */
+	enum TrkPredictionModel_t {
+		TRK_PREDICTION_NONE,                  /* the measured pose is pushed */
+		TRK_PREDICTION_CONSTANT_VELOCITY,     /* from the last two samples */
+		TRK_PREDICTION_CONSTANT_ACCELERATION, /* from the last three samples */
+		TRK_PREDICTION_KALMAN                 /* constant velocity Kalman filter, smooths the measurement noise */
+	};
+
+	/**
+	* Pose prediction of LiveLinkCameraSource, see PosePredictor.
+	*/
+	struct TrkPredictionSettings_t {
+		TrkPredictionModel_t model = TRK_PREDICTION_NONE;
+		double leadTimeMs = 0.0;    /* predicted ahead of the arrival, in addition to the time a sample waited for the push */
+		double kalmanAgility = 1.0; /* scales the camera accelerations the Kalman filter expects, lower smooths more */
+	};
+
+	/* Pose and lens values that are filtered and predicted one by one */
+	enum TrkPoseChannel_t {
+		TRK_CHANNEL_POSITION_X,     /* cm */
+		TRK_CHANNEL_POSITION_Y,
+		TRK_CHANNEL_POSITION_Z,
+		TRK_CHANNEL_PITCH,          /* degrees */
+		TRK_CHANNEL_YAW,
+		TRK_CHANNEL_ROLL,
+		TRK_CHANNEL_FOCAL_LENGTH,   /* mm */
+		TRK_CHANNEL_FOCUS_DISTANCE, /* cm */
+		TRK_POSE_CHANNELS
+	};
+
+	/**
+	* One Euro filter of one channel: the cutoff frequency rises from
+	* minCutoffHz by beta per unit of speed, so a still camera is smoothed
+	* and a moving one follows with little lag.
+	*/
+	struct TrkFilterChannel_t {
+		double minCutoffHz; /* jitter of a still camera, lower smooths more; 0 = not filtered */
+		double beta;        /* per unit/s, higher lags less when moving */
+	};
+
+	/**
+	* Jitter filter of LiveLinkCameraSource, see JitterFilter.
+	*/
+	struct TrkJitterFilterSettings_t {
+		bool enabled = false;
+		TrkFilterChannel_t channels[TRK_POSE_CHANNELS] = {
+			{ 1.0, 0.5 }, { 1.0, 0.5 }, { 1.0, 0.5 },
+			{ 1.0, 1.0 }, { 1.0, 1.0 }, { 1.0, 1.0 },
+			{ 1.0, 2.0 },
+			{ 1.0, 0.2 }
+		};
+		double derivativeCutoffHz = 1.0; /* smoothing of the speed that drives the cutoff */
+	};
+
+	/* Unit of TrkDelaySettings_t::amount */
+	enum TrkDelayUnit_t {
+		TRK_DELAY_MICROSECONDS,
+		TRK_DELAY_FRAMES, /* video frames at the frame rate of the source */
+		TRK_DELAY_FIELDS  /* half frames of interlaced video */
+	};
+
+	/**
+	* Delay line of LiveLinkCameraSource, see DelayLine. Holds the tracking
+	* back to match video that arrives later.
+	*/
+	struct TrkDelaySettings_t {
+		double amount = 0.0;
+		TrkDelayUnit_t unit = TRK_DELAY_MICROSECONDS;
+		size_t capacity = 512; /* samples kept per camera, limits the delay to capacity tracker periods */
+
+		// Delay in nanoseconds at the given video frame rate.
+		int64_t delay_ns(double frames_per_second) const {
+			if (amount <= 0.0) {
+				return 0;
+			}
+			switch (unit) {
+			case TRK_DELAY_FRAMES:
+				return frames_per_second > 0.0 ? (int64_t)(amount * 1e9 / frames_per_second) : 0;
+			case TRK_DELAY_FIELDS:
+				return frames_per_second > 0.0 ? (int64_t)(amount * 0.5e9 / frames_per_second) : 0;
+			default:
+				return (int64_t)(amount * 1e3);
+			}
+		}
+	};
+
+	/**
+	* Scheduling of a tracking thread. Real-time priorities need CAP_SYS_NICE
+	* or an rtprio limit on Linux; settings that cannot be applied are logged
+	* and the thread keeps the defaults.
+	*/
+	struct TrkThreadSettings_t {
+		TrkThreadPriority_t priority = TRK_THREAD_PRIORITY_DEFAULT;
+		uint64_t affinityMask = 0; /* bit N allows CPU N, 0 = any CPU */
+
+		bool is_default() const { return priority == TRK_THREAD_PRIORITY_DEFAULT && affinityMask == 0; }
+		bool operator==(const TrkThreadSettings_t& other) const { return priority == other.priority && affinityMask == other.affinityMask; }
+		bool operator!=(const TrkThreadSettings_t& other) const { return !(*this == other); }
+	};
+
+	/**
+	* Receive path configuration, passed to start_camera_tracking().
+	*/
+	struct TrkTrackingOptions_t {
+		TrkWakeupMode_t wakeupMode = TRK_WAKEUP_EVENT;
+		TrkQueueMode_t queueMode = TRK_QUEUE_FIFO;
+		size_t queueDepth = 64; /* max. number of queued samples */
+		TrkOverflowPolicy_t overflowPolicy = TRK_OVERFLOW_DROP_OLDEST;
+		TrkReceiveBackend_t receiveBackend = TRK_BACKEND_AUTO;
+		size_t receiveBatchSize = 32; /* max. datagrams per receive call */
+		TrkReceiverThreading_t receiverThreading = TRK_RECEIVER_SHARED;
+		TrkTimestampSource_t timestampSource = TRK_TIMESTAMP_KERNEL;
+		TrkSequencePolicy_t sequencePolicy = TRK_SEQUENCE_COUNT_ONLY;
+		size_t reorderWindow = 2; /* max. held samples in TRK_SEQUENCE_REORDER mode, at most 32 */
+		std::string captureFile; /* raw datagrams are recorded to this file if not empty */
+		std::string replayFile;  /* capture read by TRK_BACKEND_REPLAY */
+		double replaySpeed = 1.0; /* 1 = recorded timing, N = N times faster, 0 = as fast as possible */
+		bool replayLoop = false; /* start over at the end of the capture */
+		std::string multicastGroup;     /* IPv4 group joined on the port, unicast only if empty */
+		std::string multicastSource;    /* source-specific multicast: only datagrams of this IPv4 sender */
+		std::string multicastInterface; /* IPv4 address or name of the interface to join on, default by route */
+		int receiveBufferSize = 0;    /* SO_RCVBUF in bytes, 0 = system default */
+		int busyPollMicroseconds = 0; /* SO_BUSY_POLL, Linux only, 0 = off */
+		TrkThreadSettings_t receiverThread; /* anything but the default gives the source a dedicated receiver thread */
+		TrkThreadSettings_t pushThread;     /* LiveLink push thread of TRK_WAKEUP_POLL mode, other modes push on the receiver thread */
+		bool demultiplexCameras = false; /* samples are told apart by camera id (one LiveLink subject each) instead of one camera per port */
+		std::string bindAddress;        /* local IPv4 address (one NIC) the port is bound to, any if empty; unused with a multicast group */
+		uint16_t backupPort = 0;        /* second receive path of the same stream, merged by tracker counter; 0 = no backup path */
+		std::string backupBindAddress;  /* bindAddress of the backup path */
+		std::string backupMulticastInterface; /* interface the backup path joins multicastGroup on, multicastInterface if empty */
+		TrkJitterFilterSettings_t jitterFilter; /* applied to the converted frames by LiveLinkCameraSource, before the prediction */
+		TrkPredictionSettings_t prediction; /* applied to the converted frames by LiveLinkCameraSource */
+		TrkDelaySettings_t delay; /* applied to the predicted frames by LiveLinkCameraSource, can be changed while running */
+	};
+
+	/**
+	* Sample queue counters since start_camera_tracking().
+	*/
+	struct TrkQueueStatistics_t {
+		uint64_t queuedSamples = 0;
+		uint64_t droppedSamples = 0; /* evicted by DROP_OLDEST or KEEP_LATEST, or of a camera beyond MAX_CAMERAS_PER_PORT */
+		uint64_t blockedPushes = 0;  /* pushes that had to wait in BLOCK mode */
+		uint64_t supersededSamples = 0; /* replaced before being read in LATEST_ONLY mode */
+		size_t queueDepth = 0;       /* current number of queued samples */
+		size_t maxQueueDepth = 0;    /* high-water mark */
+	};
+
+	/**
+	* Arrivals on one receive path since start_camera_tracking(). A sample
+	* that came on both paths counts as first arrival on the faster one and
+	* as duplicate on the other.
+	*/
+	struct TrkPathStatistics_t {
+		uint64_t datagrams = 0;
+		uint64_t firstArrivals = 0; /* samples this path delivered first */
+		uint64_t duplicates = 0;    /* samples the other path delivered first */
+		int64_t leadNs = 0;         /* sum of the time by which this path's first arrivals beat their duplicates */
+		int64_t lastArrivalNs = 0;  /* steady clock, 0 if nothing arrived yet */
+	};
+
+	/**
+	* Tracker counter checks since start_camera_tracking().
+	*/
+	struct TrkSequenceStatistics_t {
+		uint64_t samples = 0;    /* samples checked */
+		uint64_t missing = 0;    /* skipped counters that did not arrive (yet) */
+		uint64_t duplicates = 0; /* counter seen before */
+		uint64_t late = 0;       /* arrived after a sample with a higher counter */
+		uint64_t reordered = 0;  /* late samples put back into order in TRK_SEQUENCE_REORDER mode */
+		uint64_t rejected = 0;   /* samples not passed on */
+		uint64_t wraps = 0;      /* counter overflows */
+		uint64_t resyncs = 0;    /* jumps back, e.g. a tracker restart, the check started over from */
+	};
+}
\ No newline at end of file
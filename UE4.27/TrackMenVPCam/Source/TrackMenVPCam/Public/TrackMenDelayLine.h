@@ -0,0 +1,67 @@
+/* Copyright 2021 TrackMen GmbH <mail@trackmen.de> */
+
+#pragma once
+
+#include "TrackMenCameraConversion.h"
+#include "TrackMenCameraTrackingTypes.h"
+
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace TrackMen {
+
+	/**
+	* The recent frames of one camera by time, to read the pose of a moment in
+	* the past.
+	*
+	* The ring is allocated by the constructor and overwrites its oldest frame
+	* when full. Frames are pushed in time order; a lookup walks from the
+	* frame of the previous lookup, so reading at a time that moves forward
+	* along with the pushes takes constant time, whatever the delay. A changed
+	* delay costs one walk over the frames in between.
+	*
+	* Pose and lens channels are interpolated between the two frames around
+	* the requested time, angles along the shorter way; the other lens values
+	* and the counter are those of the earlier frame.
+	*
+	* Not thread safe, LiveLinkCameraSource keeps one per camera.
+	*/
+	class DelayLine {
+	public:
+		// A frame this much older than the newest one starts the line over.
+		static const int64_t MAX_BACKWARDS_NS = 1000000000;
+
+		explicit DelayLine(size_t capacity = TrkDelaySettings_t().capacity);
+
+		void reset();
+
+		// Adds the frame of the sample with the given tracker counter and
+		// time. A time before the newest frame counts as the time of the
+		// newest frame.
+		void push(const TrkCameraFrame_t& frame, uint32_t counter, int64_t time_ns);
+
+		// Frame at time_ns. Before the oldest frame that is the oldest frame,
+		// after the newest one the newest frame. Returns false if the line is
+		// empty, or full and time_ns older than all of it, i.e. the delay
+		// exceeds the capacity.
+		bool sample_at(int64_t time_ns, TrkCameraFrame_t& frame, uint32_t& counter);
+
+		size_t size() const { return (size_t)(m_pushed - m_oldest); }
+		size_t capacity() const { return m_entries.size(); }
+
+	private:
+		struct Entry {
+			int64_t time_ns;
+			uint32_t counter;
+			TrkCameraFrame_t frame;
+		};
+
+		const Entry& entry(uint64_t sequence) const { return m_entries[(size_t)(sequence % m_entries.size())]; }
+
+		std::vector<Entry> m_entries;
+		uint64_t m_pushed = 0; /* sequence number of the next push */
+		uint64_t m_oldest = 0; /* sequence number of the oldest frame */
+		uint64_t m_cursor = 0; /* frame at or before the time of the last lookup */
+	};
+}
@@ -0,0 +1,75 @@
+/* Copyright 2021 TrackMen GmbH <mail@trackmen.de> */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace TrackMen {
+
+	/**
+	* Merges the copies of one camera's samples that arrive on redundant
+	* receive paths: the first copy of a tracker counter is passed on, the
+	* later ones are dropped.
+	*
+	* Counters are compared modulo 2^32 within the last 64 counters, like in
+	* SequenceTracker. A copy that is older than that window is dropped too,
+	* unless it is far older (a restarted tracker) or nothing new arrived on
+	* any path for a while, then the filter starts over. A path that lags
+	* behind delivers its copies in bursts, which alone must not restart it.
+	*
+	* A tracker whose counter does not advance cannot be merged by counter.
+	* As soon as one path brings the same counter twice in a row, samples are
+	* merged by arrival time instead: a copy that arrives within half a
+	* sample period of the last passed sample is dropped. Counter merging
+	* resumes with the first sample whose counter changed.
+	*
+	* Called by the receiver thread only.
+	*/
+	class DuplicateFilter {
+	public:
+		static const uint32_t WINDOW = 64;
+
+		// Rejected copies restart the filter after this time without a first
+		// arrival, if there were SequenceTracker::RESYNC_AFTER_REJECTS of them.
+		static const int64_t RESYNC_AFTER_NS = 10000000;
+
+		// Receive paths told apart, CameraTrackingInterface::MAX_RECEIVE_PATHS.
+		static const size_t MAX_PATHS = 2;
+
+		DuplicateFilter() { reset(); }
+
+		void reset();
+
+		// Returns true for the first copy of counter, which arrived on path at
+		// arrival_ns. For a later copy it returns false and reports the path
+		// and arrival time of the first one.
+		bool first_arrival(uint32_t counter, size_t path, int64_t arrival_ns, size_t& first_path, int64_t& first_arrival_ns);
+
+	private:
+		void start(uint32_t counter);
+		void remember(uint32_t counter, size_t path, int64_t arrival_ns);
+		bool first_arrival_by_time(uint32_t counter, size_t path, int64_t arrival_ns, size_t& first_path, int64_t& first_arrival_ns);
+
+		bool m_started = false;
+		uint32_t m_highest = 0;
+		uint64_t m_history = 0; /* bit i: counter m_highest - i was seen */
+		uint32_t m_rejected_in_row = 0;
+		int64_t m_last_first_arrival_ns = 0;
+		size_t m_last_first_path = 0;
+
+		// Last sample of every path, to notice a counter that stands still,
+		// and the sample period seen on the paths.
+		struct PathState {
+			bool seen;
+			uint32_t counter;
+			int64_t arrival_ns;
+		};
+		PathState m_path_states[MAX_PATHS];
+		int64_t m_period_ns = 0;
+
+		// First copy of counter c is at index c % WINDOW.
+		uint8_t m_first_path[WINDOW];
+		int64_t m_first_arrival_ns[WINDOW];
+	};
+}
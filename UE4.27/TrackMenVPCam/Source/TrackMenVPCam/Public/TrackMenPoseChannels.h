@@ -0,0 +1,69 @@
+/* Copyright 2021 TrackMen GmbH <mail@trackmen.de> */
+
+#pragma once
+
+#include "TrackMenCameraConversion.h"
+#include "TrackMenCameraTrackingTypes.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace TrackMen {
+
+	/**
+	* Copies pose and lens of a converted frame into one value per
+	* TrkPoseChannel_t, as the per channel stages (JitterFilter,
+	* PosePredictor) work on them.
+	*/
+	void frame_to_channels(const TrkCameraFrame_t& frame, double* channels);
+
+	/**
+	* Writes channel values back to the frame. Angles are wrapped to
+	* [-180, 180], a focal length that is not positive keeps the value of the
+	* frame and a negative focus distance becomes 0.
+	*/
+	void channels_to_frame(const double* channels, TrkCameraFrame_t& frame);
+
+	// Pitch, yaw and roll.
+	inline bool is_angle_channel(size_t channel) {
+		return channel >= TRK_CHANNEL_PITCH && channel <= TRK_CHANNEL_ROLL;
+	}
+
+	// Angle moved by less than half a turn from reference, so a pan through
+	// 180 degrees is no jump.
+	double unwrap_angle(double angle, double reference);
+
+	// Per second, a faster move is a cut (a jump in a recording, a re-homed
+	// tracker) rather than camera motion. 0 = no limit: lenses may jump, e.g.
+	// a focus snapping to infinity.
+	double channel_max_speed(size_t channel);
+
+	/**
+	* Time base of the per channel stages: the time between two samples is
+	* their counter step times the tracker period, learned from the arrival
+	* times, so network jitter does not turn into velocity noise.
+	*/
+	class SampleClock {
+	public:
+		static const int64_t MAX_GAP_NS = 250000000;
+
+		void reset() {
+			m_started = false;
+			m_period_ns = 0;
+		}
+
+		// Seconds since the previous sample, or a negative value if the stage
+		// has to start over: on the first sample, after a gap of more than
+		// MAX_GAP_NS and when time or the counter go back.
+		double advance(uint32_t counter, int64_t arrival_ns);
+
+		// Learned tracker period, 0 before the second sample.
+		int64_t period_ns() const { return m_period_ns; }
+
+	private:
+		bool m_started = false;
+		uint32_t m_counter = 0;
+		int64_t m_arrival_ns = 0;
+		int64_t m_period_ns = 0;
+	};
+}
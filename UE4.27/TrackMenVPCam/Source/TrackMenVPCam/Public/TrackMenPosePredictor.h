@@ -0,0 +1,72 @@
+/* Copyright 2021 TrackMen GmbH <mail@trackmen.de> */
+
+#pragma once
+
+#include "TrackMenCameraConversion.h"
+#include "TrackMenCameraTrackingTypes.h"
+#include "TrackMenPoseChannels.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace TrackMen {
+
+	/**
+	* Extrapolates the converted frames of one camera to make up for the time
+	* between the tracker measurement and the rendered frame.
+	*
+	* Position, pitch, yaw, roll, focal length and focus distance are predicted
+	* as independent channels (TrkPoseChannel_t). Angles are unwrapped, so
+	* panning through 180 degrees is no jump; close to a pitch of +-90 degrees
+	* Euler angles predict poorly, which tracked cameras rarely reach.
+	*
+	* Time steps come from a SampleClock. A move faster than a camera can go
+	* or a gap in the data starts the prediction over.
+	*
+	* Not thread safe, LiveLinkCameraSource keeps one per camera.
+	*/
+	class PosePredictor {
+	public:
+		static const size_t CHANNELS = TRK_POSE_CHANNELS;
+
+		PosePredictor() { configure(TrkPredictionSettings_t()); }
+
+		// Sets the model and starts over.
+		void configure(const TrkPredictionSettings_t& settings);
+		void reset();
+
+		// Feeds the measured frame of the sample with the given tracker
+		// counter and arrival time.
+		void update(const TrkCameraFrame_t& frame, uint32_t counter, int64_t arrival_ns);
+
+		// Replaces pose and lens of frame by their prediction horizon_ns after
+		// the sample of the last update(). Leaves frame as it is without a
+		// model or while the model lacks samples; the Kalman filter returns
+		// its smoothed estimate at a horizon of 0.
+		void extrapolate(TrkCameraFrame_t& frame, int64_t horizon_ns) const;
+
+		// Tracker period learned from the arrival times, 0 before the second
+		// sample.
+		int64_t period_ns() const { return m_clock.period_ns(); }
+
+	private:
+		void start(const double* measured);
+		void update_kalman(const double* measured, double dt);
+
+		TrkPredictionSettings_t m_settings;
+		SampleClock m_clock;
+		size_t m_samples = 0; /* since the start, counted up to 3 */
+		double m_dt = 0.0; /* seconds between the last two samples */
+
+		// Per channel, angles unwrapped. m_value is the last measurement, or
+		// the estimate of the Kalman filter.
+		double m_value[CHANNELS];
+		double m_velocity[CHANNELS];
+		double m_acceleration[CHANNELS];
+
+		// Kalman covariance of value and velocity.
+		double m_p00[CHANNELS];
+		double m_p01[CHANNELS];
+		double m_p11[CHANNELS];
+	};
+}
@@ -0,0 +1,131 @@
+/* Copyright 2021 TrackMen GmbH <mail@trackmen.de> */
+
+#pragma once
+
+#include "TrackMenCameraTrackingTypes.h"
+
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace TrackMen {
+
+	static const size_t TRK_MAX_DATAGRAM_SIZE = 4096;
+
+	/**
+	* Converts wall clock receive timestamps of the network stack to the
+	* steady clock of the receive path. Captures the offset between the two
+	* clocks once, so one conversion per receive call is enough.
+	*/
+	class RealtimeToSteadyClock {
+	public:
+		RealtimeToSteadyClock()
+			: m_steady_now_ns(steady_time_ns())
+			, m_offset_ns(m_steady_now_ns - std::chrono::duration_cast<std::chrono::nanoseconds>(
+				std::chrono::system_clock::now().time_since_epoch()).count()) {
+		}
+
+		int64_t steady_now_ns() const { return m_steady_now_ns; }
+
+		// A stamp from the future, after the wall clock was stepped back,
+		// is clamped to now.
+		int64_t to_steady_ns(int64_t realtime_ns) const {
+			const int64_t steady_ns = realtime_ns + m_offset_ns;
+			return steady_ns < m_steady_now_ns ? steady_ns : m_steady_now_ns;
+		}
+
+	private:
+		int64_t m_steady_now_ns;
+		int64_t m_offset_ns;
+	};
+
+	/**
+	* Preallocated storage for the datagrams returned by one receive call.
+	*/
+	class DatagramBatch {
+	public:
+		explicit DatagramBatch(size_t capacity)
+			: m_capacity(capacity > 0 ? capacity : 1)
+			, m_buffers(m_capacity * TRK_MAX_DATAGRAM_SIZE)
+			, m_lengths(m_capacity, 0)
+			, m_arrival_times_ns(m_capacity, 0) {
+		}
+
+		size_t capacity() const { return m_capacity; }
+		size_t size() const { return m_size; }
+
+		uint8_t* data(size_t index) { return &m_buffers[index * TRK_MAX_DATAGRAM_SIZE]; }
+		const uint8_t* data(size_t index) const { return &m_buffers[index * TRK_MAX_DATAGRAM_SIZE]; }
+		int32_t length(size_t index) const { return m_lengths[index]; }
+		int64_t arrival_time_ns(size_t index) const { return m_arrival_times_ns[index]; }
+
+		// Used by the backends to fill the batch.
+		void clear() { m_size = 0; }
+		void set(size_t index, int32_t length, int64_t arrival_time_ns) {
+			m_lengths[index] = length;
+			m_arrival_times_ns[index] = arrival_time_ns;
+		}
+		void set_size(size_t size) { m_size = size; }
+
+	private:
+		size_t m_capacity;
+		size_t m_size = 0;
+		std::vector<uint8_t> m_buffers;
+		std::vector<int32_t> m_lengths;
+		std::vector<int64_t> m_arrival_times_ns;
+	};
+
+	/**
+	* A way of receiving tracking datagrams on one UDP port.
+	*/
+	class ReceiveBackend {
+	public:
+		virtual ~ReceiveBackend() {}
+
+		virtual const char* name() const = 0;
+
+		// Binds the port. Returns false if the socket could not be created.
+		virtual bool open(uint16_t port, const TrkTrackingOptions_t& options) = 0;
+		virtual void close() = 0;
+
+		// File descriptor that becomes readable when receive() has data, for
+		// the shared ReceiverService. -1 if the backend cannot be watched.
+		virtual int native_handle() const { return -1; }
+
+		// True if the arrival times come from the network stack rather than
+		// from the time receive() was called. Valid after open().
+		virtual bool kernel_timestamps() const { return false; }
+
+		// Blocks until a datagram is available, the timeout expired or
+		// interrupt() was called.
+		virtual bool wait(std::chrono::microseconds timeout) = 0;
+
+		// Ends a blocked wait() and makes every later one return false right
+		// away, so the receiver thread can be joined without waiting for the
+		// timeout. Called from another thread while open; cleared by open().
+		virtual void interrupt() = 0;
+
+		// Fills the batch with the datagrams that are available right now,
+		// without blocking. Returns the number of received datagrams.
+		virtual size_t receive(DatagramBatch& batch) = 0;
+	};
+
+	// Engine socket subsystem, one Recv per datagram. Available everywhere.
+	std::unique_ptr<ReceiveBackend> create_fsocket_receive_backend();
+
+	// Native socket, up to a whole batch per recvmmsg() call, kernel receive
+	// timestamps. Returns nullptr on platforms other than Linux.
+	std::unique_ptr<ReceiveBackend> create_recvmmsg_receive_backend();
+
+	// Native socket with a multishot receive request on an io_uring, datagrams
+	// land in a provided buffer ring. Returns nullptr if the toolchain does not
+	// know io_uring; open() fails if the running kernel does not support it.
+	std::unique_ptr<ReceiveBackend> create_io_uring_receive_backend();
+
+	// Datagrams of a capture file (see CaptureRecorder) with their recorded
+	// timing, scaled by TrkTrackingOptions_t::replaySpeed. The port is
+	// ignored. open() fails if the file is not a capture.
+	std::unique_ptr<ReceiveBackend> create_replay_receive_backend();
+}
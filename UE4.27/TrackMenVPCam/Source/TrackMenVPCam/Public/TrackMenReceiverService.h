@@ -0,0 +1,61 @@
+/* Copyright 2021 TrackMen GmbH <mail@trackmen.de> */
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace TrackMen {
+
+	/**
+	* Process-wide receiver thread shared by all tracking interfaces.
+	*
+	* Clients register a readable native handle (a socket or an io_uring) and
+	* get on_readable() called on the service thread whenever it has data. All
+	* handles are watched by one epoll set, so the number of threads and
+	* wake-ups does not grow with the number of cameras. The thread is started
+	* with the first client and stopped with the last one.
+	*
+	* Only available on Linux; add() fails elsewhere and the tracking interface
+	* keeps its own receiver thread.
+	*/
+	class ReceiverService {
+	public:
+		class Client {
+		public:
+			virtual ~Client() {}
+
+			// Called on the service thread, never concurrently for one client.
+			virtual void on_readable() = 0;
+		};
+
+		static ReceiverService& get();
+		static bool is_supported();
+
+		~ReceiverService();
+
+		// Starts watching handle for client. Returns false if the handle cannot
+		// be watched.
+		bool add(int handle, Client* client);
+
+		// Stops watching the handle of client. When this returns, on_readable()
+		// is not running and will not be called for client anymore. Must not be
+		// called from on_readable().
+		void remove(Client* client);
+
+		size_t client_count();
+
+	private:
+		ReceiverService();
+		ReceiverService(const ReceiverService&) = delete;
+		ReceiverService& operator=(const ReceiverService&) = delete;
+
+		struct Impl;
+		std::unique_ptr<Impl> m_impl;
+
+		// Serializes add() and remove(), which may start or stop the thread.
+		std::mutex m_registration_mutex;
+	};
+}
@@ -0,0 +1,20 @@
+/* Copyright 2021 TrackMen GmbH <mail@trackmen.de> */
+
+#pragma once
+
+#include "TrackMenCameraTrackingTypes.h"
+
+#include <string>
+#include <thread>
+
+namespace TrackMen {
+
+	// Applies priority and CPU affinity to a running thread. Every part that
+	// can be applied is; returns false and logs a warning naming the thread
+	// if a part could not. The default priority and CPUs are restored too,
+	// for a thread whose settings change while it runs.
+	bool apply_thread_settings(std::thread& thread, const TrkThreadSettings_t& settings, const char* thread_name);
+
+	// "high, CPUs 0x3" style description for logs.
+	std::string describe_thread_settings(const TrkThreadSettings_t& settings);
+}
@@ -8,6 +8,8 @@
 #include "Widgets/Layout/SSeparator.h"
 #include "Widgets/Input/SNumericEntryBox.h"
 #include "Widgets/Input/SButton.h"
+#include "Widgets/Input/SCheckBox.h"
+#include "Widgets/Input/SEditableTextBox.h"
 
 #define LOCTEXT_NAMESPACE "TrackMenCameraSourceEditor"
 
@@ -48,6 +50,71 @@ void STrackMenCameraSourceEditor::Construct(const FArguments& Args)  {
 					.OnClicked(this, &STrackMenCameraSourceEditor::OnAddNewSourceClicked)
 				]
 			]
+			+ SVerticalBox::Slot()
+			.Padding(0.0f, 4.0f, 0.0f, 0.0f)
+			[
+				SNew(SHorizontalBox)
+				+ SHorizontalBox::Slot()
+				.HAlign(HAlign_Left)
+				.FillWidth(0.33f)
+				[
+					SNew(STextBlock)
+					.Text(LOCTEXT("Multicast Group", "Multicast Group"))
+				]
+				+ SHorizontalBox::Slot()
+				.HAlign(HAlign_Fill)
+				.FillWidth(0.67f)
+				[
+					SNew(SEditableTextBox)
+					.HintText(LOCTEXT("Multicast Group Hint", "Optional, e.g. 239.1.1.1"))
+					.OnTextChanged(this, &STrackMenCameraSourceEditor::OnMulticastGroupChanged)
+				]
+			]
+			+ SVerticalBox::Slot()
+			.Padding(0.0f, 4.0f, 0.0f, 0.0f)
+			[
+				SNew(SHorizontalBox)
+				+ SHorizontalBox::Slot()
+				.HAlign(HAlign_Left)
+				.FillWidth(0.33f)
+				[
+					SNew(STextBlock)
+					.Text(LOCTEXT("Backup Port", "Backup Port"))
+				]
+				+ SHorizontalBox::Slot()
+				.HAlign(HAlign_Fill)
+				.FillWidth(0.67f)
+				[
+					SNew(SNumericEntryBox<int>)
+					.ToolTipText(LOCTEXT("Backup Port Tooltip", "Optional second port the tracker sends the same stream to, e.g. over another network card. The first copy of every sample is used."))
+					.UndeterminedString(LOCTEXT("Backup Port Hint", "None"))
+					.MinValue(0)
+					.MaxValue(65535)
+					.Value(this, &STrackMenCameraSourceEditor::GetBackupPort)
+					.OnValueChanged(this, &STrackMenCameraSourceEditor::OnBackupPortChanged)
+				]
+			]
+			+ SVerticalBox::Slot()
+			.Padding(0.0f, 4.0f, 0.0f, 0.0f)
+			[
+				SNew(SHorizontalBox)
+				+ SHorizontalBox::Slot()
+				.HAlign(HAlign_Left)
+				.FillWidth(0.33f)
+				[
+					SNew(STextBlock)
+					.Text(LOCTEXT("Demultiplex", "Subject per Camera"))
+				]
+				+ SHorizontalBox::Slot()
+				.HAlign(HAlign_Left)
+				.FillWidth(0.67f)
+				[
+					SNew(SCheckBox)
+					.ToolTipText(LOCTEXT("Demultiplex Tooltip", "The port carries several cameras, each camera id gets a LiveLink subject of its own"))
+					.IsChecked(this, &STrackMenCameraSourceEditor::GetDemultiplexState)
+					.OnCheckStateChanged(this, &STrackMenCameraSourceEditor::OnDemultiplexChanged)
+				]
+			]
 		]
 	];
 }
@@ -62,6 +129,26 @@ void STrackMenCameraSourceEditor::OnPortChanged(const int InExampleInput) {
 	Port = InExampleInput;
 }
 
+void STrackMenCameraSourceEditor::OnMulticastGroupChanged(const FText& InText) {
+	MulticastGroup = InText.ToString();
+}
+
+TOptional<int> STrackMenCameraSourceEditor::GetBackupPort() const {
+	return BackupPort > 0 ? TOptional<int>(BackupPort) : TOptional<int>();
+}
+
+void STrackMenCameraSourceEditor::OnBackupPortChanged(const int InValue) {
+	BackupPort = InValue;
+}
+
+ECheckBoxState STrackMenCameraSourceEditor::GetDemultiplexState() const {
+	return Demultiplex ? ECheckBoxState::Checked : ECheckBoxState::Unchecked;
+}
+
+void STrackMenCameraSourceEditor::OnDemultiplexChanged(ECheckBoxState InState) {
+	Demultiplex = (InState == ECheckBoxState::Checked);
+}
+
 FReply STrackMenCameraSourceEditor::OnAddNewSourceClicked() const {
 	onAddNewSource.ExecuteIfBound();
 	return FReply::Handled();
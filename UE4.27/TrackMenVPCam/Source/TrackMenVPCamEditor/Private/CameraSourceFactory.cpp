@@ -4,6 +4,9 @@
 #include "CoreMinimal.h"
 #include "LiveLinkCameraSource.h"
 #include "EditorLogging.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include <cstdlib>
 #include <string>
 
 #define LOCTEXT_NAMESPACE "TrackMenCameraSourceFactory"
@@ -21,13 +24,252 @@ ULiveLinkSourceFactory::EMenuType UTrackMenCameraSourceFactory::GetMenuType() co
 }
 
 
+// Value of Key= in the connection string, empty if not present.
+static std::string ParseConnectionValue(const FString& ConnectionString, const TCHAR* Key) {
+	FString value;
+	return FParse::Value(*ConnectionString, Key, value) ? std::string(TCHAR_TO_UTF8(*value)) : std::string();
+}
+
+// True if Flag appears as a word of its own. FParse::Param would need a
+// leading dash.
+static bool HasConnectionFlag(const FString& ConnectionString, const TCHAR* Flag) {
+	TArray<FString> words;
+	ConnectionString.ParseIntoArrayWS(words);
+	return words.Contains(Flag);
+}
+
+// PriorityKey=High|TimeCritical and CpusKey=<mask, 0x for hex> of a tracking thread.
+static TrackMen::TrkThreadSettings_t ParseThreadSettings(const FString& ConnectionString, const TCHAR* PriorityKey, const TCHAR* CpusKey) {
+	TrackMen::TrkThreadSettings_t settings;
+	FString priority;
+	if (FParse::Value(*ConnectionString, PriorityKey, priority)) {
+		if (priority.Equals(TEXT("High"), ESearchCase::IgnoreCase)) {
+			settings.priority = TrackMen::TRK_THREAD_PRIORITY_HIGH;
+		}
+		else if (priority.Equals(TEXT("TimeCritical"), ESearchCase::IgnoreCase)) {
+			settings.priority = TrackMen::TRK_THREAD_PRIORITY_TIME_CRITICAL;
+		}
+	}
+	const std::string cpus = ParseConnectionValue(ConnectionString, CpusKey);
+	settings.affinityMask = cpus.empty() ? 0 : std::strtoull(cpus.c_str(), nullptr, 0);
+	return settings;
+}
+
+// Prediction=ConstantVelocity|ConstantAcceleration|Kalman LeadTime=<ms> KalmanAgility=<factor>
+static TrackMen::TrkPredictionSettings_t ParsePredictionSettings(const FString& ConnectionString) {
+	TrackMen::TrkPredictionSettings_t settings;
+	FString model;
+	if (FParse::Value(*ConnectionString, TEXT("Prediction="), model)) {
+		if (model.Equals(TEXT("ConstantVelocity"), ESearchCase::IgnoreCase)) {
+			settings.model = TrackMen::TRK_PREDICTION_CONSTANT_VELOCITY;
+		}
+		else if (model.Equals(TEXT("ConstantAcceleration"), ESearchCase::IgnoreCase)) {
+			settings.model = TrackMen::TRK_PREDICTION_CONSTANT_ACCELERATION;
+		}
+		else if (model.Equals(TEXT("Kalman"), ESearchCase::IgnoreCase)) {
+			settings.model = TrackMen::TRK_PREDICTION_KALMAN;
+		}
+	}
+	float leadTime = 0.0f;
+	float agility = 1.0f;
+	FParse::Value(*ConnectionString, TEXT("LeadTime="), leadTime);
+	FParse::Value(*ConnectionString, TEXT("KalmanAgility="), agility);
+	settings.leadTimeMs = FMath::Max(0.0f, leadTime);
+	settings.kalmanAgility = agility > 0.0f ? agility : 1.0f;
+	return settings;
+}
+
+// Smoothing, optionally tuned per channel with
+// Smooth<Channel>=<min. cutoff Hz, 0 = off> Smooth<Channel>Beta=<Hz per unit/s>
+// for the channels X, Y, Z, Pan, Tilt, Roll, Zoom and Focus. The group keys
+// SmoothPosition and SmoothRotation of older presets tune X, Y, Z and Pan,
+// Tilt, Roll at once; a channel key overrides them.
+static TrackMen::TrkJitterFilterSettings_t ParseJitterFilterSettings(const FString& ConnectionString) {
+	struct FChannelGroup {
+		const TCHAR* name;
+		TrackMen::TrkPoseChannel_t first;
+		TrackMen::TrkPoseChannel_t last;
+	};
+	static const FChannelGroup groups[] = {
+		{ TEXT("Position"), TrackMen::TRK_CHANNEL_POSITION_X, TrackMen::TRK_CHANNEL_POSITION_Z },
+		{ TEXT("Rotation"), TrackMen::TRK_CHANNEL_PITCH, TrackMen::TRK_CHANNEL_ROLL },
+		{ TEXT("X"), TrackMen::TRK_CHANNEL_POSITION_X, TrackMen::TRK_CHANNEL_POSITION_X },
+		{ TEXT("Y"), TrackMen::TRK_CHANNEL_POSITION_Y, TrackMen::TRK_CHANNEL_POSITION_Y },
+		{ TEXT("Z"), TrackMen::TRK_CHANNEL_POSITION_Z, TrackMen::TRK_CHANNEL_POSITION_Z },
+		{ TEXT("Tilt"), TrackMen::TRK_CHANNEL_PITCH, TrackMen::TRK_CHANNEL_PITCH },
+		{ TEXT("Pan"), TrackMen::TRK_CHANNEL_YAW, TrackMen::TRK_CHANNEL_YAW },
+		{ TEXT("Roll"), TrackMen::TRK_CHANNEL_ROLL, TrackMen::TRK_CHANNEL_ROLL },
+		{ TEXT("Zoom"), TrackMen::TRK_CHANNEL_FOCAL_LENGTH, TrackMen::TRK_CHANNEL_FOCAL_LENGTH },
+		{ TEXT("Focus"), TrackMen::TRK_CHANNEL_FOCUS_DISTANCE, TrackMen::TRK_CHANNEL_FOCUS_DISTANCE }
+	};
+
+	TrackMen::TrkJitterFilterSettings_t settings;
+	settings.enabled = HasConnectionFlag(ConnectionString, TEXT("Smoothing"));
+	for (const FChannelGroup& group : groups) {
+		for (int32 channel = group.first; channel <= group.last; ++channel) {
+			float cutoff = (float)settings.channels[channel].minCutoffHz;
+			float beta = (float)settings.channels[channel].beta;
+			FParse::Value(*ConnectionString, *FString::Printf(TEXT("Smooth%s="), group.name), cutoff);
+			FParse::Value(*ConnectionString, *FString::Printf(TEXT("Smooth%sBeta="), group.name), beta);
+			settings.channels[channel].minCutoffHz = FMath::Max(0.0f, cutoff);
+			settings.channels[channel].beta = FMath::Max(0.0f, beta);
+		}
+	}
+	return settings;
+}
+
+// Delay=<amount> DelayUnit=Microseconds|Frames|Fields DelayCapacity=<samples>
+static TrackMen::TrkDelaySettings_t ParseDelaySettings(const FString& ConnectionString) {
+	TrackMen::TrkDelaySettings_t settings;
+	float amount = 0.0f;
+	FParse::Value(*ConnectionString, TEXT("Delay="), amount);
+	settings.amount = FMath::Max(0.0f, amount);
+	FString unit;
+	if (FParse::Value(*ConnectionString, TEXT("DelayUnit="), unit)) {
+		if (unit.Equals(TEXT("Frames"), ESearchCase::IgnoreCase)) {
+			settings.unit = TrackMen::TRK_DELAY_FRAMES;
+		}
+		else if (unit.Equals(TEXT("Fields"), ESearchCase::IgnoreCase)) {
+			settings.unit = TrackMen::TRK_DELAY_FIELDS;
+		}
+	}
+	int32 capacity = (int32)settings.capacity;
+	FParse::Value(*ConnectionString, TEXT("DelayCapacity="), capacity);
+	settings.capacity = (size_t)FMath::Clamp(capacity, 2, 65536);
+	return settings;
+}
+
+// QueueDepth=<samples> QueueMode=Fifo|LatestOnly Overflow=DropOldest|KeepLatest|Block
+// Backend=Auto|FSocket|Recvmmsg|IoUring
+static void ParseQueueSettings(const FString& ConnectionString, TrackMen::TrkTrackingOptions_t& Options) {
+	int32 queueDepth = (int32)Options.queueDepth;
+	FParse::Value(*ConnectionString, TEXT("QueueDepth="), queueDepth);
+	Options.queueDepth = (size_t)FMath::Clamp(queueDepth, 1, 4096);
+	FString queueMode;
+	if (FParse::Value(*ConnectionString, TEXT("QueueMode="), queueMode)
+		&& queueMode.Equals(TEXT("LatestOnly"), ESearchCase::IgnoreCase)) {
+		Options.queueMode = TrackMen::TRK_QUEUE_LATEST_ONLY;
+	}
+	FString overflow;
+	if (FParse::Value(*ConnectionString, TEXT("Overflow="), overflow)) {
+		if (overflow.Equals(TEXT("KeepLatest"), ESearchCase::IgnoreCase)) {
+			Options.overflowPolicy = TrackMen::TRK_OVERFLOW_KEEP_LATEST;
+		}
+		else if (overflow.Equals(TEXT("Block"), ESearchCase::IgnoreCase)) {
+			Options.overflowPolicy = TrackMen::TRK_OVERFLOW_BLOCK;
+		}
+	}
+	FString backend;
+	if (FParse::Value(*ConnectionString, TEXT("Backend="), backend)) {
+		if (backend.Equals(TEXT("FSocket"), ESearchCase::IgnoreCase)) {
+			Options.receiveBackend = TrackMen::TRK_BACKEND_FSOCKET;
+		}
+		else if (backend.Equals(TEXT("Recvmmsg"), ESearchCase::IgnoreCase)) {
+			Options.receiveBackend = TrackMen::TRK_BACKEND_RECVMMSG;
+		}
+		else if (backend.Equals(TEXT("IoUring"), ESearchCase::IgnoreCase)) {
+			Options.receiveBackend = TrackMen::TRK_BACKEND_IO_URING;
+		}
+	}
+}
+
+// Sequence=CountOnly|DropLate|Reorder ReorderWindow=<samples>
+static void ParseSequenceSettings(const FString& ConnectionString, TrackMen::TrkTrackingOptions_t& Options) {
+	FString policy;
+	if (FParse::Value(*ConnectionString, TEXT("Sequence="), policy)) {
+		if (policy.Equals(TEXT("DropLate"), ESearchCase::IgnoreCase)) {
+			Options.sequencePolicy = TrackMen::TRK_SEQUENCE_DROP_LATE;
+		}
+		else if (policy.Equals(TEXT("Reorder"), ESearchCase::IgnoreCase)) {
+			Options.sequencePolicy = TrackMen::TRK_SEQUENCE_REORDER;
+		}
+	}
+	int32 window = (int32)Options.reorderWindow;
+	FParse::Value(*ConnectionString, TEXT("ReorderWindow="), window);
+	Options.reorderWindow = (size_t)FMath::Clamp(window, 1, 32);
+}
+
 TSharedPtr<ILiveLinkSource> UTrackMenCameraSourceFactory::CreateSource(const FString& ConnectionString) const {
 	UE_LOG(LogTrackMenEditor, Display, TEXT("Create new live link camera source: %s"), *ConnectionString);
 	TSharedPtr<TrackMen::LiveLinkCameraSource> NewSource = nullptr;
+
+	// "<port>" or "Port=<port>", optionally followed by
+	//   MulticastGroup=<IPv4> MulticastSource=<IPv4> MulticastInterface=<IPv4 or name>
+	// to receive a multicast stream, or by
+	//   Replay="<capture file>" Speed=<factor> Loop
+	// to play back a recorded capture instead of listening on the port, by
+	//   Capture="<capture file>"
+	// to record the received datagrams for a later replay, by
+	//   Demultiplex
+	// to give every camera id on the port a LiveLink subject of its own, and by
+	//   Bind=<IPv4> Backup=<port> BackupAddress=<IPv4> BackupInterface=<IPv4 or name>
+	// to receive the same stream a second time, e.g. over another network
+	// card, and use whichever copy of a sample arrives first.
+	// Smoothing of the encoder jitter, see ParseJitterFilterSettings():
+	//   Smoothing SmoothX=<Hz> SmoothXBeta=<Hz per cm/s> SmoothPan=<Hz> SmoothPanBeta=<Hz per degree/s> ...
+	// Latency compensation, extrapolating the pose LeadTime milliseconds
+	// ahead of the push:
+	//   Prediction=ConstantVelocity|ConstantAcceleration|Kalman LeadTime=<ms> KalmanAgility=<factor>
+	// Handling of samples whose tracker counter is out of sequence, by
+	// default they are only counted:
+	//   Sequence=CountOnly|DropLate|Reorder ReorderWindow=<samples>
+	// Delay to match video that arrives later than the tracking, the last
+	// DelayCapacity samples of every camera are kept:
+	//   Delay=<amount> DelayUnit=Microseconds|Frames|Fields DelayCapacity=<samples>
+	// Tuning against render thread load, all optional:
+	//   QueueDepth=<samples> Overflow=DropOldest|KeepLatest|Block Backend=Auto|FSocket|Recvmmsg|IoUring
+	//   QueueMode=Fifo|LatestOnly, LatestOnly keeps only the newest sample
+	//   ReceiveBuffer=<bytes> BusyPoll=<us>
+	//   ReceiverPriority=High|TimeCritical ReceiverCpus=<mask>
+	//   PushPriority=High|TimeCritical PushCpus=<mask>
+	TrackMen::TrkTrackingOptions_t options;
+	int32 port = FCString::Atoi(*ConnectionString);
+	FParse::Value(*ConnectionString, TEXT("Port="), port);
+
+	options.multicastGroup = ParseConnectionValue(ConnectionString, TEXT("MulticastGroup="));
+	options.multicastSource = ParseConnectionValue(ConnectionString, TEXT("MulticastSource="));
+	options.multicastInterface = ParseConnectionValue(ConnectionString, TEXT("MulticastInterface="));
+	ParseQueueSettings(ConnectionString, options);
+	ParseSequenceSettings(ConnectionString, options);
+	FParse::Value(*ConnectionString, TEXT("ReceiveBuffer="), options.receiveBufferSize);
+	FParse::Value(*ConnectionString, TEXT("BusyPoll="), options.busyPollMicroseconds);
+	options.receiverThread = ParseThreadSettings(ConnectionString, TEXT("ReceiverPriority="), TEXT("ReceiverCpus="));
+	options.pushThread = ParseThreadSettings(ConnectionString, TEXT("PushPriority="), TEXT("PushCpus="));
+	options.demultiplexCameras = HasConnectionFlag(ConnectionString, TEXT("Demultiplex"));
+	options.bindAddress = ParseConnectionValue(ConnectionString, TEXT("Bind="));
+	int32 backupPort = 0;
+	FParse::Value(*ConnectionString, TEXT("Backup="), backupPort);
+	options.backupPort = (uint16_t)FMath::Clamp(backupPort, 0, 65535);
+	options.backupBindAddress = ParseConnectionValue(ConnectionString, TEXT("BackupAddress="));
+	options.backupMulticastInterface = ParseConnectionValue(ConnectionString, TEXT("BackupInterface="));
+	options.jitterFilter = ParseJitterFilterSettings(ConnectionString);
+	options.prediction = ParsePredictionSettings(ConnectionString);
+	options.delay = ParseDelaySettings(ConnectionString);
+	options.captureFile = ParseConnectionValue(ConnectionString, TEXT("Capture="));
+	std::string ports = std::to_string(port);
+	if (options.backupPort != 0) {
+		ports += "+" + std::to_string(options.backupPort);
+	}
+	FText machineName = options.multicastGroup.empty()
+		? FText::FromString((std::string("UDP ") + ports).c_str())
+		: FText::FromString((std::string("UDP ") + options.multicastGroup + ":" + ports).c_str());
+
+	FString replayFile;
+	if (FParse::Value(*ConnectionString, TEXT("Replay="), replayFile)) {
+		float speed = 1.0f;
+		FParse::Value(*ConnectionString, TEXT("Speed="), speed);
+		options.receiveBackend = TrackMen::TRK_BACKEND_REPLAY;
+		options.replayFile = TCHAR_TO_UTF8(*replayFile);
+		options.replaySpeed = speed;
+		options.replayLoop = HasConnectionFlag(ConnectionString, TEXT("Loop"));
+		machineName = FText::FromString(TEXT("Replay ") + FPaths::GetCleanFilename(replayFile));
+	}
+
 	NewSource = MakeShared<TrackMen::LiveLinkCameraSource>(
 		FText::FromString("TrackMen Camera"),
-		FText::FromString((std::string("UDP ") + std::to_string(FCString::Atoi(*ConnectionString))).c_str()),
-		FCString::Atoi(*ConnectionString)
+		machineName,
+		(uint16_t)port,
+		options
 		);
 	return NewSource;
 }
@@ -44,15 +286,23 @@ TSharedPtr<SWidget> UTrackMenCameraSourceFactory::BuildCreationPanel(FOnLiveLink
 void UTrackMenCameraSourceFactory::OnPanelAddNewSource(FOnLiveLinkSourceCreated OnLiveLinkSourceCreated) const 
 {
 	//UE_LOG(LogTrackMenEditor, Display, TEXT("OnPanelAddNewSource"));
-	TSharedPtr<TrackMen::LiveLinkCameraSource> NewSource = nullptr;
-	if (ActiveSourceEditor.IsValid()) {
-		NewSource = MakeShared<TrackMen::LiveLinkCameraSource>(
-			FText::FromString("TrackMen Camera"),
-			FText::FromString(("UDP " + std::to_string(ActiveSourceEditor->Port)).c_str()),
-			ActiveSourceEditor->Port
-			);
-	}
-	OnLiveLinkSourceCreated.ExecuteIfBound(NewSource, FString::FromInt(ActiveSourceEditor->Port));
+	if (!ActiveSourceEditor.IsValid()) {
+		return;
+	}
+
+	// Same path as sources restored from presets.
+	FString connectionString = FString::FromInt(ActiveSourceEditor->Port);
+	const FString multicastGroup = ActiveSourceEditor->MulticastGroup.TrimStartAndEnd();
+	if (!multicastGroup.IsEmpty()) {
+		connectionString += TEXT(" MulticastGroup=") + multicastGroup;
+	}
+	if (ActiveSourceEditor->BackupPort > 0) {
+		connectionString += FString::Printf(TEXT(" Backup=%d"), ActiveSourceEditor->BackupPort);
+	}
+	if (ActiveSourceEditor->Demultiplex) {
+		connectionString += TEXT(" Demultiplex");
+	}
+	OnLiveLinkSourceCreated.ExecuteIfBound(CreateSource(connectionString), connectionString);
 }
 
 #undef LOCTEXT_NAMESPACE